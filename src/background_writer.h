@@ -0,0 +1,198 @@
+#ifndef BACKGROUND_WRITER_H
+#define BACKGROUND_WRITER_H
+
+// Keeps disk writes off the frame. The game hands over finished bytes (scores, ghosts,
+// replays) and a worker thread writes whatever has queued up as one batch, syncing each
+// touched file once per batch instead of once per write. Replacements go through a
+// temporary file and a rename, so a file is never seen half written.
+// The web build has no files: WriteStorageWhenIdle defers localStorage writes to an
+// idle callback instead.
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <io.h>
+#ifndef NOMINMAX
+#define NOMINMAX  // Keep std::min and std::max usable
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#endif
+
+#ifdef __EMSCRIPTEN__
+
+// Stores value under key once the browser is idle (setTimeout where requestIdleCallback is missing).
+// The value is copied into JS right away, so it may be freed after the call.
+inline void WriteStorageWhenIdle(const char* key, const char* value)
+{
+    EM_ASM({
+        var key = UTF8ToString($0);
+        var value = UTF8ToString($1);
+        var store = function() { localStorage.setItem(key, value); };
+        if (window.requestIdleCallback) requestIdleCallback(store, { timeout: 2000 });
+        else setTimeout(store, 0);
+    }, key, value);
+}
+
+#else
+
+enum {
+    WRITE_REPLACE,  // Whole file
+    WRITE_APPEND
+};
+
+struct WriteJob {
+    std::string path;
+    std::vector<uint8_t> bytes;
+    int mode;
+};
+
+struct BackgroundWriter {
+    std::vector<WriteJob> queue;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool quit;
+    bool running;
+};
+
+inline bool SyncFile(FILE* file)
+{
+    if (fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+inline bool WriteReplacement(const WriteJob& job)
+{
+    std::string temporary = job.path + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (!file) return false;
+
+    bool ok = fwrite(job.bytes.data(), 1, job.bytes.size(), file) == job.bytes.size() && SyncFile(file);
+    ok = fclose(file) == 0 && ok;
+    if (!ok) return false;
+
+#ifdef _WIN32
+    // rename refuses an existing target here, and removing it first would leave a gap
+    return MoveFileExA(temporary.c_str(), job.path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(temporary.c_str(), job.path.c_str()) == 0;
+#endif
+}
+
+// Runs of appends to one path share an open file and a single sync
+inline size_t AppendToFile(const std::vector<WriteJob>& batch, size_t first)
+{
+    const std::string& path = batch[first].path;
+    size_t end = first;
+    while (end < batch.size() && batch[end].mode == WRITE_APPEND && batch[end].path == path)
+        end++;
+
+    FILE* file = fopen(path.c_str(), "ab");
+    bool ok = file != nullptr;
+    for (size_t i = first; ok && i < end; i++)
+        ok = fwrite(batch[i].bytes.data(), 1, batch[i].bytes.size(), file) == batch[i].bytes.size();
+    if (file)
+    {
+        ok = SyncFile(file) && ok;
+        ok = fclose(file) == 0 && ok;
+    }
+    if (!ok) printf("Could not append to %s\n", path.c_str());
+    return end;
+}
+
+inline void WriteBatch(const std::vector<WriteJob>& batch)
+{
+    size_t i = 0;
+    while (i < batch.size())
+    {
+        if (batch[i].mode == WRITE_APPEND)
+        {
+            i = AppendToFile(batch, i);
+            continue;
+        }
+
+        // A later replacement of the same file makes this one pointless
+        bool superseded = false;
+        for (size_t j = i + 1; j < batch.size() && !superseded; j++)
+            superseded = batch[j].mode == WRITE_REPLACE && batch[j].path == batch[i].path;
+        if (!superseded && !WriteReplacement(batch[i]))
+            printf("Could not write %s\n", batch[i].path.c_str());
+        i++;
+    }
+}
+
+inline void BackgroundWriterWorker(BackgroundWriter* writer)
+{
+    std::vector<WriteJob> batch;
+    std::unique_lock<std::mutex> lock(writer->mutex);
+    while (true)
+    {
+        writer->wake.wait(lock, [writer] { return writer->quit || !writer->queue.empty(); });
+        if (writer->queue.empty()) break;  // Quit, with everything written
+
+        batch.swap(writer->queue);
+        lock.unlock();
+        WriteBatch(batch);
+        batch.clear();
+        lock.lock();
+    }
+}
+
+inline void StartBackgroundWriter(BackgroundWriter& writer)
+{
+    writer.quit = false;
+    writer.running = true;
+    writer.worker = std::thread(BackgroundWriterWorker, &writer);
+}
+
+// Takes the bytes, the caller's vector is left empty
+inline void QueueFileWrite(BackgroundWriter& writer, const char* path, std::vector<uint8_t>&& bytes, int mode)
+{
+    if (!writer.running)
+    {
+        // Before start or after stop: nothing else is running, write in place
+        std::vector<WriteJob> batch(1);
+        batch[0] = {path, std::move(bytes), mode};
+        WriteBatch(batch);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(writer.mutex);
+        writer.queue.push_back({path, std::move(bytes), mode});
+    }
+    writer.wake.notify_one();
+}
+
+// Writes out what is still queued, then stops the thread
+inline void StopBackgroundWriter(BackgroundWriter& writer)
+{
+    if (!writer.running) return;
+    {
+        std::lock_guard<std::mutex> lock(writer.mutex);
+        writer.quit = true;
+    }
+    writer.wake.notify_one();
+    writer.worker.join();
+    writer.running = false;
+}
+
+#endif
+
+#endif // BACKGROUND_WRITER_H
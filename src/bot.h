@@ -0,0 +1,273 @@
+#ifndef BOT_H
+#define BOT_H
+
+// Bots: players that produce the same StepInput a person does with the keyboard and mouse
+// (leave the nest, A/D to pick a side, hold SPACE to charge, click to kick the angle
+// square, release to launch), decided by a policy from the game state instead of SDL
+// events. Anything that steps a GameState can be driven by one, so load tests go through
+// the real simulation, replays, scores and leaderboard.
+//   BOT_POLICY_SCRIPTED  takes the solver's aim and misjudges it by the next error from
+//                        a list drawn per bot, like a player who knows the jump but not
+//                        the exact feel. It releases once the charge and the angle are
+//                        roughly where it meant them, without checking the result, so it
+//                        misses some jumps and still reaches the nest
+//   BOT_POLICY_SOLVER    plans each launch with the level solver's flight model and
+//                        releases only when the launch it would make lands higher up
+// Both steer the same way: click whenever the angle square would fall below the aimed
+// height, and release at the point within the step where the charge reaches the aim.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "simulation.h"
+#include "level_solver.h"
+
+#define BOT_REACTION_FRAMES 12   // Before acting on a catch, about a person's reaction time,
+#define BOT_REACTION_SPREAD 18   // plus up to this much, fixed per bot
+#define BOT_PATIENCE_FRAMES 600  // Then a solver bot takes any launch that climbs
+#define BOT_GIVE_UP_FRAMES 1200  // And past this, any launch at all
+#define BOT_SCRIPT_LENGTH 16
+#define BOT_SCRIPT_CHARGE_ERROR 0.05f  // Largest charge misjudgement of a scripted bot
+#define BOT_SCRIPT_ANGLE_ERROR 0.08f   // Largest angle misjudgement, 1 is a quarter turn
+#define BOT_SCRIPT_ANGLE_SLOP 0.03f    // How close to its aimed angle a scripted bot settles for
+#define BOT_SOLVER_CHARGES 12    // Planning grid, as in LevelSolverOptions
+#define BOT_SOLVER_ANGLES 8
+#define BOT_FLIGHT_FRAMES 240
+
+enum {
+    BOT_POLICY_SCRIPTED,
+    BOT_POLICY_SOLVER,
+    BOT_POLICY_COUNT
+};
+
+struct BotScriptStep {
+    float chargeError;  // Added to the planned charge
+    float angleError;   // Added to the planned angle, 0 flat to 1 straight up
+};
+
+struct BotAim {
+    float charge;
+    float angle;
+    bool faceRight;
+    int target;  // Node the launch should reach (see BotNodeOf), -1 if unknown
+};
+
+struct Bot {
+    int policy;
+    std::vector<BotScriptStep> script;
+    size_t scriptIndex;
+    bool planned;         // aim is for the squirrel holding the egg now
+    BotAim aim;
+    int holderNode;
+    uint32_t heldFrames;  // Since the catch
+    uint32_t reactionFrames;
+    std::vector<SimRect> rects;  // Squirrels as the solver sees them, in node order
+};
+
+inline const char* BotPolicyName(int policy)
+{
+    return policy == BOT_POLICY_SOLVER ? "solver" : "scripted";
+}
+
+// Policy from the command line, -1 if unknown
+inline int ParseBotPolicy(const char* name)
+{
+    for (int policy = 0; policy < BOT_POLICY_COUNT; policy++)
+    {
+        if (strcmp(name, BotPolicyName(policy)) == 0) return policy;
+    }
+    return -1;
+}
+
+// seed varies the script, so scripted bots on one level still play differently. Errors
+// are the sum of two uniform draws, small ones more often than large.
+inline void StartBot(Bot& bot, int policy, uint32_t seed)
+{
+    bot.policy = policy;
+    bot.script.resize(BOT_SCRIPT_LENGTH);
+    LevelRng rng = {seed};
+    for (BotScriptStep& step : bot.script)
+    {
+        step.chargeError = BOT_SCRIPT_CHARGE_ERROR * (LevelRngFloat(rng) - LevelRngFloat(rng));
+        step.angleError = BOT_SCRIPT_ANGLE_ERROR * (LevelRngFloat(rng) - LevelRngFloat(rng));
+    }
+    bot.reactionFrames = BOT_REACTION_FRAMES + LevelRngNext(rng) % (BOT_REACTION_SPREAD + 1);
+    bot.scriptIndex = 0;
+    bot.planned = false;
+    bot.heldFrames = 0;
+}
+
+// Node 0 is the floor squirrel, node i + 1 the i-th pooled squirrel, then the nest
+inline int BotNodeOf(const GameState& state, EntityHandle handle)
+{
+    if (handle == FLOOR_SQUIRREL_HANDLE || !PoolIsLive(state.squirrels, handle)) return 0;
+    return static_cast<int>(handle - PoolHandleAt(state.squirrels, 0)) + 1;
+}
+
+inline SimRect BotSquirrelRect(const GameObject& squirrel)
+{
+    SimRect rect = {
+        static_cast<int>(squirrel.x),
+        static_cast<int>(squirrel.y),
+        squirrel.spriteWidths[squirrel.currentSprite],
+        squirrel.spriteHeights[squirrel.currentSprite]
+    };
+    return rect;
+}
+
+inline void BotBuildNodes(Bot& bot, const GameState& state)
+{
+    int count = PoolCount(state.squirrels);
+    bot.rects.resize(count + 1);
+    bot.rects[0] = BotSquirrelRect(state.floorSquirrel);
+    for (int i = 0; i < count; i++)
+    {
+        bot.rects[i + 1] = BotSquirrelRect(*PoolGet(state.squirrels, PoolHandleAt(state.squirrels, i)));
+    }
+}
+
+// Node a launch from where the egg is now would end on, -1 for a miss. The flight of
+// SimulateSolverLaunch, with the checks in UpdatePhysics order, including the one the
+// solver leaves out: a catch where the egg also touches the floor squirrel ends there.
+inline int BotPredictLaunch(const Bot& bot, const GameState& state, float charge, float angle, bool faceRight)
+{
+    float x = state.egg.x, y = state.egg.y, velocityX, velocityY;
+    LaunchVelocity(charge, angle * PI / 2, faceRight, velocityX, velocityY);
+
+    SimRect leftTree = {0, 0, TREE_WIDTH, static_cast<int>(state.floorBottom)};
+    SimRect rightTree = {WINDOW_WIDTH - TREE_WIDTH, 0, TREE_WIDTH, static_cast<int>(state.floorBottom)};
+    SimRect nest = NestRect();
+    const SimRect& holder = bot.rects[bot.holderNode];
+    int nodeCount = static_cast<int>(bot.rects.size());
+
+    for (int frame = 0; frame < BOT_FLIGHT_FRAMES; frame++)
+    {
+        SimRect eggRect;
+        StepEggFlight(x, y, velocityX, velocityY, state.egg.width, state.egg.height, leftTree, rightTree, eggRect);
+
+        int caught = -1;
+        for (int node = 1; node < nodeCount && caught < 0; node++)
+        {
+            if (node != bot.holderNode && RectsOverlap(eggRect, bot.rects[node])) caught = node;
+        }
+        if (y > state.floorBottom - EGG_SIZE_Y || x < -state.egg.width || x > WINDOW_WIDTH) return -1;
+
+        bool onFloorSquirrel = RectsOverlap(eggRect, bot.rects[0]);
+        if (caught >= 0) return onFloorSquirrel ? 0 : caught;
+        if (onFloorSquirrel && bot.holderNode != 0) return 0;
+        if (!state.endless && RectsOverlap(eggRect, nest)) return nodeCount;
+
+        // Falling past the squirrel it left, nothing higher can catch it any more
+        if (velocityY > 0 && y > holder.y + holder.h) return -1;
+    }
+    return -1;
+}
+
+// Highest reachable node on the planning grid, the lowest charge among equals
+inline BotAim BotPlanWithSolver(const Bot& bot, const GameState& state)
+{
+    BotAim best = {1.0f, 0.5f, state.isLaunchingRight, -1};
+    for (int c = 1; c <= BOT_SOLVER_CHARGES; c++)
+    {
+        float charge = static_cast<float>(c) / BOT_SOLVER_CHARGES;
+        for (int a = 0; a < BOT_SOLVER_ANGLES; a++)
+        {
+            float angle = static_cast<float>(a) / (BOT_SOLVER_ANGLES - 1);
+            for (int direction = 0; direction < 2; direction++)
+            {
+                bool faceRight = direction == 0;
+                int target = BotPredictLaunch(bot, state, charge, angle, faceRight);
+                if (target > bot.holderNode && target > best.target)
+                    best = {charge, angle, faceRight, target};
+            }
+        }
+    }
+    return best;
+}
+
+inline void BotPlan(Bot& bot, const GameState& state)
+{
+    bot.planned = true;
+    bot.heldFrames = 0;
+    bot.holderNode = BotNodeOf(state, state.activeSquirrel);
+
+    BotBuildNodes(bot, state);
+    bot.aim = BotPlanWithSolver(bot, state);
+    if (bot.policy == BOT_POLICY_SOLVER) return;
+
+    const BotScriptStep& step = bot.script[bot.scriptIndex++ % bot.script.size()];
+    bot.aim.charge = std::min(1.0f, std::max(0.05f, bot.aim.charge + step.chargeError));
+    bot.aim.angle = std::min(1.0f, std::max(0.0f, bot.aim.angle + step.angleError));
+}
+
+// How far into the next step the charge reaches aim, or -1 if it does not
+inline float BotChargeCrossing(const GameState& state, float aim)
+{
+    float charge = state.strengthCharge;
+    float fraction = state.isDepletingCharge ? (charge - aim) / STRENGTH_CHARGE_RATE
+                                             : (aim - charge) / STRENGTH_CHARGE_RATE;
+    return fraction >= 0.0f && fraction < 1.0f ? fraction : -1.0f;
+}
+
+inline bool BotAcceptsRelease(const Bot& bot, const GameState& state, float fraction)
+{
+    if (bot.heldFrames >= BOT_GIVE_UP_FRAMES) return true;
+    if (state.isLaunchingRight != bot.aim.faceRight) return false;  // Still turning
+
+    float angle = LaunchAngleFromSquare(state.angleSquareY) / (PI / 2);
+    if (bot.policy != BOT_POLICY_SOLVER) return fabsf(angle - bot.aim.angle) < BOT_SCRIPT_ANGLE_SLOP;
+
+    int target = BotPredictLaunch(bot, state, ChargeAfter(state, fraction), angle, state.isLaunchingRight);
+    if (target <= bot.holderNode) return false;
+    return target >= bot.aim.target || bot.heldFrames >= BOT_PATIENCE_FRAMES;
+}
+
+// Input for the next step, given the state after the last one
+inline StepInput BotStepInput(Bot& bot, const GameState& state)
+{
+    StepInput input = {};
+    if (state.isInNest)
+    {
+        if (state.frame >= bot.reactionFrames) input.bits = REPLAY_INPUT_DROP;
+        return input;
+    }
+    if (!state.eggIsHeld || (state.events & (SIM_EVENT_LAUNCH | SIM_EVENT_CATCH | SIM_EVENT_MISS)))
+    {
+        bot.planned = false;  // Plan again on the next catch, which can come in the launch step
+    }
+    if (!state.eggIsHeld) return input;
+    if (!bot.planned) BotPlan(bot, state);
+    if (++bot.heldFrames < bot.reactionFrames) return input;
+
+    if (state.isLaunchingRight != bot.aim.faceRight)
+    {
+        input.bits |= bot.aim.faceRight ? REPLAY_INPUT_FACE_RIGHT : REPLAY_INPUT_FACE_LEFT;
+    }
+
+    // Kick the square whenever it is falling and would end up below the aimed height
+    float lowestY = ANGLE_BAR_Y + ANGLE_BAR_HEIGHT - ANGLE_SQUARE_SIZE;
+    float aimedY = lowestY - bot.aim.angle * (ANGLE_BAR_HEIGHT - ANGLE_SQUARE_SIZE);
+    float nextY = state.angleSquareY + state.angleSquareVelocity + ANGLE_GRAVITY;
+    if (state.angleSquareVelocity >= 0.0f && nextY > aimedY && bot.aim.angle > 0.0f)
+    {
+        input.bits |= REPLAY_INPUT_ANGLE;
+    }
+
+    if (!state.isCharging)
+    {
+        input.bits |= REPLAY_INPUT_CHARGE;
+        return input;
+    }
+
+    float fraction = BotChargeCrossing(state, bot.aim.charge);
+    if (fraction >= 0.0f && BotAcceptsRelease(bot, state, fraction))
+    {
+        input.bits |= REPLAY_INPUT_RELEASE;
+        input.releaseTime = static_cast<uint8_t>(fraction * 256.0f);
+    }
+    return input;
+}
+
+#endif // BOT_H
@@ -0,0 +1,196 @@
+#ifndef ENCODING_H
+#define ENCODING_H
+
+// Compact byte encodings for recorded runs: LEB128 varints, zigzag for signed
+// deltas, and base64 for stores that only take strings (localStorage).
+// ByteReader can stream from a FILE* through a small window, so recordings are
+// decoded as they play instead of being loaded whole.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+inline uint32_t ZigZagEncode(int32_t value)
+{
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+inline int32_t ZigZagDecode(uint32_t value)
+{
+    return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+
+struct ByteWriter {
+    std::vector<uint8_t> bytes;
+};
+
+inline void WriteByte(ByteWriter& writer, uint8_t value)
+{
+    writer.bytes.push_back(value);
+}
+
+inline void WriteU32(ByteWriter& writer, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+        writer.bytes.push_back(static_cast<uint8_t>(value >> (i * 8)));
+}
+
+inline void WriteVarint(ByteWriter& writer, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        writer.bytes.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    writer.bytes.push_back(static_cast<uint8_t>(value));
+}
+
+inline void WriteSignedVarint(ByteWriter& writer, int32_t value)
+{
+    WriteVarint(writer, ZigZagEncode(value));
+}
+
+// Reads either a memory buffer or, when file is set, a file through window
+struct ByteReader {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    size_t pos = 0;
+    FILE* file = nullptr;
+    uint8_t window[256];
+    bool failed = false;  // Set once a read ran past the end
+};
+
+inline void OpenByteReader(ByteReader& reader, const uint8_t* data, size_t size)
+{
+    reader = ByteReader();
+    reader.data = data;
+    reader.size = size;
+}
+
+// Takes ownership of file
+inline void OpenByteReader(ByteReader& reader, FILE* file)
+{
+    reader = ByteReader();
+    reader.file = file;
+}
+
+// Back to offset bytes from the start of the source
+inline void RewindByteReader(ByteReader& reader, size_t offset)
+{
+    reader.failed = false;
+    if (reader.file)
+    {
+        fseek(reader.file, static_cast<long>(offset), SEEK_SET);
+        reader.pos = reader.size = 0;
+    }
+    else
+    {
+        reader.pos = offset;
+    }
+}
+
+inline void CloseByteReader(ByteReader& reader)
+{
+    if (reader.file) fclose(reader.file);
+    reader = ByteReader();
+}
+
+inline bool ReadByte(ByteReader& reader, uint8_t& value)
+{
+    if (reader.pos == reader.size && reader.file)
+    {
+        reader.size = fread(reader.window, 1, sizeof(reader.window), reader.file);
+        reader.pos = 0;
+    }
+    if (reader.pos >= reader.size)
+    {
+        reader.failed = true;
+        return false;
+    }
+    value = reader.file ? reader.window[reader.pos++] : reader.data[reader.pos++];
+    return true;
+}
+
+inline bool ReadU32(ByteReader& reader, uint32_t& value)
+{
+    value = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        uint8_t byte;
+        if (!ReadByte(reader, byte)) return false;
+        value |= static_cast<uint32_t>(byte) << (i * 8);
+    }
+    return true;
+}
+
+inline bool ReadVarint(ByteReader& reader, uint32_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        uint8_t byte;
+        if (!ReadByte(reader, byte)) return false;
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    reader.failed = true;  // Longer than any 32 bit value
+    return false;
+}
+
+inline bool ReadSignedVarint(ByteReader& reader, int32_t& value)
+{
+    uint32_t raw;
+    if (!ReadVarint(reader, raw)) return false;
+    value = ZigZagDecode(raw);
+    return true;
+}
+
+inline std::string Base64Encode(const uint8_t* data, size_t size)
+{
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((size + 2) / 3 * 4);
+    for (size_t i = 0; i < size; i += 3)
+    {
+        uint32_t chunk = data[i] << 16;
+        if (i + 1 < size) chunk |= data[i + 1] << 8;
+        if (i + 2 < size) chunk |= data[i + 2];
+
+        out += table[(chunk >> 18) & 63];
+        out += table[(chunk >> 12) & 63];
+        out += i + 1 < size ? table[(chunk >> 6) & 63] : '=';
+        out += i + 2 < size ? table[chunk & 63] : '=';
+    }
+    return out;
+}
+
+// Stops at the first character outside the alphabet (padding included)
+inline std::vector<uint8_t> Base64Decode(const char* text)
+{
+    std::vector<uint8_t> out;
+    uint32_t bits = 0;
+    int bitCount = 0;
+    for (const char* c = text; *c; c++)
+    {
+        int value;
+        if (*c >= 'A' && *c <= 'Z') value = *c - 'A';
+        else if (*c >= 'a' && *c <= 'z') value = *c - 'a' + 26;
+        else if (*c >= '0' && *c <= '9') value = *c - '0' + 52;
+        else if (*c == '+') value = 62;
+        else if (*c == '/') value = 63;
+        else break;
+
+        bits = ((bits << 6) | value) & 0xFFFFFF;
+        bitCount += 6;
+        if (bitCount >= 8)
+        {
+            bitCount -= 8;
+            out.push_back(static_cast<uint8_t>(bits >> bitCount));
+        }
+    }
+    return out;
+}
+
+#endif // ENCODING_H
@@ -0,0 +1,198 @@
+#ifndef ENDLESS_H
+#define ENDLESS_H
+
+// Background chunk generation for endless mode.
+// The main thread asks for chunks up to some index, a worker thread generates them
+// into a fixed pool and hands them back in order. Chunks the player left behind are
+// released to the pool again, so memory stays flat however high the climb goes.
+// A miss sends the climb back to chunk 0: the streamer restarts under its lock and
+// keeps its worker, so a reset never joins or spawns a thread.
+// Without thread support (the default web build) chunks are generated inline.
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "level.h"
+
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define ENDLESS_THREADED 1
+#endif
+
+#define ENDLESS_CHUNKS_AHEAD 2   // Chunks kept generated above the egg
+#define ENDLESS_CHUNKS_BEHIND 1  // Chunks kept below the egg before eviction
+#define ENDLESS_POOL_SIZE 8      // Must cover AHEAD + BEHIND + the current chunk, plus slack for in-flight ones
+
+struct ChunkStreamer {
+    LevelChunk pool[ENDLESS_POOL_SIZE];
+    int freeSlots[ENDLESS_POOL_SIZE];
+    int freeCount;
+    int readySlots[ENDLESS_POOL_SIZE];  // Generated chunks waiting for the game, in index order
+    int readyCount;
+
+    LevelChunkCursor cursor;  // The worker generates from a copy and stores it back
+    LevelParams params;
+    SquirrelMetrics metrics;
+    int requestedUpTo;  // Highest chunk index the game asked for
+    int generatingSlot;   // Slot the worker is filling outside the lock, -1 if none
+    uint32_t generation;  // Bumped by every restart, so chunks of the old tower are dropped
+
+#ifdef ENDLESS_THREADED
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool quit;
+#endif
+};
+
+// Claims a pool slot for the next requested chunk. Caller holds the lock in threaded mode.
+inline bool ClaimChunkSlot(ChunkStreamer& streamer, int& slot)
+{
+    if (streamer.cursor.nextIndex > streamer.requestedUpTo || streamer.freeCount == 0)
+        return false;
+
+    slot = streamer.freeSlots[--streamer.freeCount];
+    return true;
+}
+
+#ifdef ENDLESS_THREADED
+inline void ChunkWorker(ChunkStreamer* streamer)
+{
+    std::unique_lock<std::mutex> lock(streamer->mutex);
+    while (!streamer->quit)
+    {
+        int slot;
+        if (!ClaimChunkSlot(*streamer, slot))
+        {
+            streamer->wake.wait(lock);
+            continue;
+        }
+
+        // The slot is ours until it shows up in readySlots, generate without holding the lock
+        LevelChunkCursor cursor = streamer->cursor;
+        LevelParams params = streamer->params;
+        SquirrelMetrics metrics = streamer->metrics;
+        uint32_t generation = streamer->generation;
+        streamer->generatingSlot = slot;
+        lock.unlock();
+        GenerateLevelChunk(cursor, params, metrics, streamer->pool[slot]);
+        lock.lock();
+        streamer->generatingSlot = -1;
+
+        if (generation != streamer->generation)
+        {
+            streamer->freeSlots[streamer->freeCount++] = slot;  // Restarted meanwhile, left out of the free list
+            continue;
+        }
+        streamer->cursor = cursor;
+        streamer->readySlots[streamer->readyCount++] = slot;
+    }
+}
+#endif
+
+// Back to chunk 0 of seed with every slot free. Chunks handed out earlier must not be
+// used after this.
+inline void RestartChunkStreamer(ChunkStreamer& streamer, uint32_t seed,
+                                 const LevelParams& params, const SquirrelMetrics& metrics)
+{
+    {
+#ifdef ENDLESS_THREADED
+        std::lock_guard<std::mutex> lock(streamer.mutex);
+#endif
+        streamer.freeCount = 0;
+        for (int i = ENDLESS_POOL_SIZE - 1; i >= 0; i--)
+        {
+            if (i != streamer.generatingSlot) streamer.freeSlots[streamer.freeCount++] = i;
+        }
+        streamer.readyCount = 0;
+
+        StartLevelChunks(seed, streamer.cursor);
+        streamer.params = params;
+        streamer.metrics = metrics;
+        streamer.requestedUpTo = -1;
+        streamer.generation++;
+    }
+}
+
+inline void StartChunkStreamer(ChunkStreamer& streamer, uint32_t seed,
+                               const LevelParams& params, const SquirrelMetrics& metrics)
+{
+    streamer.generatingSlot = -1;
+    streamer.generation = 0;
+    RestartChunkStreamer(streamer, seed, params, metrics);
+
+#ifdef ENDLESS_THREADED
+    streamer.quit = false;
+    streamer.worker = std::thread(ChunkWorker, &streamer);
+#endif
+}
+
+inline void StopChunkStreamer(ChunkStreamer& streamer)
+{
+#ifdef ENDLESS_THREADED
+    if (!streamer.worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(streamer.mutex);
+        streamer.quit = true;
+    }
+    streamer.wake.notify_one();
+    streamer.worker.join();
+#endif
+}
+
+inline void RequestChunksUpTo(ChunkStreamer& streamer, int index)
+{
+#ifdef ENDLESS_THREADED
+    {
+        std::lock_guard<std::mutex> lock(streamer.mutex);
+        if (index <= streamer.requestedUpTo) return;
+        streamer.requestedUpTo = index;
+    }
+    streamer.wake.notify_one();
+#else
+    if (index <= streamer.requestedUpTo) return;
+    streamer.requestedUpTo = index;
+
+    int slot;
+    while (ClaimChunkSlot(streamer, slot))
+    {
+        GenerateLevelChunk(streamer.cursor, streamer.params, streamer.metrics, streamer.pool[slot]);
+        streamer.readySlots[streamer.readyCount++] = slot;
+    }
+#endif
+}
+
+// Next generated chunk in index order, or nullptr if none is ready yet. Never blocks.
+inline LevelChunk* PollReadyChunk(ChunkStreamer& streamer)
+{
+#ifdef ENDLESS_THREADED
+    std::lock_guard<std::mutex> lock(streamer.mutex);
+#endif
+    if (streamer.readyCount == 0) return nullptr;
+
+    LevelChunk* chunk = &streamer.pool[streamer.readySlots[0]];
+    for (int i = 1; i < streamer.readyCount; i++)
+        streamer.readySlots[i - 1] = streamer.readySlots[i];
+    streamer.readyCount--;
+    return chunk;
+}
+
+inline void ReleaseChunk(ChunkStreamer& streamer, LevelChunk* chunk)
+{
+    {
+#ifdef ENDLESS_THREADED
+        std::lock_guard<std::mutex> lock(streamer.mutex);
+#endif
+        streamer.freeSlots[streamer.freeCount++] = static_cast<int>(chunk - streamer.pool);
+    }
+#ifdef ENDLESS_THREADED
+    streamer.wake.notify_one();
+#else
+    // A request may have been waiting on this slot
+    int requested = streamer.requestedUpTo;
+    streamer.requestedUpTo = -1;
+    RequestChunksUpTo(streamer, requested);
+#endif
+}
+
+#endif // ENDLESS_H
@@ -0,0 +1,121 @@
+#ifndef ENTITY_POOL_H
+#define ENTITY_POOL_H
+
+// Fixed capacity, stable address storage for level entities (branches, squirrels).
+// Objects live in a ring: appended at the back, evicted from the front (endless mode
+// drops the lowest chunk), or all dropped at once by ResetPool in O(1).
+// Every appended object gets the next serial number; that serial is its handle and
+// also picks its slot (serial % Capacity). A handle is valid while its serial lies in
+// [first, next), so evicted or reset objects can never be reached through a stale one.
+
+#include <cstdint>
+
+typedef uint32_t EntityHandle;
+
+#define INVALID_ENTITY_HANDLE 0xFFFFFFFFu
+
+template <typename T, int Capacity>
+struct EntityPool {
+    static_assert((Capacity & (Capacity - 1)) == 0, "serials wrap at 2^32, capacity must be a power of two");
+
+    T items[Capacity];
+    uint32_t first = 0;  // Serial of the oldest live object
+    uint32_t next = 0;   // Serial the next append receives
+
+    struct Iterator {
+        EntityPool* pool;
+        uint32_t serial;
+
+        T& operator*() const { return pool->items[serial % Capacity]; }
+        Iterator& operator++() { serial++; return *this; }
+        bool operator!=(const Iterator& other) const { return serial != other.serial; }
+    };
+
+    Iterator begin() { return {this, first}; }
+    Iterator end() { return {this, next}; }
+
+    struct ConstIterator {
+        const EntityPool* pool;
+        uint32_t serial;
+
+        const T& operator*() const { return pool->items[serial % Capacity]; }
+        ConstIterator& operator++() { serial++; return *this; }
+        bool operator!=(const ConstIterator& other) const { return serial != other.serial; }
+    };
+
+    ConstIterator begin() const { return {this, first}; }
+    ConstIterator end() const { return {this, next}; }
+};
+
+template <typename T, int Capacity>
+inline int PoolCount(const EntityPool<T, Capacity>& pool)
+{
+    return static_cast<int>(pool.next - pool.first);
+}
+
+template <typename T, int Capacity>
+inline bool PoolEmpty(const EntityPool<T, Capacity>& pool)
+{
+    return pool.next == pool.first;
+}
+
+// Drops everything; outstanding handles become invalid
+template <typename T, int Capacity>
+inline void ResetPool(EntityPool<T, Capacity>& pool)
+{
+    pool.first = pool.next;
+}
+
+// Returns nullptr when full
+template <typename T, int Capacity>
+inline T* PoolAppend(EntityPool<T, Capacity>& pool, const T& object)
+{
+    if (PoolCount(pool) >= Capacity) return nullptr;
+
+    T* slot = &pool.items[pool.next % Capacity];
+    *slot = object;
+    pool.next++;
+    return slot;
+}
+
+// Drops the count oldest objects
+template <typename T, int Capacity>
+inline void PoolEvictOldest(EntityPool<T, Capacity>& pool, int count)
+{
+    if (count > PoolCount(pool)) count = PoolCount(pool);
+    pool.first += count;
+}
+
+template <typename T, int Capacity>
+inline bool PoolIsLive(const EntityPool<T, Capacity>& pool, EntityHandle handle)
+{
+    return handle - pool.first < pool.next - pool.first;
+}
+
+template <typename T, int Capacity>
+inline T* PoolGet(EntityPool<T, Capacity>& pool, EntityHandle handle)
+{
+    return PoolIsLive(pool, handle) ? &pool.items[handle % Capacity] : nullptr;
+}
+
+template <typename T, int Capacity>
+inline const T* PoolGet(const EntityPool<T, Capacity>& pool, EntityHandle handle)
+{
+    return PoolIsLive(pool, handle) ? &pool.items[handle % Capacity] : nullptr;
+}
+
+// Handle of the index-th live object, oldest first
+template <typename T, int Capacity>
+inline EntityHandle PoolHandleAt(const EntityPool<T, Capacity>& pool, int index)
+{
+    return pool.first + index;
+}
+
+// Whether object points into the pool's storage
+template <typename T, int Capacity>
+inline bool PoolContains(const EntityPool<T, Capacity>& pool, const T* object)
+{
+    return object >= &pool.items[0] && object < &pool.items[Capacity];
+}
+
+#endif // ENTITY_POOL_H
@@ -0,0 +1,106 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+// 16.16 fixed point for the egg's flight, an alternative to the float physics that
+// comes out bit for bit the same on MinGW, Linux and wasm: only integer math, and sine
+// from a table instead of the C library's sin/cos, which differ between platforms.
+// Values come in as floats, rounded the same way everywhere. State that carries from
+// step to step has to stay in fixed point: a float has 24 significant bits, so past
+// 256 it cannot hold all 16 fraction bits and going out to float rounds. Floats going
+// out are only for drawing and checks.
+
+#include <cstdint>
+
+typedef int32_t Fixed;
+
+#define FIXED_SHIFT 16
+#define FIXED_ONE (1 << FIXED_SHIFT)
+#define FIXED_SINE_STEPS 256  // Table entries per quarter turn, plus one for the end
+
+// sin(i * PI / 2 / FIXED_SINE_STEPS) in 16.16, rounded. Generated once, never computed
+// at run time, so every platform reads the same numbers.
+static const Fixed g_FixedQuarterSine[FIXED_SINE_STEPS + 1] = {
+    0, 402, 804, 1206, 1608, 2010, 2412, 2814,
+    3216, 3617, 4019, 4420, 4821, 5222, 5623, 6023,
+    6424, 6824, 7224, 7623, 8022, 8421, 8820, 9218,
+    9616, 10014, 10411, 10808, 11204, 11600, 11996, 12391,
+    12785, 13180, 13573, 13966, 14359, 14751, 15143, 15534,
+    15924, 16314, 16703, 17091, 17479, 17867, 18253, 18639,
+    19024, 19409, 19792, 20175, 20557, 20939, 21320, 21699,
+    22078, 22457, 22834, 23210, 23586, 23961, 24335, 24708,
+    25080, 25451, 25821, 26190, 26558, 26925, 27291, 27656,
+    28020, 28383, 28745, 29106, 29466, 29824, 30182, 30538,
+    30893, 31248, 31600, 31952, 32303, 32652, 33000, 33347,
+    33692, 34037, 34380, 34721, 35062, 35401, 35738, 36075,
+    36410, 36744, 37076, 37407, 37736, 38064, 38391, 38716,
+    39040, 39362, 39683, 40002, 40320, 40636, 40951, 41264,
+    41576, 41886, 42194, 42501, 42806, 43110, 43412, 43713,
+    44011, 44308, 44604, 44898, 45190, 45480, 45769, 46056,
+    46341, 46624, 46906, 47186, 47464, 47741, 48015, 48288,
+    48559, 48828, 49095, 49361, 49624, 49886, 50146, 50404,
+    50660, 50914, 51166, 51417, 51665, 51911, 52156, 52398,
+    52639, 52878, 53114, 53349, 53581, 53812, 54040, 54267,
+    54491, 54714, 54934, 55152, 55368, 55582, 55794, 56004,
+    56212, 56418, 56621, 56823, 57022, 57219, 57414, 57607,
+    57798, 57986, 58172, 58356, 58538, 58718, 58896, 59071,
+    59244, 59415, 59583, 59750, 59914, 60075, 60235, 60392,
+    60547, 60700, 60851, 60999, 61145, 61288, 61429, 61568,
+    61705, 61839, 61971, 62101, 62228, 62353, 62476, 62596,
+    62714, 62830, 62943, 63054, 63162, 63268, 63372, 63473,
+    63572, 63668, 63763, 63854, 63944, 64031, 64115, 64197,
+    64277, 64354, 64429, 64501, 64571, 64639, 64704, 64766,
+    64827, 64884, 64940, 64993, 65043, 65091, 65137, 65180,
+    65220, 65259, 65294, 65328, 65358, 65387, 65413, 65436,
+    65457, 65476, 65492, 65505, 65516, 65525, 65531, 65535,
+    65536
+};
+
+inline Fixed FixedFromInt(int value)
+{
+    return static_cast<Fixed>(value * FIXED_ONE);
+}
+
+// Rounded to the nearest 1/65536, halves away from zero. The double math is exact, so no
+// platform rounds differently.
+inline Fixed FixedFromFloat(float value)
+{
+    double scaled = static_cast<double>(value) * FIXED_ONE;
+    return static_cast<Fixed>(scaled < 0.0 ? scaled - 0.5 : scaled + 0.5);
+}
+
+inline float FixedToFloat(Fixed value)
+{
+    return static_cast<float>(value) * (1.0f / FIXED_ONE);  // Rounds past 256, cheaper than dividing
+}
+
+// Truncated toward zero, like casting the float
+inline int FixedToInt(Fixed value)
+{
+    return value / FIXED_ONE;
+}
+
+inline Fixed FixedMul(Fixed a, Fixed b)
+{
+    return static_cast<Fixed>((static_cast<int64_t>(a) * b) >> FIXED_SHIFT);
+}
+
+// turn: 0 to FIXED_ONE for 0 to PI/2, interpolated between table entries
+inline Fixed FixedQuarterSine(Fixed turn)
+{
+    if (turn <= 0) return 0;
+    if (turn >= FIXED_ONE) return FIXED_ONE;
+
+    int position = turn * FIXED_SINE_STEPS;  // 8.16 table position, fits since turn < 1
+    int index = position >> FIXED_SHIFT;
+    int fraction = position & (FIXED_ONE - 1);
+    Fixed low = g_FixedQuarterSine[index];
+    Fixed high = g_FixedQuarterSine[index + 1];
+    return low + static_cast<Fixed>((static_cast<int64_t>(high - low) * fraction) >> FIXED_SHIFT);
+}
+
+inline Fixed FixedQuarterCosine(Fixed turn)
+{
+    return FixedQuarterSine(FIXED_ONE - turn);
+}
+
+#endif // FIXED_POINT_H
@@ -0,0 +1,150 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+// How the frame loop waits between presents, decided from present times measured with a
+// high resolution counter (SDL_GetPerformanceCounter in the game):
+//   FRAME_PACING_VSYNC     the present blocks until the display refreshes, nothing else
+//                          waits, so 75/120/144 Hz displays get every refresh
+//   FRAME_PACING_SLEEP     vsync is off or not honored: sleep most of the way to the next
+//                          frame and spin the rest, at the display's refresh rate
+//   FRAME_PACING_UNCAPPED  no wait at all (headless runs)
+// A vsync pacer checks its first presents and falls back to sleeping when their period
+// is not the display's: a driver forcing vsync off, or a compositor pacing at some other
+// rate. Without a reported refresh rate it can only reject presents faster than any
+// display refreshes. Frame time mean and variance are kept as running
+// averages over roughly the last FRAME_PACER_WINDOW frames.
+
+#include <cstdint>
+#include <cstring>
+
+#define FRAME_PACER_WARMUP_FRAMES 10       // First presents after the window opens are irregular
+#define FRAME_PACER_CALIBRATION_FRAMES 60  // Then measure this many
+#define FRAME_PACER_VSYNC_TOLERANCE 0.1    // Measured period within 10% of the display's
+#define FRAME_PACER_MIN_VSYNC_MS 2.0       // Unknown display: faster than 500 Hz did not wait
+#define FRAME_PACER_SPIN_MS 2.0            // Sleep until this close, OS sleeps overshoot
+#define FRAME_PACER_WINDOW 50
+
+enum {
+    FRAME_PACING_VSYNC,
+    FRAME_PACING_SLEEP,
+    FRAME_PACING_UNCAPPED
+};
+
+struct FramePacer {
+    int mode;
+    bool calibrating;         // Vsync mode, still checking that the present waits
+    double frequency;         // Counter ticks per second
+    double refreshHz;         // Sleep mode frame rate
+    double displayHz;         // Reported by the display, 0 if unknown
+    uint64_t lastPresent;
+    uint64_t nextFrame;       // Sleep mode deadline
+    uint32_t presents;
+    uint32_t calibrationCount;
+    double calibrationSumMs;
+    double meanMs;            // Running frame time, present to present
+    double varianceMs;        // Running variance, ms squared
+};
+
+inline const char* FramePacingName(int mode)
+{
+    switch (mode)
+    {
+    case FRAME_PACING_VSYNC: return "vsync";
+    case FRAME_PACING_SLEEP: return "sleep";
+    default: return "uncapped";
+    }
+}
+
+// Pacing name from the command line, -1 if unknown
+inline int ParseFramePacing(const char* name)
+{
+    for (int mode = FRAME_PACING_VSYNC; mode <= FRAME_PACING_UNCAPPED; mode++)
+    {
+        if (strcmp(name, FramePacingName(mode)) == 0) return mode;
+    }
+    return -1;
+}
+
+// calibrate: check that vsync really waits before trusting it. displayHz is 0 when the
+// display did not report a rate, refreshHz is then a fallback for sleep mode.
+inline void StartFramePacer(FramePacer& pacer, int mode, bool calibrate,
+                            double frequency, double refreshHz, double displayHz, uint64_t now)
+{
+    pacer = FramePacer();
+    pacer.mode = mode;
+    pacer.calibrating = calibrate && mode == FRAME_PACING_VSYNC;
+    pacer.frequency = frequency;
+    pacer.refreshHz = refreshHz;
+    pacer.displayHz = displayHz;
+    pacer.lastPresent = now;
+    pacer.nextFrame = now;
+}
+
+inline uint64_t FramePeriodTicks(const FramePacer& pacer)
+{
+    return static_cast<uint64_t>(pacer.frequency / pacer.refreshHz);
+}
+
+// Call right after each present. True when calibration just gave up on vsync, the
+// caller then turns it off on the renderer.
+inline bool FramePresented(FramePacer& pacer, uint64_t now)
+{
+    double frameMs = (now - pacer.lastPresent) * 1000.0 / pacer.frequency;
+    pacer.lastPresent = now;
+    pacer.presents++;
+
+    if (pacer.presents == 1)
+    {
+        pacer.meanMs = frameMs;
+    }
+    else
+    {
+        // Exponentially weighted mean and variance
+        const double weight = 1.0 / FRAME_PACER_WINDOW;
+        double difference = frameMs - pacer.meanMs;
+        pacer.meanMs += weight * difference;
+        pacer.varianceMs = (1.0 - weight) * (pacer.varianceMs + weight * difference * difference);
+    }
+
+    if (!pacer.calibrating || pacer.presents <= FRAME_PACER_WARMUP_FRAMES) return false;
+
+    pacer.calibrationSumMs += frameMs;
+    if (++pacer.calibrationCount < FRAME_PACER_CALIBRATION_FRAMES) return false;
+
+    pacer.calibrating = false;
+    double measuredMs = pacer.calibrationSumMs / pacer.calibrationCount;
+    bool waited = measuredMs >= FRAME_PACER_MIN_VSYNC_MS;
+    if (pacer.displayHz > 0)
+    {
+        double displayMs = 1000.0 / pacer.displayHz;
+        double offBy = measuredMs > displayMs ? measuredMs - displayMs : displayMs - measuredMs;
+        waited = offBy <= displayMs * FRAME_PACER_VSYNC_TOLERANCE;
+    }
+    if (waited)
+    {
+        pacer.refreshHz = 1000.0 / measuredMs;
+        return false;
+    }
+    pacer.mode = FRAME_PACING_SLEEP;
+    pacer.nextFrame = now + FramePeriodTicks(pacer);
+    return true;
+}
+
+// Counter ticks to wait before the next frame starts, 0 for none
+inline uint64_t FramePacerWait(FramePacer& pacer, uint64_t now)
+{
+    if (pacer.mode != FRAME_PACING_SLEEP) return 0;
+
+    uint64_t period = FramePeriodTicks(pacer);
+    if (now >= pacer.nextFrame)
+    {
+        // Late: start the next period from here rather than rushing to catch up
+        pacer.nextFrame = now - pacer.nextFrame > period ? now + period : pacer.nextFrame + period;
+        return 0;
+    }
+    uint64_t wait = pacer.nextFrame - now;
+    pacer.nextFrame += period;
+    return wait;
+}
+
+#endif // FRAME_PACER_H
@@ -0,0 +1,189 @@
+#ifndef GHOST_H
+#define GHOST_H
+
+// Ghost runs: the egg's path on the best run so far, played back next to the live egg.
+// Positions are sampled every GHOST_SAMPLE_FRAMES physics frames and stored as zigzag
+// varint deltas, a couple of bytes per sample. Playback interpolates between samples
+// and decodes them as it goes, from a file or from an in-memory copy (localStorage).
+//
+// Layout: magic, version, seed, sample interval, run time in ms, sample count, then
+// (dx, dy) per sample relative to the previous one, starting from (0, 0).
+
+#include <cmath>
+
+#include "encoding.h"
+
+#define GHOST_MAGIC 0x48474B43u  // "CKGH"
+#define GHOST_VERSION 1
+#define GHOST_SAMPLE_FRAMES 3    // 50 ms at TARGET_FPS
+#define GHOST_HEADER_SIZE 18
+
+struct GhostRecorder {
+    ByteWriter samples;
+    uint32_t frame;
+    uint32_t sampleCount;
+    int32_t lastX, lastY;
+    bool active;
+};
+
+struct GhostPlayer {
+    ByteReader reader;
+    std::vector<uint8_t> buffer;  // Backing store when not streaming from a file
+    bool loaded;
+
+    uint32_t seed;
+    uint32_t sampleFrames;
+    uint32_t durationMs;
+    uint32_t sampleCount;
+
+    uint32_t frame;
+    uint32_t prevIndex;  // Sample index of prev, next is the one after it
+    uint32_t samplesRead;
+    int32_t prevX, prevY;
+    int32_t nextX, nextY;
+};
+
+inline void StartGhostRecording(GhostRecorder& recorder)
+{
+    recorder.samples.bytes.clear();  // Keeps capacity from the last run
+    recorder.frame = 0;
+    recorder.sampleCount = 0;
+    recorder.lastX = recorder.lastY = 0;
+    recorder.active = true;
+}
+
+inline void RecordGhostFrame(GhostRecorder& recorder, float x, float y)
+{
+    if (!recorder.active) return;
+
+    if (recorder.frame % GHOST_SAMPLE_FRAMES == 0)
+    {
+        int32_t ix = static_cast<int32_t>(lroundf(x));
+        int32_t iy = static_cast<int32_t>(lroundf(y));
+        WriteSignedVarint(recorder.samples, ix - recorder.lastX);
+        WriteSignedVarint(recorder.samples, iy - recorder.lastY);
+        recorder.lastX = ix;
+        recorder.lastY = iy;
+        recorder.sampleCount++;
+    }
+    recorder.frame++;
+}
+
+// Header plus samples, ready to be written out
+inline void FinishGhostRecording(GhostRecorder& recorder, uint32_t seed, uint32_t durationMs, ByteWriter& out)
+{
+    recorder.active = false;
+
+    out.bytes.clear();
+    WriteU32(out, GHOST_MAGIC);
+    WriteByte(out, GHOST_VERSION);
+    WriteU32(out, seed);
+    WriteByte(out, GHOST_SAMPLE_FRAMES);
+    WriteU32(out, durationMs);
+    WriteU32(out, recorder.sampleCount);
+    out.bytes.insert(out.bytes.end(), recorder.samples.bytes.begin(), recorder.samples.bytes.end());
+}
+
+inline bool ReadGhostSample(GhostPlayer& player)
+{
+    if (player.samplesRead >= player.sampleCount) return false;
+
+    int32_t dx, dy;
+    if (!ReadSignedVarint(player.reader, dx) || !ReadSignedVarint(player.reader, dy))
+        return false;
+
+    player.nextX += dx;
+    player.nextY += dy;
+    player.samplesRead++;
+    return true;
+}
+
+inline void RestartGhost(GhostPlayer& player)
+{
+    if (!player.loaded) return;
+
+    RewindByteReader(player.reader, GHOST_HEADER_SIZE);
+    player.frame = 0;
+    player.prevIndex = 0;
+    player.samplesRead = 0;
+    player.nextX = player.nextY = 0;
+
+    ReadGhostSample(player);
+    player.prevX = player.nextX;
+    player.prevY = player.nextY;
+    ReadGhostSample(player);
+}
+
+inline void CloseGhost(GhostPlayer& player)
+{
+    CloseByteReader(player.reader);
+    player.buffer.clear();
+    player.loaded = false;
+}
+
+// Parses the header of an opened reader, closes it again if it is not a ghost
+inline bool LoadGhostHeader(GhostPlayer& player)
+{
+    uint32_t magic = 0, version = 0, sampleFrames = 0;
+    uint8_t byte;
+    bool ok = ReadU32(player.reader, magic) && magic == GHOST_MAGIC &&
+              ReadByte(player.reader, byte) && (version = byte) == GHOST_VERSION &&
+              ReadU32(player.reader, player.seed) &&
+              ReadByte(player.reader, byte) && (sampleFrames = byte) > 0 &&
+              ReadU32(player.reader, player.durationMs) &&
+              ReadU32(player.reader, player.sampleCount) && player.sampleCount > 0;
+
+    if (!ok)
+    {
+        CloseGhost(player);
+        return false;
+    }
+
+    player.sampleFrames = sampleFrames;
+    player.loaded = true;
+    RestartGhost(player);
+    return true;
+}
+
+// Streams from file, which the player now owns
+inline bool LoadGhost(GhostPlayer& player, FILE* file)
+{
+    CloseGhost(player);
+    if (!file) return false;
+    OpenByteReader(player.reader, file);
+    return LoadGhostHeader(player);
+}
+
+inline bool LoadGhost(GhostPlayer& player, std::vector<uint8_t>&& bytes)
+{
+    CloseGhost(player);
+    player.buffer = std::move(bytes);
+    OpenByteReader(player.reader, player.buffer.data(), player.buffer.size());
+    return LoadGhostHeader(player);
+}
+
+// Ghost position for the next physics frame. Returns false once the run is over.
+inline bool StepGhost(GhostPlayer& player, float& x, float& y)
+{
+    if (!player.loaded) return false;
+
+    uint32_t segment = player.frame / player.sampleFrames;
+    if (segment >= player.sampleCount) return false;
+
+    while (player.prevIndex < segment)
+    {
+        player.prevX = player.nextX;
+        player.prevY = player.nextY;
+        player.prevIndex++;
+        if (!ReadGhostSample(player) && player.reader.failed)
+            return false;  // Truncated recording
+    }
+
+    float t = static_cast<float>(player.frame % player.sampleFrames) / player.sampleFrames;
+    x = player.prevX + (player.nextX - player.prevX) * t;
+    y = player.prevY + (player.nextY - player.prevY) * t;
+    player.frame++;
+    return true;
+}
+
+#endif // GHOST_H
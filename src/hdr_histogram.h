@@ -0,0 +1,73 @@
+#ifndef HDR_HISTOGRAM_H
+#define HDR_HISTOGRAM_H
+
+// Fixed size log-linear histogram of microsecond timings, in the style of HdrHistogram:
+// every power of two range is split into HDR_SUB_BUCKETS linear buckets, so any value up
+// to 2^32 us is kept to within 1/64 (1.6%) of itself. 7 KB per histogram, recording is a
+// couple of shifts and an increment, nothing is ever allocated.
+
+#include <cstdint>
+
+#define HDR_SUB_BUCKET_BITS 6
+#define HDR_SUB_BUCKETS (1 << HDR_SUB_BUCKET_BITS)
+#define HDR_BUCKETS (HDR_SUB_BUCKETS * (32 - HDR_SUB_BUCKET_BITS + 1))
+
+struct HdrHistogram {
+    uint32_t counts[HDR_BUCKETS];
+    uint64_t total;
+    uint32_t max;
+};
+
+inline int HdrHighestBit(uint32_t value)
+{
+    int bit = 0;
+    while (value >>= 1) bit++;
+    return bit;
+}
+
+inline int HdrBucketIndex(uint32_t value)
+{
+    if (value < HDR_SUB_BUCKETS) return static_cast<int>(value);  // Exact below 64 us
+
+    int shift = HdrHighestBit(value) - HDR_SUB_BUCKET_BITS;
+    return HDR_SUB_BUCKETS * (shift + 1) + static_cast<int>(value >> shift) - HDR_SUB_BUCKETS;
+}
+
+// Largest value that lands in bucket index
+inline uint32_t HdrBucketHighest(int index)
+{
+    if (index < HDR_SUB_BUCKETS) return static_cast<uint32_t>(index);
+
+    int shift = index / HDR_SUB_BUCKETS - 1;
+    uint64_t lowest = static_cast<uint64_t>(index % HDR_SUB_BUCKETS + HDR_SUB_BUCKETS) << shift;
+    return static_cast<uint32_t>(lowest + (1ull << shift) - 1);
+}
+
+inline void HdrRecord(HdrHistogram& histogram, uint32_t valueUs)
+{
+    histogram.counts[HdrBucketIndex(valueUs)]++;
+    histogram.total++;
+    if (valueUs > histogram.max) histogram.max = valueUs;
+}
+
+// Value in us that percentile (0 to 100) of the samples are at or below, 0 when empty
+inline uint32_t HdrPercentile(const HdrHistogram& histogram, double percentile)
+{
+    if (histogram.total == 0) return 0;
+
+    uint64_t target = static_cast<uint64_t>(histogram.total * percentile / 100.0 + 0.5);
+    if (target < 1) target = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < HDR_BUCKETS; i++)
+    {
+        seen += histogram.counts[i];
+        if (seen >= target)
+        {
+            uint32_t highest = HdrBucketHighest(i);
+            return highest < histogram.max ? highest : histogram.max;
+        }
+    }
+    return histogram.max;
+}
+
+#endif // HDR_HISTOGRAM_H
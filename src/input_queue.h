@@ -0,0 +1,57 @@
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+
+// Input events on their way from the event loop to the simulation, with the time they
+// happened. Single producer (the thread polling SDL events), single consumer (whoever
+// steps the simulation), no locks: each side only writes its own index.
+// The consumer peeks before popping, so events that belong to a later step stay queued.
+
+#include <atomic>
+#include <cstdint>
+
+#define INPUT_QUEUE_CAPACITY 256  // Power of two, a few seconds of key repeat
+
+struct InputEvent {
+    uint8_t bits;    // REPLAY_INPUT_*
+    uint32_t timeMs; // SDL event timestamp, same clock as SDL_GetTicks
+};
+
+template <typename T, uint32_t Capacity>
+struct SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+    T items[Capacity];
+    std::atomic<uint32_t> head{0};  // Next to read, only the consumer writes it
+    std::atomic<uint32_t> tail{0};  // Next to write, only the producer writes it
+};
+
+typedef SpscQueue<InputEvent, INPUT_QUEUE_CAPACITY> InputQueue;
+
+// Producer side, false if the consumer fell a whole queue behind
+template <typename T, uint32_t Capacity>
+inline bool SpscPush(SpscQueue<T, Capacity>& queue, const T& item)
+{
+    uint32_t tail = queue.tail.load(std::memory_order_relaxed);
+    if (tail - queue.head.load(std::memory_order_acquire) == Capacity) return false;
+
+    queue.items[tail & (Capacity - 1)] = item;
+    queue.tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+// Consumer side, oldest item or nullptr when empty. Valid until SpscPop.
+template <typename T, uint32_t Capacity>
+inline const T* SpscPeek(const SpscQueue<T, Capacity>& queue)
+{
+    uint32_t head = queue.head.load(std::memory_order_relaxed);
+    if (head == queue.tail.load(std::memory_order_acquire)) return nullptr;
+    return &queue.items[head & (Capacity - 1)];
+}
+
+// Consumer side, after a successful SpscPeek
+template <typename T, uint32_t Capacity>
+inline void SpscPop(SpscQueue<T, Capacity>& queue)
+{
+    queue.head.store(queue.head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+#endif // INPUT_QUEUE_H
@@ -0,0 +1,312 @@
+#ifndef LEADERBOARD_CLIENT_H
+#define LEADERBOARD_CLIENT_H
+
+// Sends finished runs to the leaderboard server without ever blocking a frame. Each
+// score carries the replay of its run, the server re-simulates it and ranks the time
+// the simulation gives, so the time sent along is only for the local report.
+// Desktop: scores queue up and a worker thread posts them in batches of up to
+// LEADERBOARD_BATCH_BYTES, keeping a batch for the next try if the server cannot be reached.
+// Web: emscripten_fetch posts asynchronously, failed scores ride along with the next.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "encoding.h"
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten/fetch.h>
+#else
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "net.h"
+#endif
+
+#define LEADERBOARD_QUEUE_MAX 64      // Oldest scores are dropped past this while offline
+#define LEADERBOARD_RETRY_SECONDS 30
+#define LEADERBOARD_BATCH_BYTES (32 * 1024)  // Per POST, well under the server's NET_MAX_REQUEST
+
+struct PendingScore {
+    uint32_t seed;
+    uint32_t timeMs;
+    std::string replay;  // Base64 replay file of the run
+};
+
+struct LeaderboardClient {
+    bool enabled;
+    std::string name;
+    std::vector<PendingScore> queue;
+
+#ifdef __EMSCRIPTEN__
+    std::string url;           // Server base URL, e.g. http://localhost:8080
+    std::vector<PendingScore> inFlight;
+    std::string body;          // Must outlive the fetch
+    bool busy;
+#else
+    std::string host;
+    int port;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool quit;
+    bool drain;  // Post what is still queued before quitting
+#endif
+};
+
+// One "seed replay name" line per score
+inline std::string FormatScoreBatch(const std::vector<PendingScore>& scores, const std::string& name)
+{
+    std::string body;
+    char line[32];
+    for (const PendingScore& score : scores)
+    {
+        snprintf(line, sizeof(line), "%u ", score.seed);
+        body += line;
+        body += score.replay;
+        body += ' ';
+        body += name;
+        body += '\n';
+    }
+    return body;
+}
+
+// Moves scores from the front of queue into batch until it reaches LEADERBOARD_BATCH_BYTES,
+// always at least one
+inline void TakeScoreBatch(std::vector<PendingScore>& queue, std::vector<PendingScore>& batch)
+{
+    size_t taken = 0, bytes = 0;
+    while (taken < queue.size() && (taken == 0 || bytes + queue[taken].replay.size() <= LEADERBOARD_BATCH_BYTES))
+    {
+        bytes += queue[taken].replay.size();
+        batch.push_back(std::move(queue[taken++]));
+    }
+    queue.erase(queue.begin(), queue.begin() + taken);
+}
+
+// Response is {"accepted":N,"ranks":[...]}, only the ranks are of interest
+inline void ReportScoreRanks(const std::vector<PendingScore>& scores, const char* response)
+{
+    const char* ranks = strstr(response, "\"ranks\":[");
+    if (!ranks) return;
+    ranks += 9;
+    for (const PendingScore& score : scores)
+    {
+        unsigned long rank = strtoul(ranks, nullptr, 10);
+        if (rank > 0)
+            printf("Global rank %lu for %u.%03us on seed %u\n", rank, score.timeMs / 1000, score.timeMs % 1000, score.seed);
+        ranks = strchr(ranks, ',');
+        if (!ranks) break;
+        ranks++;
+    }
+}
+
+inline void QueueScore(std::vector<PendingScore>& queue, const PendingScore& score)
+{
+    if (queue.size() >= LEADERBOARD_QUEUE_MAX) queue.erase(queue.begin());
+    queue.push_back(score);
+}
+
+inline PendingScore MakePendingScore(uint32_t seed, uint32_t timeMs, const std::vector<uint8_t>& replay)
+{
+    PendingScore score = {seed, timeMs, Base64Encode(replay.data(), replay.size())};
+    return score;
+}
+
+#ifdef __EMSCRIPTEN__
+
+inline void PostScoreBatch(LeaderboardClient& client);
+
+inline void OnScoresPosted(emscripten_fetch_t* fetch)
+{
+    LeaderboardClient& client = *static_cast<LeaderboardClient*>(fetch->userData);
+    std::string response(fetch->data, fetch->numBytes);
+    ReportScoreRanks(client.inFlight, response.c_str());
+    client.inFlight.clear();
+    client.busy = false;
+    emscripten_fetch_close(fetch);
+    PostScoreBatch(client);  // Anything that finished while this was out
+}
+
+inline void OnScoresFailed(emscripten_fetch_t* fetch)
+{
+    LeaderboardClient& client = *static_cast<LeaderboardClient*>(fetch->userData);
+    printf("Leaderboard unreachable (HTTP %d), keeping %zu scores\n", fetch->status, client.inFlight.size());
+    for (const PendingScore& score : client.queue) QueueScore(client.inFlight, score);
+    client.queue.swap(client.inFlight);
+    client.inFlight.clear();
+    client.busy = false;
+    emscripten_fetch_close(fetch);
+}
+
+inline void PostScoreBatch(LeaderboardClient& client)
+{
+    if (client.busy || client.queue.empty()) return;
+
+    client.inFlight.clear();
+    TakeScoreBatch(client.queue, client.inFlight);
+    client.body = FormatScoreBatch(client.inFlight, client.name);
+    client.busy = true;
+
+    // text/plain keeps it a simple CORS request, no preflight
+    static const char* headers[] = {"Content-Type", "text/plain", nullptr};
+    emscripten_fetch_attr_t attr;
+    emscripten_fetch_attr_init(&attr);
+    strcpy(attr.requestMethod, "POST");
+    attr.attributes = EMSCRIPTEN_FETCH_LOAD_TO_MEMORY;
+    attr.requestHeaders = headers;
+    attr.requestData = client.body.c_str();
+    attr.requestDataSize = client.body.size();
+    attr.userData = &client;
+    attr.onsuccess = OnScoresPosted;
+    attr.onerror = OnScoresFailed;
+    emscripten_fetch(&attr, (client.url + "/scores").c_str());
+}
+
+// url empty disables submission
+inline void StartLeaderboardClient(LeaderboardClient& client, const char* url, const char* name)
+{
+    client.enabled = url && *url;
+    if (!client.enabled) return;
+    client.url = url;
+    client.name = name;
+    client.busy = false;
+    printf("Submitting scores to %s as %s\n", url, name);
+}
+
+// replay is the whole replay file of the run
+inline void SubmitScore(LeaderboardClient& client, uint32_t seed, uint32_t timeMs, const std::vector<uint8_t>& replay)
+{
+    if (!client.enabled) return;
+    QueueScore(client.queue, MakePendingScore(seed, timeMs, replay));
+    PostScoreBatch(client);
+}
+
+// drain does nothing here, the page stays open and in-flight fetches finish on their own
+inline void StopLeaderboardClient(LeaderboardClient& client, bool drain)
+{
+    (void)drain;
+    client.enabled = false;
+}
+
+#else
+
+// One POST with everything given, true if the server took it
+inline bool PostScoreBatch(const std::string& host, int port, const std::vector<PendingScore>& scores,
+                           const std::string& name)
+{
+    NetSocket sock = NetConnect(host.c_str(), port);
+    if (sock == NET_INVALID_SOCKET) return false;
+
+    std::string body = FormatScoreBatch(scores, name);
+    char header[256];
+    int length = snprintf(header, sizeof(header),
+        "POST /scores HTTP/1.0\r\nHost: %s\r\nContent-Type: text/plain\r\nContent-Length: %zu\r\n\r\n",
+        host.c_str(), body.size());
+
+    HttpMessage response;
+    bool ok = NetSendAll(sock, header, length) && NetSendAll(sock, body.data(), body.size()) &&
+              NetReadHttp(sock, response) && response.startLine.find(" 200 ") != std::string::npos;
+    NetClose(sock);
+
+    if (ok) ReportScoreRanks(scores, response.body.c_str());
+    return ok;
+}
+
+inline void LeaderboardWorker(LeaderboardClient* client)
+{
+    std::vector<PendingScore> batch;
+    std::unique_lock<std::mutex> lock(client->mutex);
+    for (;;)
+    {
+        if (client->queue.empty() || (client->quit && !client->drain))
+        {
+            if (client->quit) break;
+            client->wake.wait(lock);
+            continue;
+        }
+
+        TakeScoreBatch(client->queue, batch);
+        lock.unlock();
+        bool sent = PostScoreBatch(client->host, client->port, batch, client->name);
+        lock.lock();
+
+        if (sent)
+        {
+            batch.clear();
+            continue;
+        }
+        if (client->quit)
+        {
+            printf("Leaderboard unreachable, dropping %zu scores\n", batch.size() + client->queue.size());
+            client->queue.clear();
+            break;
+        }
+
+        // Put the batch back in front of whatever arrived meanwhile, new scores don't cut the wait short
+        printf("Leaderboard unreachable, keeping %zu scores\n", batch.size());
+        for (const PendingScore& score : client->queue) QueueScore(batch, score);
+        client->queue.swap(batch);
+        batch.clear();
+        client->wake.wait_for(lock, std::chrono::seconds(LEADERBOARD_RETRY_SECONDS), [client] { return client->quit; });
+    }
+}
+
+// address is HOST:PORT, nullptr disables submission
+inline void StartLeaderboardClient(LeaderboardClient& client, const char* address, const char* name)
+{
+    client.enabled = false;
+    if (!address) return;
+
+    const char* colon = strrchr(address, ':');
+    if (!colon || !NetInit())
+    {
+        printf("Leaderboard address should be HOST:PORT, not %s\n", address);
+        return;
+    }
+    client.host.assign(address, colon);
+    client.port = atoi(colon + 1);
+    client.name = name;
+    client.quit = false;
+    client.drain = false;
+    client.enabled = true;
+    client.worker = std::thread(LeaderboardWorker, &client);
+    printf("Submitting scores to %s as %s\n", address, name);
+}
+
+// replay is the whole replay file of the run
+inline void SubmitScore(LeaderboardClient& client, uint32_t seed, uint32_t timeMs, const std::vector<uint8_t>& replay)
+{
+    if (!client.enabled) return;
+    PendingScore score = MakePendingScore(seed, timeMs, replay);
+    {
+        std::lock_guard<std::mutex> lock(client.mutex);
+        QueueScore(client.queue, score);
+    }
+    client.wake.notify_one();
+}
+
+// Without drain, scores still queued are lost. With it the worker first posts them, once
+// each, and drops them if the server does not answer. A blocked connect holds this up to
+// NET_TIMEOUT_MS per batch.
+inline void StopLeaderboardClient(LeaderboardClient& client, bool drain)
+{
+    if (!client.enabled) return;
+    {
+        std::lock_guard<std::mutex> lock(client.mutex);
+        client.quit = true;
+        client.drain = drain;
+    }
+    client.wake.notify_one();
+    client.worker.join();
+    client.enabled = false;
+}
+
+#endif
+
+#endif // LEADERBOARD_CLIENT_H
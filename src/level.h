@@ -0,0 +1,305 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+// Seeded level layout. Shared by the game and the headless tools, so no SDL in here.
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "physics.h"
+
+#define BRANCH_SPACING 150  // Vertical space between branches
+
+// Branch spacing, extension and SQUIRREL_SCALE are tunables (see tunables.h)
+#define BRANCH_HEIGHT 200             // Height of branch texture
+
+#define NUM_BRANCH_TYPES 3
+#define POSITIONS_PER_BRANCH 2
+
+#define DEFAULT_LEVEL_SEED 2
+
+const int TOTAL_HEIGHT_IN_SCREENS = 10;
+const float TOTAL_GAME_HEIGHT = WINDOW_HEIGHT * TOTAL_HEIGHT_IN_SCREENS;
+
+const int NEST_SIZE = 64;
+#define NEST_Y 74
+
+enum {
+    SPRITE_SQUIRREL_WITHOUT_EGG_0,
+    SPRITE_SQUIRREL_WITH_EGG_1,
+    SPRITE_SQUIRREL_TO_LAUNCH_2,
+    SPRITE_SQUIRREL_TO_LAUNCH_3,
+    SPRITE_SQUIRREL_TO_LAUNCH_4,
+    SPRITE_SQUIRREL_MAX_VALUE // SHOULD ALWAYS BE THE LAST
+};
+
+const char* const g_SquirrelSpritePaths[SPRITE_SQUIRREL_MAX_VALUE] = {
+    "assets/squirrel/squirrel_without_egg_1.png",
+    "assets/squirrel/sprite_esquilo-holding_egg.png",
+    "assets/squirrel/sprite_esquilo-launch_1.png",
+    "assets/squirrel/sprite_esquilo-launch_2.png",
+    "assets/squirrel/sprite_esquilo-launch_3.png"
+};
+
+// Define the relative positions for squirrels on each branch type
+struct BranchPosition {
+    float x;  // Relative X position from branch start
+    float y;  // Relative Y position from branch top
+};
+
+// Array to store possible positions for each branch type
+// You'll need to fill these values based on your branch PNGs
+const BranchPosition g_BranchPositions[NUM_BRANCH_TYPES][POSITIONS_PER_BRANCH] = {
+    // Branch Type 1 positions
+    {
+        {.0f, 40.0f},    // Fill with actual values for position 1
+        {100.0f, 45.0f}     // Fill with actual values for position 2
+    },
+    // Branch Type 2 positions
+    {
+        {40.0f, 40.0f},    // Fill with actual values for position 1
+        {140.0f, 50.0f}     // Fill with actual values for position 2
+    },
+    // Branch Type 3 positions
+    {
+        {60.0f, 30.0f},    // Fill with actual values for position 1
+        {80.0f, 70.0f}     // Fill with actual values for position 2
+    }
+};
+
+// Generation knobs, defaulting to the hand tuned values above.
+// The fuzzer overrides these to sweep the parameter space.
+struct LevelParams {
+    float minBranchSpacing;
+    float maxBranchSpacing;
+    float minBranchExtension;
+    float maxBranchExtension;
+    float totalHeight;
+};
+
+inline LevelParams DefaultLevelParams()
+{
+    LevelParams params = {
+        MIN_BRANCH_SPACING,
+        MAX_BRANCH_SPACING,
+        MIN_BRANCH_EXTENSION,
+        MAX_BRANCH_EXTENSION,
+        TOTAL_GAME_HEIGHT
+    };
+    return params;
+}
+
+// Why params cannot build a level, nullptr if they can. Spacing of 0 would stack
+// branches at one height forever.
+inline const char* LevelParamsProblem(const LevelParams& params)
+{
+    if (!(params.minBranchSpacing > 0.0f)) return "branch spacing must be above 0";
+    if (!(params.maxBranchSpacing >= params.minBranchSpacing)) return "max branch spacing is below the min";
+    if (!(params.minBranchExtension > 0.0f)) return "branch extension must be above 0";
+    if (!(params.maxBranchExtension >= params.minBranchExtension)) return "max branch extension is below the min";
+    return nullptr;
+}
+
+// Scaled squirrel sprite sizes, indexed by SPRITE_SQUIRREL_*
+struct SquirrelMetrics {
+    int spriteWidths[SPRITE_SQUIRREL_MAX_VALUE];
+    int spriteHeights[SPRITE_SQUIRREL_MAX_VALUE];
+};
+
+// Reads the size straight from the PNG IHDR chunk, for tools that never load SDL_image
+inline bool ReadPngSize(const char* path, int& width, int& height)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    unsigned char header[24];
+    size_t read = fread(header, 1, sizeof(header), file);
+    fclose(file);
+
+    static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    if (read != sizeof(header)) return false;
+    for (int i = 0; i < 8; i++) {
+        if (header[i] != signature[i]) return false;
+    }
+
+    width  = (header[16] << 24) | (header[17] << 16) | (header[18] << 8) | header[19];
+    height = (header[20] << 24) | (header[21] << 16) | (header[22] << 8) | header[23];
+    return true;
+}
+
+inline bool LoadSquirrelMetricsFromPng(SquirrelMetrics& metrics)
+{
+    for (int i = 0; i < SPRITE_SQUIRREL_MAX_VALUE; i++) {
+        int width, height;
+        if (!ReadPngSize(g_SquirrelSpritePaths[i], width, height)) {
+            printf("Failed to read PNG size of %s\n", g_SquirrelSpritePaths[i]);
+            return false;
+        }
+        metrics.spriteWidths[i] = static_cast<int>(width * SQUIRREL_SCALE);
+        metrics.spriteHeights[i] = static_cast<int>(height * SQUIRREL_SCALE);
+    }
+    return true;
+}
+
+// splitmix64. Unlike rand(), gives the same level for a seed on MinGW, Linux and wasm.
+struct LevelRng {
+    uint64_t state;
+};
+
+inline uint32_t LevelRngNext(LevelRng& rng)
+{
+    uint64_t z = (rng.state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return static_cast<uint32_t>((z ^ (z >> 31)) >> 32);
+}
+
+// Uniform float in [0, 1]
+inline float LevelRngFloat(LevelRng& rng)
+{
+    return static_cast<float>(LevelRngNext(rng) >> 8) / 16777215.0f;
+}
+
+struct LevelBranch {
+    float x, y;
+    int extension;
+    int branchType;
+    bool isLeft;
+};
+
+struct LevelSquirrel {
+    float x, y;
+    bool isLeftSide;
+    int positionIndex;
+};
+
+// Branches and squirrels are stored bottom to top, squirrels[i] sits on branches[i]
+struct Level {
+    std::vector<LevelBranch> branches;
+    std::vector<LevelSquirrel> squirrels;
+};
+
+// Endless mode builds the tower in fixed height chunks, stacked upwards from chunk 0
+// (the one holding the floor squirrel). Chunk coordinates are local: y runs from 0 at
+// the chunk top to LEVEL_CHUNK_HEIGHT at its bottom, so they stay small however high
+// the chunk sits and the game rebases them into its floating world origin.
+#define LEVEL_CHUNK_HEIGHT (WINDOW_HEIGHT * 2)
+#define LEVEL_CHUNK_MAX_BRANCHES 32
+#define LEVEL_MAX_BRANCHES 256  // A whole level, the simulation's pools hold this many
+
+struct LevelChunk {
+    int index;
+    int count;  // branches[i] carries squirrels[i]
+    LevelBranch branches[LEVEL_CHUNK_MAX_BRANCHES];
+    LevelSquirrel squirrels[LEVEL_CHUNK_MAX_BRANCHES];
+};
+
+// Generation state carried from one chunk to the next, so branch spacing and side
+// alternation continue seamlessly across chunk borders. Chunks must be generated in order.
+struct LevelChunkCursor {
+    LevelRng rng;
+    int nextIndex;
+    float nextBranchHeight;  // Height of the next branch above the next chunk's bottom
+    bool isLeft;
+};
+
+inline void StartLevelChunks(uint32_t seed, LevelChunkCursor& cursor)
+{
+    cursor.rng.state = seed;
+    cursor.nextIndex = 0;
+    cursor.nextBranchHeight = WINDOW_HEIGHT*0.5f;  // Start above floor squirrel
+    cursor.isLeft = false;  // always start with branch on the right
+}
+
+inline void GenerateLevelChunk(LevelChunkCursor& cursor, const LevelParams& params,
+                               const SquirrelMetrics& metrics, LevelChunk& chunk)
+{
+    chunk.index = cursor.nextIndex++;
+    chunk.count = 0;
+
+    int defaultWidth = metrics.spriteWidths[SPRITE_SQUIRREL_WITHOUT_EGG_0];
+
+    while (cursor.nextBranchHeight < LEVEL_CHUNK_HEIGHT && chunk.count < LEVEL_CHUNK_MAX_BRANCHES)
+    {
+        float currentHeight = LEVEL_CHUNK_HEIGHT - cursor.nextBranchHeight;
+
+        float spacing = params.minBranchSpacing +
+            LevelRngFloat(cursor.rng) * (params.maxBranchSpacing - params.minBranchSpacing);
+        float extension = params.minBranchExtension +
+            LevelRngFloat(cursor.rng) * (params.maxBranchExtension - params.minBranchExtension);
+        float branchX = !cursor.isLeft ? TREE_WIDTH : WINDOW_WIDTH - TREE_WIDTH - extension;
+        int branchType = LevelRngNext(cursor.rng) % NUM_BRANCH_TYPES;
+        int positionIndex = LevelRngNext(cursor.rng) % POSITIONS_PER_BRANCH;
+
+        LevelBranch& branch = chunk.branches[chunk.count];
+        branch.x = branchX;
+        branch.y = currentHeight;
+        branch.extension = static_cast<int>(extension);
+        branch.branchType = branchType;
+        branch.isLeft = cursor.isLeft;
+
+        LevelSquirrel& squirrel = chunk.squirrels[chunk.count];
+        squirrel.x = branchX + g_BranchPositions[branchType][positionIndex].x;
+        squirrel.y = currentHeight + g_BranchPositions[branchType][positionIndex].y;
+        if (!cursor.isLeft) {
+            squirrel.x = branchX + extension - defaultWidth - g_BranchPositions[branchType][positionIndex].x;
+        }
+        squirrel.isLeftSide = !cursor.isLeft;
+        squirrel.positionIndex = positionIndex;
+
+        chunk.count++;
+        cursor.nextBranchHeight += spacing;
+        cursor.isLeft = !cursor.isLeft;
+    }
+
+    cursor.nextBranchHeight -= LEVEL_CHUNK_HEIGHT;
+}
+
+// The level is the endless tower's first chunks, stacked from the floor and cut off
+// near the top, so both modes share one generator. Never more than LEVEL_MAX_BRANCHES,
+// whatever the params.
+inline void GenerateLevel(uint32_t seed, const LevelParams& params, const SquirrelMetrics& metrics, Level& level)
+{
+    level.branches.clear();
+    level.squirrels.clear();
+
+    LevelChunkCursor cursor;
+    StartLevelChunks(seed, cursor);
+    LevelChunk chunk;
+    while (true)
+    {
+        GenerateLevelChunk(cursor, params, metrics, chunk);
+        float chunkTop = params.totalHeight - (chunk.index + 1) * LEVEL_CHUNK_HEIGHT;
+        for (int i = 0; i < chunk.count; i++)
+        {
+            LevelBranch branch = chunk.branches[i];
+            LevelSquirrel squirrel = chunk.squirrels[i];
+            branch.y += chunkTop;
+            squirrel.y += chunkTop;
+            if (branch.y <= 100) return;  // Leave the top to the nest
+            if (level.branches.size() >= LEVEL_MAX_BRANCHES) return;
+
+            level.branches.push_back(branch);
+            level.squirrels.push_back(squirrel);
+        }
+    }
+}
+
+// Floor squirrel sits at the bottom of the total height plus an offset
+inline void FloorSquirrelPosition(const SquirrelMetrics& metrics, float totalHeight, float& x, float& y)
+{
+    int defaultWidth = metrics.spriteWidths[SPRITE_SQUIRREL_WITHOUT_EGG_0];
+    int defaultHeight = metrics.spriteHeights[SPRITE_SQUIRREL_WITHOUT_EGG_0];
+
+    x = static_cast<float>(WINDOW_WIDTH / 2 - defaultWidth / 2) - 40;
+    y = totalHeight - defaultHeight - 60;
+}
+
+inline SimRect NestRect()
+{
+    SimRect nest = {(WINDOW_WIDTH - NEST_SIZE) / 2, NEST_Y, NEST_SIZE, NEST_SIZE};
+    return nest;
+}
+
+#endif // LEVEL_H
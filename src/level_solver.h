@@ -0,0 +1,248 @@
+#ifndef LEVEL_SOLVER_H
+#define LEVEL_SOLVER_H
+
+// Brute force solvability check for a generated level.
+// From the floor squirrel and every branch squirrel we fire a grid of launches
+// (charge x angle x direction) through the same StepEggFlight the game uses and
+// record which squirrel, if any, catches the egg first. A shortest path over the
+// resulting graph gives the par time; the nest has to be reachable for the level
+// to count as solvable. Only catches above the launch point are followed, so this
+// is an estimate of the intended route rather than a full search.
+// Difficulty is judged on a different route from par: the one whose hardest jump is
+// the most forgiving (the widest path). The fastest route likes barely possible skips
+// that a player never has to take, so its hardest jump says nothing about the level.
+
+#include <algorithm>
+#include <vector>
+
+#include "level.h"
+
+struct LevelSolverOptions {
+    int chargeSamples;    // Charge values tried, evenly spread over the reachable charge steps
+    int angleSamples;     // Launch angles tried between 0 and 90 degrees
+    int maxFlightFrames;  // Give up on a launch after this many frames
+};
+
+inline LevelSolverOptions DefaultLevelSolverOptions()
+{
+    LevelSolverOptions options = {12, 8, 240};
+    return options;
+}
+
+struct LevelStats {
+    bool solvable;
+    int branchCount;
+    float minGap, maxGap, meanGap;  // Vertical spacing between consecutive branches
+    float hardestJumpRatio;         // Share of sampled launches that land the jump every route needs at least
+    float hardestJumpGap;           // Vertical distance covered by that jump, on the most forgiving route
+    int parFrames;                  // Charge + flight frames along the fastest route, -1 if unsolvable
+};
+
+struct SolverEdge {
+    int target;
+    int hits;      // Sampled launches that end on target
+    int bestCost;  // Fastest of those, in frames
+};
+
+// Fires one launch and returns the node that catches the egg (see AnalyzeLevel for
+// the node numbering), or -1 on a miss. flightFrames receives the frames flown.
+inline int SimulateSolverLaunch(float eggX, float eggY, float velocityX, float velocityY,
+                                int sourceNode, const std::vector<SimRect>& squirrelRects,
+                                const std::vector<int>& candidates, int nestNode,
+                                float totalHeight, float giveUpY, int maxFlightFrames, int& flightFrames)
+{
+    SimRect leftTree = {0, 0, TREE_WIDTH, static_cast<int>(totalHeight)};
+    SimRect rightTree = {WINDOW_WIDTH - TREE_WIDTH, 0, TREE_WIDTH, static_cast<int>(totalHeight)};
+    SimRect nest = NestRect();
+
+    for (int frame = 1; frame <= maxFlightFrames; frame++)
+    {
+        SimRect eggRect;
+        StepEggFlight(eggX, eggY, velocityX, velocityY, EGG_SIZE_X, EGG_SIZE_Y, leftTree, rightTree, eggRect);
+        flightFrames = frame;
+
+        // Same order as UpdatePhysics: squirrels, then misses, then the nest
+        for (int node : candidates)
+        {
+            if (node != sourceNode && RectsOverlap(eggRect, squirrelRects[node]))
+                return node;
+        }
+
+        if (eggY > totalHeight - EGG_SIZE_Y || eggX < -EGG_SIZE_X || eggX > WINDOW_WIDTH)
+            return -1;
+
+        if (RectsOverlap(eggRect, nest))
+            return nestNode;
+
+        // Once falling past giveUpY only lower squirrels are left to catch it
+        if (velocityY > 0 && eggY > giveUpY)
+            return -1;
+    }
+    return -1;
+}
+
+// Branch count and vertical spacing between consecutive branches
+inline void ComputeGapStats(const Level& level, LevelStats& stats)
+{
+    stats.branchCount = static_cast<int>(level.branches.size());
+    if (level.branches.size() < 2) return;
+
+    stats.minGap = 1e9f;
+    float total = 0;
+    for (size_t i = 1; i < level.branches.size(); i++)
+    {
+        float gap = level.branches[i - 1].y - level.branches[i].y;
+        stats.minGap = std::min(stats.minGap, gap);
+        stats.maxGap = std::max(stats.maxGap, gap);
+        total += gap;
+    }
+    stats.meanGap = total / (level.branches.size() - 1);
+}
+
+// Node 0 is the floor squirrel, node i + 1 is level.squirrels[i], the last node is the nest
+inline LevelStats AnalyzeLevel(const Level& level, const SquirrelMetrics& metrics,
+                               const LevelParams& params, const LevelSolverOptions& options)
+{
+    LevelStats stats = {};
+    stats.parFrames = -1;
+    ComputeGapStats(level, stats);
+
+    int squirrelCount = static_cast<int>(level.squirrels.size());
+    int nodeCount = squirrelCount + 2;
+    int nestNode = nodeCount - 1;
+    int width = metrics.spriteWidths[SPRITE_SQUIRREL_WITHOUT_EGG_0];
+    int height = metrics.spriteHeights[SPRITE_SQUIRREL_WITHOUT_EGG_0];
+
+    std::vector<SimRect> rects(nodeCount);
+    std::vector<bool> isLeftSide(nodeCount);
+    float floorX, floorY;
+    FloorSquirrelPosition(metrics, params.totalHeight, floorX, floorY);
+    rects[0] = {static_cast<int>(floorX), static_cast<int>(floorY), width, height};
+    isLeftSide[0] = true;
+    for (int i = 0; i < squirrelCount; i++)
+    {
+        const LevelSquirrel& squirrel = level.squirrels[i];
+        rects[i + 1] = {static_cast<int>(squirrel.x), static_cast<int>(squirrel.y), width, height};
+        isLeftSide[i + 1] = squirrel.isLeftSide;
+    }
+
+    // Highest point an egg can reach: v^2 / 2g at full power, plus a margin for the egg itself
+    float maxRise = (LAUNCH_POWER_SCALE * LAUNCH_POWER_SCALE) / (2 * GRAVITY) + EGG_SIZE_Y;
+    int maxChargeSteps = static_cast<int>(1.0f / STRENGTH_CHARGE_RATE) + 1;
+    int chargeSamples = std::max(1, std::min(options.chargeSamples, maxChargeSteps));
+    int angleSamples = std::max(1, options.angleSamples);
+    int launchesPerNode = chargeSamples * angleSamples * 2;
+
+    std::vector<std::vector<SolverEdge>> edges(nodeCount);
+    std::vector<int> candidates;
+    for (int node = 0; node < nestNode; node++)
+    {
+        float eggX, eggY;
+        EggCatchPosition(rects[node].x, rects[node].y, width, isLeftSide[node], node == 0,
+                         EGG_SIZE_X, EGG_SIZE_Y, eggX, eggY);
+
+        // Below this line the egg can no longer be caught by anything higher up
+        int nextNode = node + 1;
+        float giveUpY = nextNode == nestNode ? NEST_Y + NEST_SIZE : rects[nextNode].y + height;
+
+        // Only squirrels within jumping reach are worth testing against
+        candidates.clear();
+        for (int other = 0; other < nestNode; other++)
+        {
+            if (rects[other].y > eggY - maxRise - height && rects[other].y < eggY + BRANCH_HEIGHT + EGG_SIZE_Y)
+                candidates.push_back(other);
+        }
+
+        for (int c = 1; c <= chargeSamples; c++)
+        {
+            // Charge only ever takes values in STRENGTH_CHARGE_RATE steps, one per frame held
+            int chargeFrames = (c * maxChargeSteps) / chargeSamples;
+            float charge = std::min(1.0f, chargeFrames * STRENGTH_CHARGE_RATE);
+
+            for (int a = 0; a < angleSamples; a++)
+            {
+                float angle = angleSamples > 1 ? (PI / 2) * a / (angleSamples - 1) : PI / 4;
+
+                for (int direction = 0; direction < 2; direction++)
+                {
+                    float velocityX, velocityY;
+                    LaunchVelocity(charge, angle, direction == 0, velocityX, velocityY);
+
+                    // Apex of a free flight; bouncing off a tree only lowers it
+                    float apexY = eggY - velocityY * velocityY / (2 * GRAVITY);
+                    if (apexY > giveUpY) continue;
+
+                    int flightFrames = 0;
+                    int target = SimulateSolverLaunch(eggX, eggY, velocityX, velocityY, node, rects,
+                                                      candidates, nestNode, params.totalHeight, giveUpY,
+                                                      options.maxFlightFrames, flightFrames);
+                    // Only progress upwards counts (node order is bottom to top)
+                    if (target <= node) continue;
+
+                    int cost = chargeFrames + flightFrames;
+                    bool found = false;
+                    for (SolverEdge& edge : edges[node])
+                    {
+                        if (edge.target == target)
+                        {
+                            edge.hits++;
+                            edge.bestCost = std::min(edge.bestCost, cost);
+                            found = true;
+                            break;
+                        }
+                    }
+                    if (!found)
+                        edges[node].push_back({target, 1, cost});
+                }
+            }
+        }
+    }
+
+    // Edges only go upwards, so node order is already a topological order
+    const int unreachable = 0x7fffffff;
+    std::vector<int> best(nodeCount, unreachable);
+    std::vector<int> from(nodeCount, -1);
+    best[0] = 0;
+    for (int node = 0; node < nestNode; node++)
+    {
+        if (best[node] == unreachable) continue;
+        for (const SolverEdge& edge : edges[node])
+        {
+            if (best[node] + edge.bestCost < best[edge.target])
+            {
+                best[edge.target] = best[node] + edge.bestCost;
+                from[edge.target] = node;
+            }
+        }
+    }
+
+    stats.solvable = best[nestNode] != unreachable;
+    if (!stats.solvable)
+        return stats;
+
+    stats.parFrames = best[nestNode];
+
+    // Widest path: for every node the best hardest-jump ratio of any route up to it
+    std::vector<float> widest(nodeCount, -1.0f);
+    std::vector<float> widestGap(nodeCount, 0.0f);  // Gap of that route's hardest jump
+    widest[0] = 1.0f;
+    for (int node = 0; node < nestNode; node++)
+    {
+        if (widest[node] < 0.0f) continue;
+        for (const SolverEdge& edge : edges[node])
+        {
+            float ratio = static_cast<float>(edge.hits) / launchesPerNode;
+            float route = std::min(widest[node], ratio);
+            if (route <= widest[edge.target]) continue;
+
+            float targetY = edge.target == nestNode ? NEST_Y : rects[edge.target].y;
+            widest[edge.target] = route;
+            widestGap[edge.target] = ratio < widest[node] ? rects[node].y - targetY : widestGap[node];
+        }
+    }
+    stats.hardestJumpRatio = widest[nestNode];
+    stats.hardestJumpGap = widestGap[nestNode];
+    return stats;
+}
+
+#endif // LEVEL_SOLVER_H
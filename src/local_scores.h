@@ -0,0 +1,183 @@
+#ifndef LOCAL_SCORES_H
+#define LOCAL_SCORES_H
+
+// Every finished run on this machine, per level seed, with best-N, rank and percentile
+// queries through a ScoreIndex. Stored as a small binary log: each run is appended as
+// one record, and every LOCAL_SCORES_COMPACT_EVERY appends the file is rewritten as one
+// block per seed of sorted, delta coded times, a couple of bytes per run.
+//
+// Layout: magic, version, then records tagged by a varint kind:
+//   LOCAL_SCORES_RUN    seed, time in ms
+//   LOCAL_SCORES_BLOCK  seed, count, count time deltas in ascending order
+
+#include <cstdio>
+#include <map>
+
+#include "encoding.h"
+#include "score_index.h"
+
+#define LOCAL_SCORES_MAGIC 0x534C4B43u  // "CKLS"
+#define LOCAL_SCORES_VERSION 1
+#define LOCAL_SCORES_COMPACT_EVERY 64
+
+enum {
+    LOCAL_SCORES_RUN,
+    LOCAL_SCORES_BLOCK
+};
+
+struct LocalScores {
+    std::map<uint32_t, ScoreIndex> bySeed;
+    uint32_t appendedRuns;  // Single run records since the file was last compacted
+};
+
+inline void AddLocalScore(LocalScores& scores, uint32_t seed, uint32_t timeMs)
+{
+    AddScore(scores.bySeed[seed], timeMs);
+}
+
+// Index for seed, empty if nothing was recorded on it
+inline const ScoreIndex& LocalScoresForSeed(const LocalScores& scores, uint32_t seed)
+{
+    static const ScoreIndex empty;
+    auto found = scores.bySeed.find(seed);
+    return found != scores.bySeed.end() ? found->second : empty;
+}
+
+inline void WriteLocalScoresHeader(ByteWriter& writer)
+{
+    WriteU32(writer, LOCAL_SCORES_MAGIC);
+    WriteByte(writer, LOCAL_SCORES_VERSION);
+}
+
+inline void WriteLocalScoreRun(ByteWriter& writer, uint32_t seed, uint32_t timeMs)
+{
+    WriteVarint(writer, LOCAL_SCORES_RUN);
+    WriteVarint(writer, seed);
+    WriteVarint(writer, timeMs);
+}
+
+// Whole file in compacted form
+inline void EncodeLocalScores(const LocalScores& scores, ByteWriter& writer)
+{
+    writer.bytes.clear();
+    WriteLocalScoresHeader(writer);
+    for (const auto& seedScores : scores.bySeed)
+    {
+        const ScoreIndex& index = seedScores.second;
+        WriteVarint(writer, LOCAL_SCORES_BLOCK);
+        WriteVarint(writer, seedScores.first);
+        WriteVarint(writer, index.count);
+
+        uint32_t previous = 0;
+        for (uint32_t rank = 1; rank <= index.count; rank++)
+        {
+            uint32_t timeMs = 0;
+            ScoreAtRank(index, rank, timeMs);
+            WriteVarint(writer, timeMs - previous);
+            previous = timeMs;
+        }
+    }
+}
+
+// Keeps every whole record, a torn append at the end is dropped. False if not a scores file.
+inline bool DecodeLocalScores(LocalScores& scores, const uint8_t* data, size_t size)
+{
+    scores = LocalScores();
+
+    ByteReader reader;
+    OpenByteReader(reader, data, size);
+    uint32_t magic = 0;
+    uint8_t version = 0;
+    if (!ReadU32(reader, magic) || magic != LOCAL_SCORES_MAGIC ||
+        !ReadByte(reader, version) || version != LOCAL_SCORES_VERSION)
+        return false;
+
+    size_t goodSize = reader.pos;
+    uint32_t kind, seed, value;
+    while (ReadVarint(reader, kind) && ReadVarint(reader, seed) && ReadVarint(reader, value))
+    {
+        if (kind == LOCAL_SCORES_RUN)
+        {
+            AddLocalScore(scores, seed, value);
+            scores.appendedRuns++;
+        }
+        else if (kind == LOCAL_SCORES_BLOCK)
+        {
+            uint32_t timeMs = 0, delta;
+            for (uint32_t i = 0; i < value && ReadVarint(reader, delta); i++)
+            {
+                timeMs += delta;
+                AddLocalScore(scores, seed, timeMs);
+            }
+            if (reader.failed) break;
+        }
+        else
+        {
+            break;
+        }
+        goodSize = reader.pos;
+    }
+
+    // Appending after a torn record would misalign everything after it, compact on the next save
+    if (goodSize < size) scores.appendedRuns = LOCAL_SCORES_COMPACT_EVERY;
+    return true;
+}
+
+// Old "MM:SS.mmm" per line text, from before runs were stored per seed
+inline int ImportTextScores(LocalScores& scores, const char* text, uint32_t seed)
+{
+    int imported = 0;
+    while (*text)
+    {
+        int minutes, seconds, milliseconds;
+        if (sscanf(text, "%d:%d.%d", &minutes, &seconds, &milliseconds) == 3)
+        {
+            AddLocalScore(scores, seed, (minutes * 60 + seconds) * 1000 + milliseconds);
+            imported++;
+        }
+        const char* next = strchr(text, '\n');
+        if (!next) break;
+        text = next + 1;
+    }
+    return imported;
+}
+
+// False if there is no file, the first save then writes a new one
+inline bool LoadLocalScoresFile(LocalScores& scores, const char* path)
+{
+    scores = LocalScores();
+    scores.appendedRuns = LOCAL_SCORES_COMPACT_EVERY;
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    std::vector<uint8_t> bytes;
+    uint8_t buffer[4096];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        bytes.insert(bytes.end(), buffer, buffer + count);
+    fclose(file);
+
+    if (DecodeLocalScores(scores, bytes.data(), bytes.size())) return true;
+
+    scores.appendedRuns = LOCAL_SCORES_COMPACT_EVERY;  // Not a scores file, the next save replaces it
+    return false;
+}
+
+// Adds the run and fills out with what the file needs: true means out replaces the whole
+// file (new file, or enough runs piled up to compact), false means out is appended
+inline bool SaveLocalScore(LocalScores& scores, uint32_t seed, uint32_t timeMs, ByteWriter& out)
+{
+    AddLocalScore(scores, seed, timeMs);
+    if (++scores.appendedRuns >= LOCAL_SCORES_COMPACT_EVERY)
+    {
+        EncodeLocalScores(scores, out);
+        scores.appendedRuns = 0;
+        return true;
+    }
+
+    out.bytes.clear();
+    WriteLocalScoreRun(out, seed, timeMs);
+    return false;
+}
+
+#endif // LOCAL_SCORES_H
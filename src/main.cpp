@@ -1,59 +1,45 @@
 #include <SDL.h>
 #include <SDL_image.h>
-#include <iostream>
+#include <string>
 #include <vector>
 #include <cmath>
 #include <ctime>
 #include <SDL_ttf.h>
-#include <sstream>
-#include <iomanip>
 #include <SDL_mixer.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 #include <cstring>
+#include <thread>
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
 #include <emscripten/html5.h>
 #endif
 
+#include "physics.h"
+#include "level.h"
+#include "endless.h"
+#include "ghost.h"
+#include "simulation.h"
+#include "leaderboard_client.h"
+#include "local_scores.h"
+#include "background_writer.h"
+#include "triple_buffer.h"
+#include "input_queue.h"
+#include "frame_pacer.h"
+#include "hdr_histogram.h"
+
+// Assets decode on worker threads, except in the single threaded web build
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define ASSETS_THREADED 1
+#endif
 
-#define TARGET_FPS 60
-#define FRAME_TIME (1000.0f / TARGET_FPS)
-
-#define WINDOW_WIDTH 800
-#define WINDOW_HEIGHT 600
-#define TREE_WIDTH 75
-#define BRANCH_SPACING 150  // Vertical space between branches
-#define SQUIRREL_SCALE 0.6f  // Adjust this value to scale sprites (1.0f = original size, 0.5f = half size, 2.0f = double size)
-#define EGG_SIZE_SCALE 1.0f
-#define EGG_SIZE_X (int)(50*EGG_SIZE_SCALE)
-#define EGG_SIZE_Y (int)(75*EGG_SIZE_SCALE)
-#define EGG_ANIMATION_SPEED 0.7f  // Adjust speed as needed, measured in seconds
 #define EGG_SPRITE_COUNT 3
-#define GRAVITY 0.5f
-#define TERMINAL_VELOCITY 30.0f
 #define STRENGTH_BAR_WIDTH 10
 #define STRENGTH_BAR_HEIGHT 75
 #define STRENGTH_BAR_X 20
 #define STRENGTH_BAR_Y 550
-#define STRENGTH_CHARGE_RATE 0.03f
-#define ANGLE_BAR_WIDTH 20
-#define ANGLE_BAR_HEIGHT 200
-#define ANGLE_BAR_X 240
-#define ANGLE_BAR_Y 370
-#define ANGLE_SQUARE_SIZE 15
-#define ANGLE_GRAVITY 0.5f
-#define ANGLE_JUMP_POWER 6.0f
-#define LAUNCH_POWER_SCALE 20.0f
-#define PI 3.14159265359f
-
-#define MIN_BRANCH_SPACING (WINDOW_HEIGHT * 0.1f)  // Minimum vertical gap between branches
-#define MAX_BRANCH_SPACING (WINDOW_HEIGHT * 0.5f)  // Maximum vertical gap between branches
-#define MIN_BRANCH_EXTENSION 219.0f   // Minimum distance branch extends from tree
-#define MAX_BRANCH_EXTENSION 350.0f  // Maximum distance branch extends from tree
-#define BRANCH_HEIGHT 200             // Height of branch texture
-
-#define NUM_BRANCH_TYPES 3
-#define POSITIONS_PER_BRANCH 2
 
 #define ARROW_WIDTH 40
 #define ARROW_HEIGHT 15
@@ -64,17 +50,21 @@
 #define INSTRUCTION_FONT_SIZE 20
 #define INSTRUCTION_Y 50  // Adjust this value to position the text where you want
 
-const int TOTAL_HEIGHT_IN_SCREENS = 10;
-const float TOTAL_GAME_HEIGHT = WINDOW_HEIGHT * TOTAL_HEIGHT_IN_SCREENS;
-
-
-const int NEST_SIZE = 64;
 const SDL_Color NEST_COLOR = {34, 139, 34, 255};  // Forest green
 
 #define TIMER_X (WINDOW_WIDTH - 200)
 #define TIMER_Y 20
 
-#define SCORE_FILE "assets/scores.txt"
+#define SCORE_FILE "assets/scores.bin"
+#define LEGACY_SCORE_FILE "assets/scores.txt"  // Imported once into SCORE_FILE
+#define SCORE_BOARD_SIZE 5
+#define GHOST_FILE "assets/ghost.bin"
+#define FRAME_REPORT_FILE "assets/frame_report.txt"
+#define GHOST_ALPHA 96
+#define MAX_STEPS_PER_FRAME 5  // Fixed steps run per rendered frame before falling behind
+#define TUNABLES_POLL_MS 500
+#define ASSET_DECODE_THREADS 4  // The pthread web build's worker pool has room for these
+#define TEXT_CACHE_SIZE 32      // Rendered strings kept as textures
 #define WIN_MESSAGE_X (WINDOW_WIDTH / 2)
 #define WIN_MESSAGE_Y (WINDOW_HEIGHT / 2)
 
@@ -89,27 +79,12 @@ SDL_Texture* g_SquirrelTexture = nullptr;
 SDL_Texture* g_TreeTexture = nullptr;
 SDL_Texture* g_BranchTexture = nullptr;
 SDL_Texture* g_ArrowTexture = nullptr;
-TTF_Font* g_Font = nullptr;
-Uint32 g_StartTime = 0;
-bool g_TimerActive = false;
-bool g_WinAchieved = false;
-Uint32 g_lastElapsedTime = 0;
 
 
 
 SDL_Texture* g_EggTextures[EGG_SPRITE_COUNT] = {nullptr};
-float g_EggAnimationTime = 0.0f;
 
 
-enum {
-    SPRITE_SQUIRREL_WITHOUT_EGG_0,
-    SPRITE_SQUIRREL_WITH_EGG_1,
-    SPRITE_SQUIRREL_TO_LAUNCH_2,
-    SPRITE_SQUIRREL_TO_LAUNCH_3,
-    SPRITE_SQUIRREL_TO_LAUNCH_4,
-    SPRITE_SQUIRREL_MAX_VALUE // SHOULD ALWAYS BE THE LAST
-};
-
 SDL_Texture* g_SquirrelTextures[SPRITE_SQUIRREL_MAX_VALUE] = {nullptr};
 
 // Add to global variables section
@@ -123,105 +98,518 @@ Mix_Chunk* g_WinSound = nullptr;
 Mix_Music* g_BackgroundMusic = nullptr;
 Mix_Chunk* g_LaunchSounds[NUM_LAUNCH_SOUNDS] = {nullptr};
 
-struct GameObject {
-    float x, y;
-    int width, height;
-    SDL_Texture* texture;
-    bool isLeftSide;  // Used for squirrels to determine which side they're on
-    int currentSprite = 0;
-    int spriteWidths[SPRITE_SQUIRREL_MAX_VALUE] = {0};
-    int spriteHeights[SPRITE_SQUIRREL_MAX_VALUE] = {0};
-    int branchType;      // For branches: which type of branch (0-2)
-    int positionIndex;   // For squirrels: which position on the branch (0-1)
-    float animationTimer;  // Track animation duration, measured in seconds
-    bool hasEgg;          // Track if squirrel has egg
+static_assert(LEVEL_ENTITY_CAPACITY >= ENDLESS_POOL_SIZE * LEVEL_CHUNK_MAX_BRANCHES, "endless chunks must fit");
+
+// Endless mode streams the tower in LEVEL_CHUNK_HEIGHT chunks (see endless.h).
+// World y is relative to the top of originChunk: once the egg climbs into another
+// chunk everything is shifted by whole chunks, so coordinates never grow with the climb.
+struct EndlessState {
+    ChunkStreamer streamer;
+    LevelChunk* resident[ENDLESS_POOL_SIZE];  // Bottom to top, same order as the objects in GameState
+    int residentCount;
+    int originChunk;
+    int bestHeight;  // In pixels above the floor
 };
 
-struct GameState {
+// Best run on this seed, drawn as a translucent egg next to the live one (see ghost.h)
+struct GhostState {
+    GhostRecorder recorder;
+    GhostPlayer player;
     GameObject egg;
-    float eggVelocityY;  // Vertical velocity of egg
-    float eggVelocityX;  // Add horizontal velocity
-    bool eggIsHeld;      // Whether a squirrel is holding the egg
-    std::vector<GameObject> squirrels;
-    std::vector<GameObject> branches;
-    GameObject leftTree;
-    GameObject rightTree;
-    float strengthCharge;     // 0.0 to 1.0
-    bool isCharging;         // Is left mouse being held
-    bool isDepletingCharge;  // Has charge maxed out
-    float angleSquareY;      // Position in the angle bar
-    float angleSquareVelocity;
-    GameObject floorSquirrel;  // New floor squirrel
-    bool isLaunchingRight;  // Direction flag
-    GameObject* activeSquirrel = nullptr;  // Pointer to squirrel currently holding egg
-    float cameraY;  // Vertical camera offset
-    float targetCameraY;  // Target position for smooth scrolling
-    int currentEggSprite = 0;
-    GameObject nest;
-    bool isInNest;  // New flag to track if egg is in starting position
-    bool isFirstFall = 1;
-} g_GameState;
-
-// Define the relative positions for squirrels on each branch type
-struct BranchPosition {
-    float x;  // Relative X position from branch start
-    float y;  // Relative Y position from branch top
+    bool visible;
+};
+
+// Session recording and playback (see replay.h), indexed by GameState::frame
+struct ReplayState {
+    ReplayRecorder recorder;
+    ReplayPlayer player;
+    const char* recordPath = nullptr;
+    bool playing;
+};
+
+// Every run on this machine (see local_scores.h), and the lines of the scores box.
+// The lines are rebuilt when a run is added, not every frame.
+struct ScoreBoard {
+    LocalScores scores;
+    std::vector<std::string> lines;
+    uint32_t lastTime;  // 0 until a run finishes this session
+};
+
+// One game: the simulation and everything that goes with a run of it. Functions that
+// update a game take it as a parameter rather than reaching for globals, so several
+// can live in one process. SDL, the assets and the frame loop are shared by all of them.
+struct GameContext {
+    GameState state;
+    EndlessState endless;
+    GhostState ghost;
+    ReplayState replay;
+    ScoreBoard scoreBoard;
+
+    // Input events with their SDL timestamps, from the event loop to SimulateFrame, which
+    // applies each one at its time within the step (see input_queue.h)
+    InputQueue input;
+    uint32_t appliedInputMs;  // Written by whoever steps the simulation, read through the snapshot
+
+    uint32_t levelSeed = DEFAULT_LEVEL_SEED;
+    bool endlessMode = false;
+#ifdef __EMSCRIPTEN__
+    bool fixedPhysics = true;  // Web runs are the ones submitted, and verified on other platforms
+#else
+    bool fixedPhysics = false;
+#endif
+    Uint32 lastElapsedTime = 0;  // Run time of the last win
+
+    // Stepping, kept by whoever steps the simulation
+    float accumulator = 0.0f;      // Real time not yet simulated, in ms
+    Uint32 lastTunablesPoll = 0;
+    uint32_t frameLimit = 0;       // Stop after this many frames (--frames), 0 runs until told to stop
+};
+
+GameContext g_Game;  // The one this executable plays
+
+// Everything Render reads, copied out of the simulation after it steps. Render never
+// touches the live state, so the simulation can run on its own thread (--threaded-sim).
+struct RenderSnapshot {
+    GameState game;
+    GameObject ghostEgg;
+    bool ghostVisible;
+    float endlessFloorBottom;
+    int endlessBestHeight;
+    uint32_t lastElapsedTime;
+    uint32_t appliedInputMs;  // Timestamp of the latest input the simulation showed a reaction to
+    std::vector<std::string> scoreLines;
+};
+
+const RenderSnapshot* g_View = nullptr;  // What this frame draws
+
+// --golden-check / --golden-update: fixed scenes drawn by the software renderer and
+// compared with reference images
+struct GoldenRun {
+    const char* dir;       // Reference images live here as <scene>.png
+    bool update;           // Write the images instead of comparing
+    SDL_Surface* surface;  // The software renderer draws here
+} g_Golden;
+
+// Strings drawn as textures, rasterized once and reused while they stay on screen.
+// Fonts are opened once per size.
+struct CachedText {
+    std::string text;
+    int fontSize;
+    SDL_Texture* texture;
+    int width, height;
+    uint32_t lastUsed;  // Render count when last drawn
+};
+
+struct TextCache {
+    std::vector<CachedText> entries;
+    std::vector<std::pair<int, TTF_Font*>> fonts;  // By point size
+    uint32_t renderCount;
+} g_TextCache;
+
+#ifndef __EMSCRIPTEN__
+// Scores, ghosts and replays are written from here, never on the frame (see background_writer.h)
+BackgroundWriter g_Writer;
+#endif
+
+// Online scores (see leaderboard_client.h), off unless a server is given
+LeaderboardClient g_Leaderboard;
+
+// Renderer work per frame, counted where it reaches SDL (see the draw buffer below).
+// --bench and the frame report show the counts.
+struct RenderCounters {
+    uint32_t commands;          // Copies and fills recorded, before batching
+    uint32_t drawCalls;         // Geometry batches and clears submitted to SDL
+    uint32_t textureSwitches;   // Batches with another texture than the previous batch
+    uint32_t stateChanges;      // Draw color set on the renderer
+    uint32_t textureCreations;
+};
+
+struct RenderStats {
+    RenderCounters frame;      // Being counted
+    RenderCounters lastFrame;  // Finished at the last present
+    RenderCounters total;      // Whole session
+    RenderCounters max;        // Worst single frame of each
+    uint32_t frames;
+    SDL_Texture* lastTexture;
+} g_RenderStats;
+
+// Draws are recorded, not sent. Render flushes them once per frame: sorted by layer, then
+// by texture within a layer, and submitted with SDL_RenderGeometry, one call per run of
+// commands sharing a texture. Within a layer, textures go in order of first use and
+// commands with the same texture keep their recording order, so a layer only has to hold
+// things that do not overlap in a way that matters (the squirrels, the tiles of the
+// background, a text box and its lines).
+#define DRAW_COMMAND_CAPACITY 1024  // Flushed early if a frame ever records more
+
+// In the order Render draws them
+enum {
+    DRAW_LAYER_BACKGROUND,
+    DRAW_LAYER_BRANCHES,
+    DRAW_LAYER_SQUIRRELS,
+    DRAW_LAYER_NEST,
+    DRAW_LAYER_FLOOR_SQUIRREL,
+    DRAW_LAYER_GHOST,
+    DRAW_LAYER_EGG,
+    DRAW_LAYER_ARROW,
+    DRAW_LAYER_CONTROLS,
+    DRAW_LAYER_INSTRUCTIONS,
+    DRAW_LAYER_SCORES,
+    DRAW_LAYER_TIMER,
+    DRAW_LAYER_OVERLAY
 };
 
-// Array to store possible positions for each branch type
-// You'll need to fill these values based on your branch PNGs
-BranchPosition g_BranchPositions[NUM_BRANCH_TYPES][POSITIONS_PER_BRANCH] = {
-    // Branch Type 1 positions
+struct DrawCommand {
+    uint32_t key;           // layer << 16 | texture slot, sorted on
+    SDL_Texture* texture;   // nullptr fills with color
+    SDL_FRect dest;
+    float angle;            // Degrees clockwise around center
+    SDL_FPoint center;      // Relative to dest
+    SDL_RendererFlip flip;
+    SDL_Color color;        // Fill color, or the texture's tint and alpha
+};
+
+struct DrawBuffer {
+    DrawCommand commands[DRAW_COMMAND_CAPACITY];
+    uint16_t order[DRAW_COMMAND_CAPACITY];
+    uint16_t scratch[DRAW_COMMAND_CAPACITY];
+    int count;
+    SDL_Texture* textures[DRAW_COMMAND_CAPACITY];  // Slot to texture, in order of first use
+    int textureCount;
+    int layer;
+    SDL_Color color;  // For fills, set with SetDrawColor
+    SDL_Vertex vertices[DRAW_COMMAND_CAPACITY * 4];
+    int indices[DRAW_COMMAND_CAPACITY * 6];
+} g_DrawBuffer;
+
+void FlushDrawCommands();
+
+void SetDrawLayer(int layer)
+{
+    g_DrawBuffer.layer = layer;
+}
+
+void RecordDraw(SDL_Texture* texture, const SDL_Rect* dest, double angle, const SDL_Point* center,
+                SDL_RendererFlip flip, SDL_Color color)
+{
+    DrawBuffer& buffer = g_DrawBuffer;
+    if (buffer.count == DRAW_COMMAND_CAPACITY)
+    {
+        FlushDrawCommands();
+    }
+
+    int slot = 0;
+    while (slot < buffer.textureCount && buffer.textures[slot] != texture) slot++;
+    if (slot == buffer.textureCount)
+    {
+        buffer.textures[buffer.textureCount++] = texture;
+    }
+
+    DrawCommand& command = buffer.commands[buffer.count++];
+    command.key = static_cast<uint32_t>(buffer.layer) << 16 | static_cast<uint32_t>(slot);
+    command.texture = texture;
+    command.dest = {static_cast<float>(dest->x), static_cast<float>(dest->y),
+                    static_cast<float>(dest->w), static_cast<float>(dest->h)};
+    command.angle = static_cast<float>(angle);
+    command.center = center ? SDL_FPoint{static_cast<float>(center->x), static_cast<float>(center->y)}
+                            : SDL_FPoint{command.dest.w / 2, command.dest.h / 2};
+    command.flip = flip;
+    command.color = color;
+    g_RenderStats.frame.commands++;
+}
+
+void DrawCopy(SDL_Texture* texture, const SDL_Rect* dest)
+{
+    RecordDraw(texture, dest, 0.0, nullptr, SDL_FLIP_NONE, {255, 255, 255, 255});
+}
+
+void DrawCopyEx(SDL_Texture* texture, const SDL_Rect* dest, double angle, const SDL_Point* center,
+                SDL_RendererFlip flip, Uint8 alpha = 255)
+{
+    RecordDraw(texture, dest, angle, center, flip, {255, 255, 255, alpha});
+}
+
+void DrawFillRect(const SDL_Rect* rect)
+{
+    RecordDraw(nullptr, rect, 0.0, nullptr, SDL_FLIP_NONE, g_DrawBuffer.color);
+}
+
+void SetDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    g_DrawBuffer.color = {r, g, b, a};
+}
+
+// Right away, at the start of a frame before anything is recorded
+void DrawClear()
+{
+    const SDL_Color& color = g_DrawBuffer.color;
+    SDL_SetRenderDrawColor(g_Renderer, color.r, color.g, color.b, color.a);
+    SDL_RenderClear(g_Renderer);
+    g_RenderStats.frame.stateChanges++;
+    g_RenderStats.frame.drawCalls++;
+}
+
+SDL_Texture* CreateTexture(SDL_Surface* surface)
+{
+    g_RenderStats.frame.textureCreations++;
+    return SDL_CreateTextureFromSurface(g_Renderer, surface);
+}
+
+// Stable LSD radix sort of the command order on the 24 bit keys, a byte per pass
+void SortDrawCommands()
+{
+    DrawBuffer& buffer = g_DrawBuffer;
+    uint16_t* from = buffer.order;
+    uint16_t* to = buffer.scratch;
+    for (int i = 0; i < buffer.count; i++) from[i] = static_cast<uint16_t>(i);
+
+    for (int shift = 0; shift < 24; shift += 8)
     {
-        {.0f, 40.0f},    // Fill with actual values for position 1
-        {100.0f, 45.0f}     // Fill with actual values for position 2
-    },
-    // Branch Type 2 positions
+        int offsets[257] = {0};
+        for (int i = 0; i < buffer.count; i++)
+            offsets[((buffer.commands[i].key >> shift) & 0xFF) + 1]++;
+        if (offsets[((buffer.commands[0].key >> shift) & 0xFF) + 1] == buffer.count) continue;  // One digit, nothing moves
+
+        for (int digit = 1; digit <= 256; digit++) offsets[digit] += offsets[digit - 1];
+        for (int i = 0; i < buffer.count; i++)
+        {
+            uint16_t index = from[i];
+            to[offsets[(buffer.commands[index].key >> shift) & 0xFF]++] = index;
+        }
+        std::swap(from, to);
+    }
+    if (from != buffer.order) memcpy(buffer.order, from, buffer.count * sizeof(uint16_t));
+}
+
+// Four corners of command, flipped and rotated like SDL_RenderCopyEx would
+void AppendQuad(const DrawCommand& command, SDL_Vertex* vertices)
+{
+    const SDL_FRect& dest = command.dest;
+    float left = (command.flip & SDL_FLIP_HORIZONTAL) ? 1.0f : 0.0f;
+    float top = (command.flip & SDL_FLIP_VERTICAL) ? 1.0f : 0.0f;
+    const SDL_FPoint corners[4] = {{0, 0}, {dest.w, 0}, {dest.w, dest.h}, {0, dest.h}};
+    const SDL_FPoint uvs[4] = {{left, top}, {1 - left, top}, {1 - left, 1 - top}, {left, 1 - top}};
+
+    float radians = command.angle * PI / 180.0f;
+    float cosine = cosf(radians), sine = sinf(radians);
+    for (int i = 0; i < 4; i++)
     {
-        {40.0f, 40.0f},    // Fill with actual values for position 1
-        {140.0f, 50.0f}     // Fill with actual values for position 2
-    },
-    // Branch Type 3 positions
+        float x = corners[i].x - command.center.x;
+        float y = corners[i].y - command.center.y;
+        if (command.angle != 0.0f)
+        {
+            float rotatedX = x * cosine - y * sine;
+            y = x * sine + y * cosine;
+            x = rotatedX;
+        }
+        vertices[i].position = {dest.x + command.center.x + x, dest.y + command.center.y + y};
+        vertices[i].color = command.color;
+        vertices[i].tex_coord = uvs[i];
+    }
+}
+
+void FlushDrawCommands()
+{
+    DrawBuffer& buffer = g_DrawBuffer;
+    if (buffer.count == 0) return;
+    SortDrawCommands();
+
+    int i = 0;
+    while (i < buffer.count)
     {
-        {60.0f, 30.0f},    // Fill with actual values for position 1
-        {80.0f, 70.0f}     // Fill with actual values for position 2
+        SDL_Texture* texture = buffer.commands[buffer.order[i]].texture;
+        int quads = 0;
+        for (; i < buffer.count && buffer.commands[buffer.order[i]].texture == texture; i++, quads++)
+        {
+            AppendQuad(buffer.commands[buffer.order[i]], &buffer.vertices[quads * 4]);
+            static const int quadIndices[6] = {0, 1, 2, 0, 2, 3};
+            for (int k = 0; k < 6; k++) buffer.indices[quads * 6 + k] = quads * 4 + quadIndices[k];
+        }
+        SDL_RenderGeometry(g_Renderer, texture, buffer.vertices, quads * 4, buffer.indices, quads * 6);
+
+        g_RenderStats.frame.drawCalls++;
+        if (texture != g_RenderStats.lastTexture)
+        {
+            g_RenderStats.frame.textureSwitches++;
+            g_RenderStats.lastTexture = texture;
+        }
     }
-};
+    buffer.count = 0;
+    buffer.textureCount = 0;
+}
 
+void AddRenderCounters(RenderCounters& sum, const RenderCounters& counters)
+{
+    sum.commands += counters.commands;
+    sum.drawCalls += counters.drawCalls;
+    sum.textureSwitches += counters.textureSwitches;
+    sum.stateChanges += counters.stateChanges;
+    sum.textureCreations += counters.textureCreations;
+}
+
+void MaxRenderCounters(RenderCounters& worst, const RenderCounters& counters)
+{
+    if (counters.commands > worst.commands) worst.commands = counters.commands;
+    if (counters.drawCalls > worst.drawCalls) worst.drawCalls = counters.drawCalls;
+    if (counters.textureSwitches > worst.textureSwitches) worst.textureSwitches = counters.textureSwitches;
+    if (counters.stateChanges > worst.stateChanges) worst.stateChanges = counters.stateChanges;
+    if (counters.textureCreations > worst.textureCreations) worst.textureCreations = counters.textureCreations;
+}
+
+// After the present, starts counting the next frame
+void FinishRenderCounters()
+{
+    RenderStats& stats = g_RenderStats;
+    stats.lastFrame = stats.frame;
+    AddRenderCounters(stats.total, stats.frame);
+    MaxRenderCounters(stats.max, stats.frame);
+    stats.frames++;
+    stats.frame = RenderCounters();
+    stats.lastTexture = nullptr;
+}
 
 // forward declarations
 void RenderControls();
 void RenderTimer();
-void ResetTimer();
-void SaveScore(Uint32 time);
+void SaveScore(GameContext& game, Uint32 time);
 void RenderWinMessage();
-void LoadSquirrelSpriteDimensions(GameObject& squirrel);
 void RenderText(const char* text, int x, int y, int fontSize);
+SDL_Texture* GetTextTexture(const char* text, int fontSize, int& width, int& height);
+TTF_Font* GetSizedFont(int fontSize);
+void FreeTextCache();
 void RenderInstructions();
-void RenderLastScores();
+void RenderScoreBoard();
+void RenderEndlessBackground();
+void StartGhostRun(GameContext& game);
+void StopGhostRun(GameContext& game);
+void FinishGhostRun(GameContext& game, Uint32 time);
+void FinishReplayRun(GameContext& game, bool won, uint32_t frame);
+void StopReplayPlayback(GameContext& game);
+void ResetEndless(GameContext& game);
+float EndlessFloorBottom(const GameContext& game);
+void StopSimThread();
+bool LatencyFrameReflectsInput();
+void RenderLatencyPatch(bool reflected);
+void LatencyFramePresented(bool reflected);
+
+// One image or sound effect. Files are read on the main thread, decoded anywhere.
+struct AssetLoad {
+    const char* path;
+    SDL_Texture** texture;  // Images
+    Mix_Chunk** sound;      // Sound effects
+    std::vector<uint8_t> bytes;
+    SDL_Surface* surface;
+    Mix_Chunk* chunk;
+    std::string error;
+};
 
-SDL_Texture* LoadTexture(const char* path)
-{    
-    SDL_Surface* surface = IMG_Load(path);
-    if (!surface)
+bool ReadAssetFile(AssetLoad& asset)
+{
+    SDL_RWops* file = SDL_RWFromFile(asset.path, "rb");
+    if (!file) return false;
+    Sint64 size = SDL_RWsize(file);
+    if (size > 0)
     {
-        printf("Failed to load image %s!\n", path);
-        printf("SDL_image Error: %s\n", IMG_GetError());
-        return nullptr;
+        asset.bytes.resize(static_cast<size_t>(size));
+        if (SDL_RWread(file, asset.bytes.data(), 1, asset.bytes.size()) != asset.bytes.size()) asset.bytes.clear();
+    }
+    SDL_RWclose(file);
+    return !asset.bytes.empty();
+}
+
+void DecodeAsset(AssetLoad& asset)
+{
+    SDL_RWops* memory = SDL_RWFromConstMem(asset.bytes.data(), static_cast<int>(asset.bytes.size()));
+    if (asset.sound)
+    {
+        asset.chunk = Mix_LoadWAV_RW(memory, 1);
     }
+    else
+    {
+        asset.surface = IMG_Load_RW(memory, 1);
+    }
+    if (!asset.chunk && !asset.surface) asset.error = SDL_GetError();  // Kept per thread, read it here
+}
+
+void DecodeAssets(std::vector<AssetLoad>& assets)
+{
+#ifdef ASSETS_THREADED
+    // Images are shared out between the workers. Sounds all go to the first one, one
+    // after another, because SDL_mixer promises nothing about decoding two at once.
+    std::atomic<size_t> nextImage(0);
+    auto decode = [&assets, &nextImage](bool takeSounds) {
+        if (takeSounds)
+        {
+            for (AssetLoad& asset : assets)
+                if (asset.sound) DecodeAsset(asset);
+        }
+        for (size_t i = nextImage++; i < assets.size(); i = nextImage++)
+            if (!assets[i].sound) DecodeAsset(assets[i]);
+    };
 
+    unsigned threadCount = std::max(1u, std::min(std::thread::hardware_concurrency(), static_cast<unsigned>(ASSET_DECODE_THREADS)));
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threadCount; i++)
+        workers.emplace_back(decode, i == 0);
+    for (std::thread& worker : workers)
+        worker.join();
+#else
+    for (AssetLoad& asset : assets)
+        DecodeAsset(asset);
+#endif
+}
 
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(g_Renderer, surface);
-    if (!texture)
+// Reads every file here, decodes them all at once (see DecodeAssets), then creates the
+// textures here. Reading stays on this thread because the web build's preloaded files
+// live on the main thread, and textures belong to the renderer's thread.
+bool LoadAssets(std::vector<AssetLoad>& assets)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    bool ok = true;
+    for (AssetLoad& asset : assets)
     {
-        printf("Failed to create texture from %s!\n", path);
-        printf("SDL Error: %s\n", SDL_GetError());
-        SDL_FreeSurface(surface);
-        return nullptr;
+        if (!ReadAssetFile(asset))
+        {
+            printf("Failed to read %s!\n", asset.path);
+            ok = false;
+        }
     }
+    if (!ok) return false;
 
-    SDL_FreeSurface(surface);
-    return texture;
+    DecodeAssets(assets);
+
+    for (AssetLoad& asset : assets)
+    {
+        if (asset.sound)
+        {
+            *asset.sound = asset.chunk;
+            if (!asset.chunk)
+            {
+                printf("Failed to load sound %s! SDL_mixer Error: %s\n", asset.path, asset.error.c_str());
+                ok = false;
+            }
+            continue;
+        }
+
+        if (!asset.surface)
+        {
+            printf("Failed to load image %s!\n", asset.path);
+            printf("SDL_image Error: %s\n", asset.error.c_str());
+            ok = false;
+            continue;
+        }
+        *asset.texture = CreateTexture(asset.surface);
+        if (!*asset.texture)
+        {
+            printf("Failed to create texture from %s!\n", asset.path);
+            printf("SDL Error: %s\n", SDL_GetError());
+            ok = false;
+        }
+        SDL_FreeSurface(asset.surface);
+    }
+
+    printf("Loaded %zu assets in %.1f ms\n", assets.size(),
+           (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency());
+    return ok;
 }
 
 bool InitSDL()
@@ -244,17 +632,12 @@ bool InitSDL()
         return false;
     }
 
-    g_Font = TTF_OpenFont("assets/VCR_OSD_MONO_1.001.ttf", TIMER_FONT_SIZE);
-    if (!g_Font)
+    if (!GetSizedFont(TIMER_FONT_SIZE))
     {
         printf("Failed to load font! SDL_ttf Error: %s\n", TTF_GetError());
         return false;
     }
 
-    g_StartTime = SDL_GetTicks();
-    g_TimerActive = false;
-    g_WinAchieved = false;
-
     g_Window = SDL_CreateWindow(
         "Cucko Launch",
         SDL_WINDOWPOS_CENTERED,
@@ -266,105 +649,68 @@ bool InitSDL()
 
     if (!g_Window) return false;
 
-    g_Renderer = SDL_CreateRenderer(
-        g_Window,
-        -1,
-        SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC
-    );
-
-    if (!g_Renderer) return false;
-
-    // Load textures
-    g_EggTexture = LoadTexture("assets/egg.png");
-    g_SquirrelTexture = LoadTexture("assets/squirrel.png");
-    g_TreeTexture = LoadTexture("assets/tree.png");
-    g_BranchTexture = LoadTexture("assets/branch.png");
-    g_ArrowTexture = LoadTexture("assets/arrow.png");
-
-    if (!g_EggTexture || !g_SquirrelTexture || !g_TreeTexture || !g_BranchTexture || !g_ArrowTexture) return false;
-
-    // Load egg sprites
-    g_EggTextures[0] = LoadTexture("assets/egg/egg_closed_1.png");
-    g_EggTextures[1] = LoadTexture("assets/egg/egg_closing_2.png");
-    g_EggTextures[2] = LoadTexture("assets/egg/egg_open_3.png");
-
-    // Check if all textures loaded successfully
-    for (int i = 0; i < EGG_SPRITE_COUNT; i++)
+    if (g_Golden.dir)
     {
-        if (!g_EggTextures[i])
-        {
-            printf("Failed to load egg sprite %d\n", i + 1);
-            return false;
-        }
+        // Golden images draw into a surface we can read back, the same on every machine
+        g_Golden.surface = SDL_CreateRGBSurfaceWithFormat(0, WINDOW_WIDTH, WINDOW_HEIGHT, 32, SDL_PIXELFORMAT_RGBA32);
+        if (!g_Golden.surface) return false;
+        g_Renderer = SDL_CreateSoftwareRenderer(g_Golden.surface);
     }
-
-    // Load squirrel sprites
-    g_SquirrelTextures[0] = LoadTexture("assets/squirrel/squirrel_without_egg_1.png");
-    g_SquirrelTextures[1] = LoadTexture("assets/squirrel/sprite_esquilo-holding_egg.png");
-    g_SquirrelTextures[2] = LoadTexture("assets/squirrel/sprite_esquilo-launch_1.png");
-    g_SquirrelTextures[3] = LoadTexture("assets/squirrel/sprite_esquilo-launch_2.png");
-    g_SquirrelTextures[4] = LoadTexture("assets/squirrel/sprite_esquilo-launch_3.png");
-
-    // Check if all textures loaded successfully
-    for (int i = 0; i < SPRITE_SQUIRREL_MAX_VALUE; i++)
+    else
     {
-        if (!g_SquirrelTextures[i])
-        {
-            printf("Failed to load squirrel sprite %d\n", i + 1);
-            return false;
-        }
-    }
-
-    // Load background textures
-    g_BackgroundBase = LoadTexture("assets/background/bg_base_1.png");
-    g_BackgroundModular = LoadTexture("assets/background/bg_modular_2.png");
-    g_BackgroundTop = LoadTexture("assets/background/bg_top_3.png");
-
-    if (!g_BackgroundBase || !g_BackgroundModular || !g_BackgroundTop) {
-        printf("Failed to load background textures!\n");
-        return false;
+        g_Renderer = SDL_CreateRenderer(
+            g_Window,
+            -1,
+            SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC
+        );
     }
 
-    // Initialize SDL_mixer
-    if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 8, 2048) < 0)
+    if (!g_Renderer)
     {
-        printf("SDL_mixer could not initialize! SDL_mixer Error: %s\n", Mix_GetError());
-        return false;
+        // No GPU, e.g. the dummy video driver on a build machine
+        printf("No accelerated renderer (%s), using the software one\n", SDL_GetError());
+        g_Renderer = SDL_CreateRenderer(g_Window, -1, SDL_RENDERER_SOFTWARE);
     }
 
-    // Load sound effect
-    g_CrunchSound = Mix_LoadWAV("assets/audio/82318-iedlabs-cruch-eggshells-medium.mp3");
-    if (g_CrunchSound == nullptr)
-    {
-        printf("Failed to load crunch sound effect! SDL_mixer Error: %s\n", Mix_GetError());
-        return false;
-    }
+    if (!g_Renderer) return false;
 
-    g_WinSound = Mix_LoadWAV("assets/audio/242501__gabrielaraujo__powerupsuccess.wav");
-    if (g_WinSound == nullptr)
+    // Initialize SDL_mixer, sounds are decoded to its format
+    if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 8, 2048) < 0)
     {
-        printf("Failed to load g_WinSound sound effect! SDL_mixer Error: %s\n", Mix_GetError());
+        printf("SDL_mixer could not initialize! SDL_mixer Error: %s\n", Mix_GetError());
         return false;
     }
 
-    // Load launch sounds
-    const char* launchSoundPaths[NUM_LAUNCH_SOUNDS] = {
-        "assets/audio/zapsplat_animals_bird_ringneck_parakeet_says_what_you_doing_109613.mp3",
-        "assets/audio/zapsplat_animals_bird_ringneck_parakeet_single_excited_chirp_squeak_109616.mp3",
-        "assets/audio/zapsplat_animals_budgies_chirping_happy_001_75627.mp3",
-        "assets/audio/zapsplat_animals_budgies_chirping_happy_005_75538.mp3"
+    // Textures and sound effects, decoded together
+    std::vector<AssetLoad> assets = {
+        {"assets/egg.png", &g_EggTexture},
+        {"assets/squirrel.png", &g_SquirrelTexture},
+        {"assets/tree.png", &g_TreeTexture},
+        {"assets/branch.png", &g_BranchTexture},
+        {"assets/arrow.png", &g_ArrowTexture},
+        {"assets/egg/egg_closed_1.png", &g_EggTextures[0]},
+        {"assets/egg/egg_closing_2.png", &g_EggTextures[1]},
+        {"assets/egg/egg_open_3.png", &g_EggTextures[2]},
+        {"assets/background/bg_base_1.png", &g_BackgroundBase},
+        {"assets/background/bg_modular_2.png", &g_BackgroundModular},
+        {"assets/background/bg_top_3.png", &g_BackgroundTop},
+        {"assets/branch/branch1.png", &g_BranchTextures[0]},
+        {"assets/branch/branch2.png", &g_BranchTextures[1]},
+        {"assets/branch/branch3.png", &g_BranchTextures[2]},
+        {"assets/audio/82318-iedlabs-cruch-eggshells-medium.mp3", nullptr, &g_CrunchSound},
+        {"assets/audio/242501__gabrielaraujo__powerupsuccess.wav", nullptr, &g_WinSound},
+        {"assets/audio/zapsplat_animals_bird_ringneck_parakeet_says_what_you_doing_109613.mp3", nullptr, &g_LaunchSounds[0]},
+        {"assets/audio/zapsplat_animals_bird_ringneck_parakeet_single_excited_chirp_squeak_109616.mp3", nullptr, &g_LaunchSounds[1]},
+        {"assets/audio/zapsplat_animals_budgies_chirping_happy_001_75627.mp3", nullptr, &g_LaunchSounds[2]},
+        {"assets/audio/zapsplat_animals_budgies_chirping_happy_005_75538.mp3", nullptr, &g_LaunchSounds[3]}
     };
-
-    for (int i = 0; i < NUM_LAUNCH_SOUNDS; i++)
+    for (int i = 0; i < SPRITE_SQUIRREL_MAX_VALUE; i++)
     {
-        g_LaunchSounds[i] = Mix_LoadWAV(launchSoundPaths[i]);
-        if (g_LaunchSounds[i] == nullptr)
-        {
-            printf("Failed to load launch sound %d! SDL_mixer Error: %s\n", i, Mix_GetError());
-            return false;
-        }
+        assets.push_back({g_SquirrelSpritePaths[i], &g_SquirrelTextures[i]});
     }
 
+    if (!LoadAssets(assets)) return false;
+
     g_BackgroundMusic = Mix_LoadMUS("assets/audio/music.mpeg");
     if (g_BackgroundMusic == nullptr)
     {
@@ -382,193 +728,45 @@ bool InitSDL()
     // Optionally adjust music volume (0-128)
     Mix_VolumeMusic(MIX_MAX_VOLUME / 6);  // 50% volume - adjust as needed
 
-    // Load branch textures
-    g_BranchTextures[0] = LoadTexture("assets/branch/branch1.png");
-    g_BranchTextures[1] = LoadTexture("assets/branch/branch2.png");
-    g_BranchTextures[2] = LoadTexture("assets/branch/branch3.png");
-
-    // Check if all branch textures loaded successfully
-    for (int i = 0; i < NUM_BRANCH_TYPES; i++) {
-        if (!g_BranchTextures[i]) {
-            printf("Failed to load branch texture %d\n", i + 1);
-            return false;
-        }
-    }
-
     return true;
 }
 
-int GetDefaultSquirrelWidth() {
-    int width, height;
-    SDL_QueryTexture(g_SquirrelTextures[0], nullptr, nullptr, &width, &height);
-    return static_cast<int>(width * SQUIRREL_SCALE);
-}
-
-int GetDefaultSquirrelHeight() {
-    int width, height;
-    SDL_QueryTexture(g_SquirrelTextures[0], nullptr, nullptr, &width, &height);
-    return static_cast<int>(height * SQUIRREL_SCALE);
-}
-
-void GenerateBranchesAndSquirrels()
+SquirrelMetrics GetSquirrelMetrics()
 {
-    // Clear existing branches and squirrels
-    g_GameState.branches.clear();
-    g_GameState.squirrels.clear();
-
-    // Set random seed based on time
-    srand(2); //static_cast<unsigned>(time(nullptr)));
-        // Get default squirrel dimensions
-    int defaultWidth = GetDefaultSquirrelWidth();
-    int defaultHeight = GetDefaultSquirrelHeight();
-
-    float currentHeight = TOTAL_GAME_HEIGHT - WINDOW_HEIGHT*0.5f;  // Start above floor squirrel
-    bool isLeft = false;  // always start with branch on the right
-
-    while (currentHeight > 100)  // Generate until we reach the top
-    {
-        // Random height spacing for this branch
-        float spacing = MIN_BRANCH_SPACING + 
-            static_cast<float>((float)rand()) / (float)RAND_MAX * (MAX_BRANCH_SPACING - MIN_BRANCH_SPACING);
-        
-        // Random extension from tree
-        float extension = MIN_BRANCH_EXTENSION + 
-            static_cast<float>((float)rand()) / (float)RAND_MAX * (MAX_BRANCH_EXTENSION - MIN_BRANCH_EXTENSION);
-
-        // Calculate branch position
-        float branchX = !isLeft ? TREE_WIDTH : WINDOW_WIDTH - TREE_WIDTH - extension;
-        
-        // Randomly select branch type and position
-        int branchType = rand() % NUM_BRANCH_TYPES;
-        int positionIndex = rand() % POSITIONS_PER_BRANCH;
-
-        // Add branch
-        GameObject branch = {
-            branchX,
-            currentHeight,
-            static_cast<int>(extension),
-            BRANCH_HEIGHT,
-            g_BranchTextures[branchType],
-            isLeft,
-            branchType  // Add branch type
-        };
-        g_GameState.branches.push_back(branch);
-
-        // Calculate squirrel position based on branch type and chosen position
-        float squirrelX = branchX + g_BranchPositions[branchType][positionIndex].x;
-        float squirrelY = currentHeight + g_BranchPositions[branchType][positionIndex].y;
-
-        if (!isLeft) {
-            // Adjust X position for right-side branches
-            squirrelX = branchX + extension - defaultWidth - g_BranchPositions[branchType][positionIndex].x;
-        }
-
-        // Add squirrel
-        GameObject squirrel = {
-            squirrelX,
-            squirrelY,
-            defaultWidth,
-            defaultHeight,
-            g_SquirrelTexture,
-            !isLeft,
-            SPRITE_SQUIRREL_WITHOUT_EGG_0,  // currentSprite
-            {0},  // spriteWidths
-            {0},  // spriteHeights
-            -1,   // branchType (not used for squirrels)
-            positionIndex,
-            0.0f,           // animationTimer
-            false           // hasEgg
-        };
-        LoadSquirrelSpriteDimensions(squirrel);
-        g_GameState.squirrels.push_back(squirrel);
-
-        // Update for next iteration
-        currentHeight -= spacing;
-        isLeft = !isLeft;  // Alternate sides
+    SquirrelMetrics metrics;
+    for (int i = 0; i < SPRITE_SQUIRREL_MAX_VALUE; i++) {
+        int width, height;
+        SDL_QueryTexture(g_SquirrelTextures[i], nullptr, nullptr, &width, &height);
+        metrics.spriteWidths[i] = static_cast<int>(width * SQUIRREL_SCALE);
+        metrics.spriteHeights[i] = static_cast<int>(height * SQUIRREL_SCALE);
     }
-
-    printf("Generated %zu branches and squirrels\n", g_GameState.branches.size());
+    return metrics;
 }
 
-void InitGameObjects()
+void InitGameObjects(GameContext& game)
 {
-    // Setup trees
-    g_GameState.leftTree = {
-        0.0f,
-        0.0f,
-        TREE_WIDTH,
-        static_cast<int>(TOTAL_GAME_HEIGHT),
-        g_TreeTexture,
-        true
-    };
-
-    g_GameState.rightTree = {
-        static_cast<float>(WINDOW_WIDTH - TREE_WIDTH),
-        0.0f,
-        TREE_WIDTH,
-        static_cast<int>(TOTAL_GAME_HEIGHT),
-        g_TreeTexture,
-        false
-    };
-
-    // Get default squirrel dimensions
-    int defaultWidth = GetDefaultSquirrelWidth();
-    int defaultHeight = GetDefaultSquirrelHeight();
-
-    // Position floor squirrel at the bottom of the total height plus an offset
-    g_GameState.floorSquirrel = {
-        static_cast<float>(WINDOW_WIDTH / 2 - defaultWidth / 2) - 40,
-        TOTAL_GAME_HEIGHT - defaultHeight - 60,
-        defaultWidth,
-        defaultHeight,
-        g_SquirrelTexture,
-        true
-    };
-    LoadSquirrelSpriteDimensions(g_GameState.floorSquirrel);
-
-    // Generate branches and squirrels
-    GenerateBranchesAndSquirrels();
-
-
-    // Initialize nest position at the top-middle of the screen
-    g_GameState.nest.x = (WINDOW_WIDTH - NEST_SIZE) / 2;
-    g_GameState.nest.y = 74;
-    g_GameState.nest.width = NEST_SIZE;
-    g_GameState.nest.height = NEST_SIZE;
-
-    // Initialize egg position on nest
-    g_GameState.egg = {
-        g_GameState.nest.x + (NEST_SIZE - EGG_SIZE_X) / 2,  // Center egg on nest
-        g_GameState.nest.y, 
-        EGG_SIZE_X,
-        EGG_SIZE_Y,
-        g_EggTexture,
-        false
-    };
-
-    g_GameState.eggVelocityY = 0.0f;
-    g_GameState.eggVelocityX = 0.0f;
-    g_GameState.isInNest = true;  // Start in nest
-
-    g_GameState.strengthCharge = 0.0f;
-    g_GameState.isCharging = false;
-    g_GameState.isDepletingCharge = false;
-    g_GameState.angleSquareY = ANGLE_BAR_Y + ANGLE_BAR_HEIGHT - ANGLE_SQUARE_SIZE;
-    g_GameState.angleSquareVelocity = 0.0f;
-    g_GameState.isLaunchingRight = true;  // Default to right direction
-    g_GameState.activeSquirrel = &g_GameState.floorSquirrel;  // Start with floor squirrel
-    g_GameState.cameraY = 0.0f;
-    g_GameState.targetCameraY = 0.0f;
+    InitSimulation(game.state, game.levelSeed, GetSquirrelMetrics());
+    game.state.fixedPhysics = game.fixedPhysics;
+
+    // The simulation leaves textures to us
+    game.state.leftTree.texture = g_TreeTexture;
+    game.state.rightTree.texture = g_TreeTexture;
+    game.state.floorSquirrel.texture = g_SquirrelTexture;
+    game.state.egg.texture = g_EggTexture;
+
+    game.ghost.egg = game.state.egg;
+    game.ghost.egg.texture = g_EggTextures[0];
+    game.ghost.egg.alpha = GHOST_ALPHA;
 }
 
 void RenderGameObject(const GameObject& obj)
 {
+    const GameState& game = g_View->game;
     // Use the current sprite's dimensions for squirrels
     int renderWidth = obj.width;
     int renderHeight = obj.height;
     
-    if (&obj == &g_GameState.floorSquirrel || 
-        (&obj >= &g_GameState.squirrels.front() && &obj <= &g_GameState.squirrels.back()))
+    if (&obj == &game.floorSquirrel || PoolContains(game.squirrels, &obj))
     {
         renderWidth = obj.spriteWidths[obj.currentSprite];
         renderHeight = obj.spriteHeights[obj.currentSprite];
@@ -576,48 +774,43 @@ void RenderGameObject(const GameObject& obj)
 
     SDL_Rect destRect = {
         static_cast<int>(obj.x),
-        static_cast<int>(obj.y - g_GameState.cameraY),
+        static_cast<int>(obj.y - game.cameraY),
         renderWidth,
         renderHeight
     };
 
-    if (&obj == &g_GameState.egg)
+    if (&obj == &game.egg)
     {
         // printf("Rendering egg at x:%d y:%d w:%d h:%d (sprite:%d)\n", 
         //        destRect.x, 
         //        destRect.y, 
         //        destRect.w, 
         //        destRect.h,
-        //        g_GameState.currentEggSprite);
+        //        game.currentEggSprite);
 
-        SDL_RenderCopy(g_Renderer, 
-                      g_EggTextures[g_GameState.currentEggSprite], 
-                      nullptr, 
-                      &destRect);
+        DrawCopy(g_EggTextures[game.currentEggSprite], 
+                 &destRect);
     }
-    else if (&obj == &g_GameState.floorSquirrel || 
-             (&obj >= &g_GameState.squirrels.front() && &obj <= &g_GameState.squirrels.back()))
+    else if (&obj == &game.floorSquirrel || PoolContains(game.squirrels, &obj))
     {
         // Add flip based on isLeftSide
         SDL_RendererFlip flip = (obj.isLeftSide) ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
-        SDL_RenderCopyEx(g_Renderer,
-                        g_SquirrelTextures[obj.currentSprite],
-                        nullptr,
-                        &destRect,
-                        0,      // no rotation
-                        nullptr, // rotate around center
-                        flip);  // flip horizontally if needed
-    }
-    else if (&obj >= &g_GameState.branches.front() && &obj <= &g_GameState.branches.back()) {
+        DrawCopyEx(g_SquirrelTextures[obj.currentSprite],
+                   &destRect,
+                   0,      // no rotation
+                   nullptr, // rotate around center
+                   flip);  // flip horizontally if needed
+    }
+    else if (PoolContains(game.branches, &obj)) {
         // It's a branch, use the appropriate texture
         SDL_RendererFlip flip = (obj.isLeftSide) ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
-        SDL_RenderCopyEx(g_Renderer, g_BranchTextures[obj.branchType], nullptr, &destRect, 0, nullptr, flip);
+        DrawCopyEx(g_BranchTextures[obj.branchType], &destRect, 0, nullptr, flip);
     }
     else
     {
         SDL_Rect dest = {
             static_cast<int>(obj.x),
-            static_cast<int>(obj.y - g_GameState.cameraY),  // Subtract camera offset
+            static_cast<int>(obj.y - game.cameraY),  // Subtract camera offset
             obj.width,
             obj.height
         };
@@ -628,29 +821,30 @@ void RenderGameObject(const GameObject& obj)
                 ? SDL_FLIP_HORIZONTAL 
                 : SDL_FLIP_NONE;
                 
-            SDL_RenderCopyEx(g_Renderer, obj.texture, nullptr, &dest, 0, nullptr, flip);
+            DrawCopyEx(obj.texture, &dest, 0, nullptr, flip, obj.alpha);
         }
     }
 }
 
 void RenderArrow()
 {
-    if (!g_GameState.eggIsHeld || g_GameState.isInNest ) return;
+    const GameState& game = g_View->game;
+    if (!game.eggIsHeld || game.isInNest ) return;
 
     // Calculate angle based on angle square position
-    float normalizedY = (ANGLE_BAR_Y + ANGLE_BAR_HEIGHT - ANGLE_SQUARE_SIZE - g_GameState.angleSquareY) 
+    float normalizedY = (ANGLE_BAR_Y + ANGLE_BAR_HEIGHT - ANGLE_SQUARE_SIZE - game.angleSquareY) 
                      / (ANGLE_BAR_HEIGHT - ANGLE_SQUARE_SIZE);
     float angle = -normalizedY * 90.0f;  // Convert to degrees (0 to 90), negative to point upward
 
     // If launching left, mirror the angle
-    if (!g_GameState.isLaunchingRight) {
+    if (!game.isLaunchingRight) {
         angle = 180.0f - angle;
     }
 
     // Position arrow with its left edge at egg's center
     SDL_Rect arrowRect = {
-        static_cast<int>(g_GameState.egg.x + g_GameState.egg.width/2),  // Start at egg's center
-        static_cast<int>(g_GameState.egg.y + g_GameState.egg.height/2 - ARROW_HEIGHT/2 - g_GameState.cameraY),  // Vertically centered
+        static_cast<int>(game.egg.x + game.egg.width/2),  // Start at egg's center
+        static_cast<int>(game.egg.y + game.egg.height/2 - ARROW_HEIGHT/2 - game.cameraY),  // Vertically centered
         ARROW_WIDTH,
         ARROW_HEIGHT
     };
@@ -662,10 +856,8 @@ void RenderArrow()
     };
 
     // Render the arrow with rotation around its left edge
-    SDL_RenderCopyEx(
-        g_Renderer,
+    DrawCopyEx(
         g_ArrowTexture,
-        nullptr,
         &arrowRect,
         angle,         // Rotation angle in degrees
         &rotationPoint, // Rotate around left edge
@@ -675,9 +867,16 @@ void RenderArrow()
 
 void RenderBackground()
 {
+    const GameState& game = g_View->game;
+    if (game.endless)
+    {
+        RenderEndlessBackground();
+        return;
+    }
+
     // Calculate how many screens are visible based on camera position
-    int startScreen = static_cast<int>(g_GameState.cameraY / WINDOW_HEIGHT);
-    int endScreen = static_cast<int>((g_GameState.cameraY + WINDOW_HEIGHT) / WINDOW_HEIGHT) + 1;
+    int startScreen = static_cast<int>(game.cameraY / WINDOW_HEIGHT);
+    int endScreen = static_cast<int>((game.cameraY + WINDOW_HEIGHT) / WINDOW_HEIGHT) + 1;
 
     // Clamp to valid range
     startScreen = std::max(0, startScreen);
@@ -688,7 +887,7 @@ void RenderBackground()
         // screen 0 is the topmost screen, endScreen is the bottom screen
         SDL_Rect destRect = {
             0,
-            screen * WINDOW_HEIGHT - static_cast<int>(g_GameState.cameraY),
+            screen * WINDOW_HEIGHT - static_cast<int>(game.cameraY),
             WINDOW_WIDTH,
             WINDOW_HEIGHT
         };
@@ -708,84 +907,122 @@ void RenderBackground()
             bgTexture = g_BackgroundModular;
         }
 
-        SDL_RenderCopy(g_Renderer, bgTexture, nullptr, &destRect);
+        DrawCopy(bgTexture, &destRect);
     }
 }
 
 void RenderNest()
 {
+    const GameState& game = g_View->game;
     if (0) // for debug
     {
-        SDL_SetRenderDrawColor(g_Renderer, NEST_COLOR.r, NEST_COLOR.g, NEST_COLOR.b, NEST_COLOR.a);
+        SetDrawColor(NEST_COLOR.r, NEST_COLOR.g, NEST_COLOR.b, NEST_COLOR.a);
         SDL_Rect nestRect = {
-            static_cast<int>(g_GameState.nest.x),
-            static_cast<int>(g_GameState.nest.y - g_GameState.cameraY), // Account for camera position
-            g_GameState.nest.width,
-            g_GameState.nest.height};
-        SDL_RenderFillRect(g_Renderer, &nestRect);
+            static_cast<int>(game.nest.x),
+            static_cast<int>(game.nest.y - game.cameraY), // Account for camera position
+            game.nest.width,
+            game.nest.height};
+        DrawFillRect(&nestRect);
     }
 }
 
 void Render()
 {
+    const GameState& game = g_View->game;
     // Clear with a color (can be kept as fallback)
-    SDL_SetRenderDrawColor(g_Renderer, 135, 206, 235, 255);  // Sky blue background
-    SDL_RenderClear(g_Renderer);
+    SetDrawColor(135, 206, 235, 255);  // Sky blue background
+    DrawClear();
 
     // Render background first
+    SetDrawLayer(DRAW_LAYER_BACKGROUND);
     RenderBackground();
 
     // Render trees - currently not drawing, used only for debug
-   // RenderGameObject(g_GameState.leftTree);
-    //RenderGameObject(g_GameState.rightTree);
+   // RenderGameObject(game.leftTree);
+    //RenderGameObject(game.rightTree);
 
     // Render branches first (behind squirrels)
-    for (const auto& branch : g_GameState.branches)
+    SetDrawLayer(DRAW_LAYER_BRANCHES);
+    for (const auto& branch : game.branches)
     {
         RenderGameObject(branch);
     }
 
     // Render squirrels
-    for (const auto& squirrel : g_GameState.squirrels)
+    SetDrawLayer(DRAW_LAYER_SQUIRRELS);
+    for (const auto& squirrel : game.squirrels)
     {
         RenderGameObject(squirrel);
     }
 
     // Render the nest
+    SetDrawLayer(DRAW_LAYER_NEST);
     RenderNest();
 
     // Render floor squirrel
-    RenderGameObject(g_GameState.floorSquirrel);
+    SetDrawLayer(DRAW_LAYER_FLOOR_SQUIRREL);
+    RenderGameObject(game.floorSquirrel);
+
+    // Render the best run's egg behind the live one
+    if (g_View->ghostVisible)
+    {
+        SetDrawLayer(DRAW_LAYER_GHOST);
+        RenderGameObject(g_View->ghostEgg);
+    }
 
     // Render egg
-    RenderGameObject(g_GameState.egg);
+    SetDrawLayer(DRAW_LAYER_EGG);
+    RenderGameObject(game.egg);
 
     // Render arrow
+    SetDrawLayer(DRAW_LAYER_ARROW);
     RenderArrow();
 
     // Render controls
+    SetDrawLayer(DRAW_LAYER_CONTROLS);
     RenderControls();
 
     // Render instructions
+    SetDrawLayer(DRAW_LAYER_INSTRUCTIONS);
     RenderInstructions();
 
+    SetDrawLayer(DRAW_LAYER_TIMER);
     RenderTimer();
-    
+
+    bool reflected = LatencyFrameReflectsInput();
+    SetDrawLayer(DRAW_LAYER_OVERLAY);
+    RenderLatencyPatch(reflected);
+
+    FlushDrawCommands();
     SDL_RenderPresent(g_Renderer);
+    g_TextCache.renderCount++;
+    FinishRenderCounters();
+    LatencyFramePresented(reflected);
 }
 
 void CleanUp()
 {
+    StopSimThread();  // Everything below may touch the game state
+    GameContext& game = g_Game;
+    FinishReplayRun(game, false, game.state.frame > 0 ? game.state.frame - 1 : 0);  // Sessions that never reached the nest are kept too
+    StopLeaderboardClient(g_Leaderboard, false);
+    #ifndef __EMSCRIPTEN__
+    StopBackgroundWriter(g_Writer);  // Writes out the replay finished just above
+    #endif
+    StopChunkStreamer(game.endless.streamer);
+    CloseGhost(game.ghost.player);
+
     SDL_DestroyTexture(g_EggTexture);
     SDL_DestroyTexture(g_SquirrelTexture);
     SDL_DestroyTexture(g_TreeTexture);
     SDL_DestroyTexture(g_BranchTexture);
     SDL_DestroyTexture(g_ArrowTexture);
+    FreeTextCache();
     SDL_DestroyRenderer(g_Renderer);
+    SDL_FreeSurface(g_Golden.surface);
     SDL_DestroyWindow(g_Window);
     IMG_Quit();
     SDL_Quit();
-    TTF_CloseFont(g_Font);
     TTF_Quit();
 
     // Cleanup egg textures
@@ -838,288 +1075,40 @@ void PlayRandomLaunchSound()
     Mix_PlayChannel(-1, g_LaunchSounds[randomIndex], 0);
 }
 
-bool CheckCollision(const SDL_Rect& a, const SDL_Rect& b)
-{
-    return (a.x < b.x + b.w &&
-            a.x + a.w > b.x &&
-            a.y < b.y + b.h &&
-            a.y + a.h > b.y);
-}
-
-void HandleCollision(GameObject *squirrel)
-{
-    // hacks for adjusting the egg on the tail
-    int offset_y=-110, offset_x = 50;
-    if (squirrel->isLeftSide)        { offset_y=-110; offset_x=0;}
-    if (squirrel == &g_GameState.floorSquirrel) {offset_y=-110;offset_x=0;}
-
-    g_GameState.eggIsHeld = true;
-    g_GameState.eggVelocityX = 0;
-    g_GameState.eggVelocityY = 0;
-    g_GameState.egg.y = squirrel->y + g_GameState.egg.height + offset_y;
-    g_GameState.egg.x = squirrel->x  + offset_x +
-        (squirrel->spriteWidths[squirrel->currentSprite] - g_GameState.egg.width) / 2;
-    g_GameState.activeSquirrel = squirrel;
-    g_GameState.isLaunchingRight = g_GameState.activeSquirrel->isLeftSide;
-    
-    // Reset control states
-    g_GameState.strengthCharge = 0.0f;
-    g_GameState.isCharging = false;
-    g_GameState.isDepletingCharge = false;
-    g_GameState.angleSquareY = ANGLE_BAR_Y + ANGLE_BAR_HEIGHT - ANGLE_SQUARE_SIZE;
-    g_GameState.angleSquareVelocity = 0.0f;
-
-    
-    g_GameState.currentEggSprite = 0;  // Reset animation
-    g_EggAnimationTime = 0.0f;
-
-    squirrel->hasEgg = true;
-    squirrel->currentSprite = SPRITE_SQUIRREL_WITH_EGG_1;     // Switch to catching animation
-    squirrel->animationTimer = 0.5f; // Set animation duration to 0.5 seconds
-    // g_GameState.egg.width = 0;      // Make egg invisible
-    // g_GameState.egg.height = 0;
-}
-
-void UpdatePhysics(float deltaTime)
+void RenderControls()
 {
-    // Skip physics if egg is still in nest
-    if (g_GameState.isInNest) {
-        return;
-    }
-
-    if (!g_GameState.eggIsHeld)
+    const GameState& game = g_View->game;
+    if (game.eggIsHeld)
     {
-        // Apply gravity
-        g_GameState.eggVelocityY += GRAVITY;
-        if (g_GameState.eggVelocityY > TERMINAL_VELOCITY)
-            g_GameState.eggVelocityY = TERMINAL_VELOCITY;
-
-        // Calculate new position
-        float newX = g_GameState.egg.x + g_GameState.eggVelocityX;
-        float newY = g_GameState.egg.y + g_GameState.eggVelocityY;
-
-        // printf("Physics Update - Pos: (%.2f, %.2f), New Pos: (%.2f, %.2f), Vel: (%.2f, %.2f)\n",
-        //        g_GameState.egg.x, g_GameState.egg.y, 
-        //        newX, newY,
-        //        g_GameState.eggVelocityX, g_GameState.eggVelocityY);
+        // Calculate strength bar position relative to egg
+        const GameObject* activeSquirrel = GetSquirrel(game, game.activeSquirrel);
+        int x_offset = (activeSquirrel && activeSquirrel->isLeftSide) ? -10 : EGG_SIZE_X + 20;
+        int strengthBarX = static_cast<int>(game.egg.x) - STRENGTH_BAR_WIDTH + x_offset; // 10 pixels gap
+        int strengthBarY = static_cast<int>(game.egg.y) - game.cameraY - STRENGTH_BAR_HEIGHT/2 + game.egg.height/2;
 
-        // Create egg collision rect at the new position
-        SDL_Rect eggRect = {
-            static_cast<int>(newX),
-            static_cast<int>(newY),
-            g_GameState.egg.width,
-            g_GameState.egg.height
+        // Draw strength bar background
+        SDL_Rect strengthBarBg = {
+            strengthBarX,
+            strengthBarY,
+            STRENGTH_BAR_WIDTH,
+            STRENGTH_BAR_HEIGHT
         };
+        SetDrawColor(100, 100, 100, 255);
+        DrawFillRect(&strengthBarBg);
 
-        // Tree collisions
-        SDL_Rect leftTreeRect = {
-            static_cast<int>(g_GameState.leftTree.x),
-            static_cast<int>(g_GameState.leftTree.y),
-            g_GameState.leftTree.width,
-            g_GameState.leftTree.height
-        };
-        
-        SDL_Rect rightTreeRect = {
-            static_cast<int>(g_GameState.rightTree.x),
-            static_cast<int>(g_GameState.rightTree.y),
-            g_GameState.rightTree.width,
-            g_GameState.rightTree.height
+        // Draw strength bar fill (from bottom to top)
+        SDL_Rect strengthBarFill = {
+            strengthBarX,
+            static_cast<int>(strengthBarY + STRENGTH_BAR_HEIGHT * (1.0f - game.strengthCharge)),  // Start from bottom
+            STRENGTH_BAR_WIDTH,
+            static_cast<int>(STRENGTH_BAR_HEIGHT * game.strengthCharge)
         };
-
-        // Handle tree collisions
-        bool collided = false;
-        if (CheckCollision(eggRect, leftTreeRect))
-        {
-            printf("Left Tree Collision\n");
-            newX = g_GameState.leftTree.x + g_GameState.leftTree.width;
-            g_GameState.eggVelocityX = fabs(g_GameState.eggVelocityX) * 0.5f;
-            collided = true;
-            Mix_PlayChannel(-1, g_CrunchSound, 0);
-        }
-        else if (CheckCollision(eggRect, rightTreeRect))
-        {
-            printf("Right Tree Collision\n");
-            newX = g_GameState.rightTree.x - g_GameState.egg.width;
-            g_GameState.eggVelocityX = -fabs(g_GameState.eggVelocityX) * 0.5f;
-            collided = true;
-            Mix_PlayChannel(-1, g_CrunchSound, 0);
-        }
-
-        if (collided)
-        {
-            g_GameState.eggVelocityY *= 0.5f; // Reduce vertical velocity on collision
-            printf("Tree Collision - Adjusting Velocities: VelX=%.2f, VelY=%.2f\n",
-                   g_GameState.eggVelocityX, g_GameState.eggVelocityY);
-            g_GameState.eggVelocityY *= 0.5f;
-        }
-
-        // Finally update the actual position
-        g_GameState.egg.x = newX;
-        g_GameState.egg.y = newY;
-
-        // Check collision with squirrels
-        for (auto& squirrel : g_GameState.squirrels)
-        {
-            SDL_Rect squirrelRect = {
-                static_cast<int>(squirrel.x),
-                static_cast<int>(squirrel.y),
-                squirrel.spriteWidths[squirrel.currentSprite],
-                squirrel.spriteHeights[squirrel.currentSprite]
-            };
-
-            if (CheckCollision(eggRect, squirrelRect) && 
-                g_GameState.activeSquirrel != &squirrel &&
-                !g_GameState.isFirstFall) // does not check collision on first fall
-            {
-                HandleCollision(&squirrel);
-                printf("Egg caught by squirrel!\n");
-                break;
-            }
-        }
-
-        // Reset if egg goes off screen (left, right, or bottom) or hits bottom
-        if (g_GameState.egg.y > TOTAL_GAME_HEIGHT - EGG_SIZE_Y ||
-            g_GameState.egg.x < -g_GameState.egg.width ||
-            g_GameState.egg.x > WINDOW_WIDTH)
-        {
-            printf("Egg missed - giving to floor squirrel\n");
-            HandleCollision(&g_GameState.floorSquirrel);
-            Mix_PlayChannel(-1, g_CrunchSound, 0);
-
-            // reset timer
-            ResetTimer();
-            g_GameState.isFirstFall = 0; // clears after falling the first time
-        }
-
-
-        SDL_Rect floorSquirrelRect = {
-            static_cast<int>(g_GameState.floorSquirrel.x),
-            static_cast<int>(g_GameState.floorSquirrel.y),
-            g_GameState.floorSquirrel.spriteWidths[g_GameState.floorSquirrel.currentSprite],
-            g_GameState.floorSquirrel.spriteHeights[g_GameState.floorSquirrel.currentSprite]
-        };
-
-        if (CheckCollision(eggRect, floorSquirrelRect) && g_GameState.activeSquirrel != &g_GameState.floorSquirrel)
-        {
-            HandleCollision(&g_GameState.floorSquirrel);
-            printf("Egg caught by floor squirrel!\n");
-
-            g_GameState.floorSquirrel.currentSprite = 2;
-            g_GameState.egg.width = EGG_SIZE_X; // Make egg visible again
-            g_GameState.egg.height = EGG_SIZE_Y;
-            g_GameState.floorSquirrel.animationTimer = 0.0;
-        }
-
-        SDL_Rect nestRect = {
-            static_cast<int>(g_GameState.nest.x),
-            static_cast<int>(g_GameState.nest.y),
-            g_GameState.nest.width,
-            g_GameState.nest.height
-        };
-
-        // Check if egg reached the top - win condition
-        if (CheckCollision(eggRect, nestRect) )// g_GameState.egg.y <= 0)
-        {
-            if (g_TimerActive)  // Only save score once
-            {
-                printf("win condition achieved\n");
-                g_TimerActive = false;  // Stop the timer
-                SaveScore(SDL_GetTicks() - g_StartTime);  // Save the score
-                g_WinAchieved = true;
-                // teleport to floor squirrel
-                g_GameState.egg.x = g_GameState.floorSquirrel.x + 
-                    (g_GameState.floorSquirrel.spriteWidths[g_GameState.floorSquirrel.currentSprite] - g_GameState.egg.width) / 2;
-                g_GameState.egg.y = g_GameState.floorSquirrel.y - g_GameState.egg.height;
-                g_GameState.eggVelocityX = 0;
-                g_GameState.eggVelocityY = 0;
-                g_GameState.eggIsHeld = true;
-                g_GameState.activeSquirrel = &g_GameState.floorSquirrel;
-
-                Mix_PlayChannel(-1, g_WinSound, 0);
-            }
-        }
-
-    }
-}
-
-void UpdateControls()
-{
-    // Update strength bar
-    if (g_GameState.isCharging && !g_GameState.isDepletingCharge)
-    {
-        g_GameState.strengthCharge += STRENGTH_CHARGE_RATE;  // Adjust speed as needed
-        if (g_GameState.strengthCharge >= 1.0f)
-        {
-            g_GameState.strengthCharge = 1.0f;
-            g_GameState.isDepletingCharge = true;
-        }
-    }
-    else if (g_GameState.isDepletingCharge)
-    {
-        g_GameState.strengthCharge -= STRENGTH_CHARGE_RATE;  // Adjust speed as needed
-        if (g_GameState.strengthCharge <= 0.0f)
-        {
-            // Instead of dropping the egg, restart the charge cycle
-            g_GameState.strengthCharge = 0.0f;
-            g_GameState.isDepletingCharge = false;  // Switch back to charging mode
-            // Note: We keep isCharging true to continue the cycle
-        }
-    }
-
-    // Update angle square physics
-    if (g_GameState.eggIsHeld)
-    {
-        // Apply gravity to angle square
-        g_GameState.angleSquareVelocity += ANGLE_GRAVITY;
-        g_GameState.angleSquareY += g_GameState.angleSquareVelocity;
-
-        // Constrain to bar bounds
-        float maxY = ANGLE_BAR_Y + ANGLE_BAR_HEIGHT - ANGLE_SQUARE_SIZE;
-        if (g_GameState.angleSquareY > maxY)
-        {
-            g_GameState.angleSquareY = maxY;
-            g_GameState.angleSquareVelocity = 0;
-        }
-        else if (g_GameState.angleSquareY < ANGLE_BAR_Y)
-        {
-            g_GameState.angleSquareY = ANGLE_BAR_Y;
-            g_GameState.angleSquareVelocity = 0;
-        }
-    }
-}
-
-void RenderControls()
-{
-    if (g_GameState.eggIsHeld)
-    {
-        // Calculate strength bar position relative to egg
-        int x_offset = g_GameState.activeSquirrel->isLeftSide ? -10 : EGG_SIZE_X + 20;
-        int strengthBarX = static_cast<int>(g_GameState.egg.x) - STRENGTH_BAR_WIDTH + x_offset; // 10 pixels gap
-        int strengthBarY = static_cast<int>(g_GameState.egg.y) - g_GameState.cameraY - STRENGTH_BAR_HEIGHT/2 + g_GameState.egg.height/2;
-
-        // Draw strength bar background
-        SDL_Rect strengthBarBg = {
-            strengthBarX,
-            strengthBarY,
-            STRENGTH_BAR_WIDTH,
-            STRENGTH_BAR_HEIGHT
-        };
-        SDL_SetRenderDrawColor(g_Renderer, 100, 100, 100, 255);
-        SDL_RenderFillRect(g_Renderer, &strengthBarBg);
-
-        // Draw strength bar fill (from bottom to top)
-        SDL_Rect strengthBarFill = {
-            strengthBarX,
-            static_cast<int>(strengthBarY + STRENGTH_BAR_HEIGHT * (1.0f - g_GameState.strengthCharge)),  // Start from bottom
-            STRENGTH_BAR_WIDTH,
-            static_cast<int>(STRENGTH_BAR_HEIGHT * g_GameState.strengthCharge)
-        };
-        SDL_SetRenderDrawColor(g_Renderer, 
-            g_GameState.isDepletingCharge ? 255 : 0,  // Red if depleting
-            g_GameState.isDepletingCharge ? 0 : 255,  // Green if charging
+        SetDrawColor(
+            game.isDepletingCharge ? 255 : 0,  // Red if depleting
+            game.isDepletingCharge ? 0 : 255,  // Green if charging
             0, 
             255);
-        SDL_RenderFillRect(g_Renderer, &strengthBarFill);
+        DrawFillRect(&strengthBarFill);
 
         // Draw angle bar background
         // SDL_Rect angleBarBg = {
@@ -1134,7 +1123,7 @@ void RenderControls()
         // Draw angle square
         // SDL_Rect angleSquare = {
         //     ANGLE_BAR_X + (ANGLE_BAR_WIDTH - ANGLE_SQUARE_SIZE) / 2,
-        //     static_cast<int>(g_GameState.angleSquareY),
+        //     static_cast<int>(game.angleSquareY),
         //     ANGLE_SQUARE_SIZE,
         //     ANGLE_SQUARE_SIZE
         // };
@@ -1143,117 +1132,215 @@ void RenderControls()
     }
 }
 
-void LaunchEgg()
+void UpdateCamera(GameContext& game)
 {
-    if (g_GameState.activeSquirrel)
+    // Calculate target camera position (center egg vertically)
+    float screenCenterY = WINDOW_HEIGHT / 2.0f;
+    game.state.targetCameraY = game.state.egg.y - screenCenterY;
+
+    // Clamp camera to game bounds
+    if (game.endlessMode)
     {
-        g_GameState.activeSquirrel->currentSprite = 0;  // Change back to normal sprite
+        // No top in endless mode, only the floor
+        game.state.targetCameraY = std::min(game.state.targetCameraY, EndlessFloorBottom(game) - WINDOW_HEIGHT);
     }
-    // Calculate angle (0 at bottom, PI/2 at top)
-    float normalizedY = (ANGLE_BAR_Y + ANGLE_BAR_HEIGHT - ANGLE_SQUARE_SIZE - g_GameState.angleSquareY) 
-                     / (ANGLE_BAR_HEIGHT - ANGLE_SQUARE_SIZE);
-    float angle = normalizedY * PI / 2;  // Convert to radians (0 to PI/2)
-
-    // Calculate launch power
-    float power = LAUNCH_POWER_SCALE * g_GameState.strengthCharge;
-
-    // Calculate velocities using trigonometry
-    if (g_GameState.isLaunchingRight) {
-        g_GameState.eggVelocityX = power * cos(angle);
-    } else {
-        g_GameState.eggVelocityX = -power * cos(angle);  // Negative for left direction
+    else
+    {
+        game.state.targetCameraY = std::max(0.0f, game.state.targetCameraY);
+        game.state.targetCameraY = std::min(game.state.targetCameraY, TOTAL_GAME_HEIGHT - WINDOW_HEIGHT);
     }
-    g_GameState.eggVelocityY = -power * sin(angle);
-
-    // Release the egg
-    g_GameState.eggIsHeld = false;
-    g_GameState.isCharging = false;
     
-    printf("Launch - Power: %.2f, Angle: %.2f degrees, Direction: %s, VelX: %.2f, VelY: %.2f\n",
-           power, angle * 180 / PI, g_GameState.isLaunchingRight ? "Right" : "Left", 
-           g_GameState.eggVelocityX, g_GameState.eggVelocityY);
+    // Smooth camera movement (lerp)
+    float smoothSpeed = 0.1f;
+    game.state.cameraY += (game.state.targetCameraY - game.state.cameraY) * smoothSpeed;
+}
 
+float EndlessChunkTopY(const GameContext& game, int chunkIndex)
+{
+    return static_cast<float>(game.endless.originChunk - chunkIndex) * LEVEL_CHUNK_HEIGHT;
+}
 
-    // if timer had not started yet, start it
-    if (!g_TimerActive)
-        {
-            g_StartTime = SDL_GetTicks();
-            g_TimerActive = true;
-            g_WinAchieved = false;
-        }
-    //g_GameState.activeSquirrel = nullptr;  // Clear active squirrel
-    g_GameState.currentEggSprite = 0;  // Reset to closed sprite when launching
+float EndlessFloorBottom(const GameContext& game)
+{
+    return EndlessChunkTopY(game, 0) + LEVEL_CHUNK_HEIGHT;
+}
 
-    PlayRandomLaunchSound();
+int EndlessChunkAt(const GameContext& game, float y)
+{
+    return game.endless.originChunk - static_cast<int>(floorf(y / LEVEL_CHUNK_HEIGHT));
 }
 
-void UpdateCamera()
+void AppendEndlessChunk(GameContext& game, const LevelChunk& chunk)
 {
-    // Calculate target camera position (center egg vertically)
-    float screenCenterY = WINDOW_HEIGHT / 2.0f;
-    g_GameState.targetCameraY = g_GameState.egg.y - screenCenterY;
+    float chunkTop = EndlessChunkTopY(game, chunk.index);
+    SquirrelMetrics metrics = GetSquirrelMetrics();
 
-    // Clamp camera to game bounds
-    g_GameState.targetCameraY = std::max(0.0f, g_GameState.targetCameraY);
-    g_GameState.targetCameraY = std::min(g_GameState.targetCameraY, TOTAL_GAME_HEIGHT - WINDOW_HEIGHT);
-    
-    // Smooth camera movement (lerp)
-    float smoothSpeed = 0.1f;
-    g_GameState.cameraY += (g_GameState.targetCameraY - g_GameState.cameraY) * smoothSpeed;
+    // LEVEL_ENTITY_CAPACITY covers the whole chunk pool, so appends always fit
+    for (int i = 0; i < chunk.count; i++)
+    {
+        PoolAppend(game.state.branches, MakeBranchObject(chunk.branches[i], chunkTop));
+        PoolAppend(game.state.squirrels, MakeSquirrelObject(chunk.squirrels[i], chunkTop, metrics));
+    }
 }
 
-void ResetLevel()
+// Drops the lowest resident chunk. Returns false if the egg's squirrel lives in it.
+bool EvictLowestEndlessChunk(GameContext& game)
 {
-    GenerateBranchesAndSquirrels();
-    
-    // Reset egg to floor squirrel
-    g_GameState.egg.x = g_GameState.floorSquirrel.x + 
-        (g_GameState.floorSquirrel.spriteWidths[g_GameState.floorSquirrel.currentSprite] - g_GameState.egg.width) / 2;
-    g_GameState.egg.y = g_GameState.floorSquirrel.y - g_GameState.egg.height;
-    g_GameState.eggVelocityX = 0;
-    g_GameState.eggVelocityY = 0;
-    g_GameState.eggIsHeld = true;
-    g_GameState.activeSquirrel = &g_GameState.floorSquirrel;
+    LevelChunk* chunk = game.endless.resident[0];
+    if (PoolIsLive(game.state.squirrels, game.state.activeSquirrel) &&
+        game.state.activeSquirrel - game.state.squirrels.first < static_cast<uint32_t>(chunk->count))
+    {
+        return false;
+    }
+
+    // Objects above keep their slots, so handles to them stay valid
+    PoolEvictOldest(game.state.branches, chunk->count);
+    PoolEvictOldest(game.state.squirrels, chunk->count);
+
+    ReleaseChunk(game.endless.streamer, chunk);
+    for (int i = 1; i < game.endless.residentCount; i++)
+        game.endless.resident[i - 1] = game.endless.resident[i];
+    game.endless.residentCount--;
+    return true;
+}
+
+// Moves the world origin to the top of newOrigin, shifting everything by whole chunks
+void RebaseEndlessOrigin(GameContext& game, int newOrigin)
+{
+    int shiftPixels = (newOrigin - game.endless.originChunk) * LEVEL_CHUNK_HEIGHT;
+    float shift = static_cast<float>(shiftPixels);
+
+    game.state.egg.y += shift;
+    game.state.eggFixedY += FixedFromInt(shiftPixels);
+    game.state.cameraY += shift;
+    game.state.targetCameraY += shift;
+    game.state.floorSquirrel.y += shift;
+    for (auto& branch : game.state.branches) branch.y += shift;
+    for (auto& squirrel : game.state.squirrels) squirrel.y += shift;
+
+    game.endless.originChunk = newOrigin;
 }
 
-void StartStrengthCharge()
+void UpdateEndless(GameContext& game)
 {
-    if (g_GameState.eggIsHeld && !g_GameState.isCharging)
+    int eggChunk = EndlessChunkAt(game, game.state.egg.y);
+    if (eggChunk != game.endless.originChunk)
     {
-        g_GameState.isCharging = true;
-        g_GameState.isDepletingCharge = false;
-        g_GameState.strengthCharge = 0.0f;
+        RebaseEndlessOrigin(game, eggChunk);
     }
+
+    RequestChunksUpTo(game.endless.streamer, eggChunk + ENDLESS_CHUNKS_AHEAD);
+    while (LevelChunk* chunk = PollReadyChunk(game.endless.streamer))
+    {
+        AppendEndlessChunk(game, *chunk);
+        game.endless.resident[game.endless.residentCount++] = chunk;
+    }
+
+    while (game.endless.residentCount > 0 &&
+           game.endless.resident[0]->index < eggChunk - ENDLESS_CHUNKS_BEHIND)
+    {
+        if (!EvictLowestEndlessChunk(game)) break;
+    }
+
+    int height = static_cast<int>(EndlessFloorBottom(game) - game.state.egg.y - game.state.egg.height);
+    game.endless.bestHeight = std::max(game.endless.bestHeight, height);
 }
 
-void HitAngleSquare()
+// Back to the floor of chunk 0, called on start and after every miss
+void ResetEndless(GameContext& game)
 {
-    // Jump the angle square with strength based on current charge
-    // float jumpPower = ANGLE_JUMP_POWER * g_GameState.strengthCharge;
-    float jumpPower = ANGLE_JUMP_POWER;
-    g_GameState.angleSquareVelocity = -jumpPower;
+    ResetPool(game.state.branches);
+    ResetPool(game.state.squirrels);
+    game.endless.residentCount = 0;
+
+    int shiftPixels = -game.endless.originChunk * LEVEL_CHUNK_HEIGHT;
+    float shift = static_cast<float>(shiftPixels);
+    game.state.egg.y += shift;
+    game.state.eggFixedY += FixedFromInt(shiftPixels);
+    game.state.cameraY += shift;
+    game.state.targetCameraY += shift;
+    game.endless.originChunk = 0;
+
+    float floorX, floorY;
+    FloorSquirrelPosition(GetSquirrelMetrics(), LEVEL_CHUNK_HEIGHT, floorX, floorY);
+    game.state.floorSquirrel.x = floorX;
+    game.state.floorSquirrel.y = floorY;
+
+    RestartChunkStreamer(game.endless.streamer, game.levelSeed, DefaultLevelParams(), GetSquirrelMetrics());
+    RequestChunksUpTo(game.endless.streamer, ENDLESS_CHUNKS_AHEAD);
 }
 
-void ResetTimer()
+void InitEndless(GameContext& game)
 {
-    g_StartTime = SDL_GetTicks();
-    g_TimerActive = false;
-    
+    // No nest, and misses are judged against the streamed floor (set every step)
+    game.state.endless = true;
+
+    // Trees run the whole way up
+    game.state.leftTree.y = game.state.rightTree.y = -1000000.0f;
+    game.state.leftTree.height = game.state.rightTree.height = 2000000;
+
+    game.endless.originChunk = 0;
+    game.endless.bestHeight = 0;
+    StartChunkStreamer(game.endless.streamer, game.levelSeed, DefaultLevelParams(), GetSquirrelMetrics());  // For the session
+    ResetEndless(game);
+
+    // Start on the floor squirrel, there is no nest to fall from
+    game.state.isInNest = false;
+    game.state.isFirstFall = false;
+    game.state.egg.x = game.state.floorSquirrel.x +
+        (game.state.floorSquirrel.spriteWidths[game.state.floorSquirrel.currentSprite] - game.state.egg.width) / 2;
+    game.state.egg.y = game.state.floorSquirrel.y - game.state.egg.height;
+    game.state.eggVelocityX = 0;
+    game.state.eggVelocityY = 0;
+    game.state.eggIsHeld = true;
+    game.state.activeSquirrel = FLOOR_SQUIRREL_HANDLE;
+    game.state.cameraY = game.state.targetCameraY = EndlessFloorBottom(game) - WINDOW_HEIGHT;
+}
 
-            g_GameState.floorSquirrel.currentSprite = 2;
-            g_GameState.egg.width = EGG_SIZE_X; // Make egg visible again
-            g_GameState.egg.height = EGG_SIZE_Y;
-            g_GameState.floorSquirrel.animationTimer = 0.0;
+void RenderEndlessBackground()
+{
+    const GameState& game = g_View->game;
+    float floorBottom = g_View->endlessFloorBottom;
+    int startScreen = static_cast<int>(floorf(game.cameraY / WINDOW_HEIGHT));
+
+    for (int screen = startScreen; screen <= startScreen + 1; screen++)
+    {
+        int screenTop = screen * WINDOW_HEIGHT;
+        SDL_Rect destRect = {
+            0,
+            screenTop - static_cast<int>(game.cameraY),
+            WINDOW_WIDTH,
+            WINDOW_HEIGHT
+        };
+
+        // The bottom screen keeps the ground, everything above repeats
+        SDL_Texture* bgTexture = (screenTop + WINDOW_HEIGHT >= floorBottom) ? g_BackgroundBase : g_BackgroundModular;
+        DrawCopy(bgTexture, &destRect);
+    }
+}
+
+void RenderEndlessHeight()
+{
+    const GameState& game = g_View->game;
+    char text[64];
+    int height = static_cast<int>(g_View->endlessFloorBottom - game.egg.y - game.egg.height);
+    snprintf(text, sizeof(text), "%dm (best %dm)", std::max(0, height) / 100, g_View->endlessBestHeight / 100);
+    RenderText(text, TIMER_X - 100, TIMER_Y, TIMER_FONT_SIZE);
 }
 
 void RenderTimer()
 {
-    if (!g_TimerActive) return;
+    const GameState& game = g_View->game;
+    if (game.endless)
+    {
+        RenderEndlessHeight();
+        return;
+    }
+
+    if (!game.timerActive) return;
 
-    // Calculate elapsed time
-    Uint32 currentTime = SDL_GetTicks();
-    Uint32 elapsedTime = currentTime - g_StartTime;
-    g_lastElapsedTime = elapsedTime;
+    // Calculate elapsed time, in simulation frames so it matches the saved score
+    Uint32 elapsedTime = FramesToMs(game.frame - game.timerStartFrame);
     
     // Convert to minutes:seconds.milliseconds
     int minutes = (elapsedTime / 1000) / 60;
@@ -1261,170 +1348,338 @@ void RenderTimer()
     int milliseconds = elapsedTime % 1000;
 
     // Format time string
-    std::stringstream ss;
-    ss << std::setfill('0') << std::setw(2) << minutes << ":"
-       << std::setfill('0') << std::setw(2) << seconds << "."
-       << std::setfill('0') << std::setw(2) << (milliseconds / 10);
-    
-    // Set outline thickness (1-5 pixels)
-    TTF_SetFontOutline(g_Font, 0);
+    char text[32];
+    snprintf(text, sizeof(text), "%02d:%02d.%02d", minutes, seconds, milliseconds / 10);
 
-    // Create surface with outline
-    SDL_Color textColor = {255, 255, 255, 255};  // White text
-    SDL_Color outlineColor = {135, 206, 235, 255};     // Light blue outline
-    SDL_Surface* surface = TTF_RenderText_Shaded(g_Font, ss.str().c_str(), textColor, outlineColor);
-    if (!surface) return;
-
-    // Render timer
-    SDL_Rect timerRect = {
-        TIMER_X,
-        TIMER_Y,
-        surface->w,
-        surface->h
-    };
+    RenderText(text, TIMER_X, TIMER_Y, TIMER_FONT_SIZE);
+}
+ 
+void FormatRunTime(char* text, size_t size, uint32_t time)
+{
+    snprintf(text, size, "%02u:%02u.%03u", (time / 1000) / 60, (time / 1000) % 60, time % 1000);
+}
 
-    // Create texture
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(g_Renderer, surface);
-    SDL_FreeSurface(surface);
-    if (!texture) return;
+// Best times on this seed, then where the last run landed among them
+void RefreshScoreBoard(GameContext& game)
+{
+    const ScoreIndex& index = LocalScoresForSeed(game.scoreBoard.scores, game.levelSeed);
+    game.scoreBoard.lines.clear();
 
-    SDL_RenderCopy(g_Renderer, texture, nullptr, &timerRect);
-    SDL_DestroyTexture(texture);
-    
-    // Reset outline for other text rendering
-    TTF_SetFontOutline(g_Font, 0);
-    
-    // Debug texture info
-    // printf("Timer texture info - S %s, Position: (%d, %d), Size: (%d, %d)\n",
-    //        ss.str().c_str(), timerRect.x, timerRect.y, timerRect.w, timerRect.h);
+    char line[64], time[16];
+    for (uint32_t rank = 1; rank <= SCORE_BOARD_SIZE; rank++)
+    {
+        uint32_t timeMs;
+        if (!ScoreAtRank(index, rank, timeMs)) break;
+        FormatRunTime(time, sizeof(time), timeMs);
+        snprintf(line, sizeof(line), "%u. %s", rank, time);
+        game.scoreBoard.lines.push_back(line);
+    }
+
+    if (game.scoreBoard.lastTime > 0)
+    {
+        snprintf(line, sizeof(line), "Last: #%u of %u", ScoreRank(index, game.scoreBoard.lastTime), index.count);
+        game.scoreBoard.lines.push_back(line);
+        snprintf(line, sizeof(line), "Beat %.0f%% of runs", ScorePercentile(index, game.scoreBoard.lastTime));
+        game.scoreBoard.lines.push_back(line);
+    }
 }
- 
-void SaveScore(Uint32 time)
+
+#ifdef __EMSCRIPTEN__
+// Web version - localStorage only holds strings, so the whole file goes in as base64
+void StoreLocalScores(GameContext& game)
+{
+    ByteWriter writer;
+    EncodeLocalScores(game.scoreBoard.scores, writer);
+    std::string encoded = Base64Encode(writer.bytes.data(), writer.bytes.size());
+    WriteStorageWhenIdle("localScores", encoded.c_str());
+}
+
+char* GetLocalStorageString(const char* key)
+{
+    return (char*)EM_ASM_INT({
+        var value = localStorage.getItem(UTF8ToString($0));
+        if (value === null) return 0;
+        var lengthBytes = lengthBytesUTF8(value) + 1;
+        var stringOnWasmHeap = _malloc(lengthBytes);
+        stringToUTF8(value, stringOnWasmHeap, lengthBytes);
+        return stringOnWasmHeap;
+    }, key);
+}
+#endif
+
+// Reads every recorded run once at startup, importing the old text scores if that is all there is.
+// Old scores were all set on the fixed layout, which is the default seed.
+void LoadScores(GameContext& game)
 {
     #ifdef __EMSCRIPTEN__
-    // Web version - use localStorage
-    int minutes = (time / 1000) / 60;
-    int seconds = (time / 1000) % 60;
-    int milliseconds = time % 1000;
-    
-    char scoreStr[32];
-    snprintf(scoreStr, sizeof(scoreStr), "%02d:%02d.%03d", minutes, seconds, milliseconds);
-    EM_ASM({
-        // Get existing scores
-        var scores = localStorage.getItem('scores') || "";
-        // Add new score
-        scores += UTF8ToString($0) + '\n';
-        // Keep only last 5 scores
-        var scoresArray = scores.trim().split('\n');
-        if (scoresArray.length > 5) {
-            scoresArray = scoresArray.slice(-5);
-            scores = scoresArray.join('\n') + '\n';
-        }
-        // Save back to localStorage
-        localStorage.setItem('scores', scores);
-    }, scoreStr);
-    
+    char* stored = GetLocalStorageString("localScores");
+    if (stored)
+    {
+        std::vector<uint8_t> bytes = Base64Decode(stored);
+        DecodeLocalScores(game.scoreBoard.scores, bytes.data(), bytes.size());
+        free(stored);
+    }
+    else if ((stored = GetLocalStorageString("scores")))
+    {
+        int imported = ImportTextScores(game.scoreBoard.scores, stored, DEFAULT_LEVEL_SEED);
+        free(stored);
+        printf("Imported %d scores from localStorage\n", imported);
+        StoreLocalScores(game);
+    }
     #else
-    // Desktop version - use file
-    FILE* file = fopen(SCORE_FILE, "a");  // Open in append mode
-    if (file) {
-        int minutes = (time / 1000) / 60;
-        int seconds = (time / 1000) % 60;
-        int milliseconds = time % 1000;
-        
-        fprintf(file, "%02d:%02d.%03d\n", minutes, seconds, milliseconds);
-        fclose(file);
+    if (!LoadLocalScoresFile(game.scoreBoard.scores, SCORE_FILE))
+    {
+        FILE* legacy = fopen(LEGACY_SCORE_FILE, "r");
+        if (legacy)
+        {
+            std::string text;
+            char line[64];
+            while (fgets(line, sizeof(line), legacy)) text += line;
+            fclose(legacy);
+
+            int imported = ImportTextScores(game.scoreBoard.scores, text.c_str(), DEFAULT_LEVEL_SEED);
+            printf("Imported %d scores from %s\n", imported, LEGACY_SCORE_FILE);
+            ByteWriter writer;
+            EncodeLocalScores(game.scoreBoard.scores, writer);
+            game.scoreBoard.scores.appendedRuns = 0;
+            QueueFileWrite(g_Writer, SCORE_FILE, std::move(writer.bytes), WRITE_REPLACE);
+        }
     }
     #endif
+
+    RefreshScoreBoard(game);
 }
 
-void RenderWinMessage()
+void SaveScore(GameContext& game, Uint32 time)
 {
-    if (g_TimerActive || !g_WinAchieved) return;  // Only show when game is won
+    #ifdef __EMSCRIPTEN__
+    AddLocalScore(game.scoreBoard.scores, game.levelSeed, time);
+    StoreLocalScores(game);
+    #else
+    ByteWriter writer;
+    bool replace = SaveLocalScore(game.scoreBoard.scores, game.levelSeed, time, writer);
+    QueueFileWrite(g_Writer, SCORE_FILE, std::move(writer.bytes), replace ? WRITE_REPLACE : WRITE_APPEND);
+    #endif
 
-    // Calculate final time
-    int minutes = (g_lastElapsedTime / 1000) / 60;
-    int seconds = (g_lastElapsedTime / 1000) % 60;
-    int milliseconds = g_lastElapsedTime % 1000;
+    game.scoreBoard.lastTime = time;
+    RefreshScoreBoard(game);
 
-    // Format win message
-    std::stringstream ss;
-    ss << "Final Time: " << std::setfill('0') << std::setw(2) << minutes 
-       << ":" << std::setfill('0') << std::setw(2) << seconds  << "."
-       << std::setfill('0') << std::setw(2) << (milliseconds / 10);
+    const ScoreIndex& index = LocalScoresForSeed(game.scoreBoard.scores, game.levelSeed);
+    printf("Run saved, rank %u of %u on seed %u\n", ScoreRank(index, time), index.count, game.levelSeed);
+}
 
-    // Create surface
-    SDL_Color textColor = {255, 255, 255, 255};  // White color
+// Reads the stored best run, if there is one for the current seed
+void LoadGhostRun(GameContext& game)
+{
+    #ifdef __EMSCRIPTEN__
+    // Web version - base64 in localStorage, decoded into memory (a few KB)
+    char* ghostStr = (char*)EM_ASM_INT({
+        var ghost = localStorage.getItem('ghost');
+        if (!ghost) return 0;
+        var lengthBytes = lengthBytesUTF8(ghost) + 1;
+        var stringOnWasmHeap = _malloc(lengthBytes);
+        stringToUTF8(ghost, stringOnWasmHeap, lengthBytes);
+        return stringOnWasmHeap;
+    });
+    if (!ghostStr) return;
+    LoadGhost(game.ghost.player, Base64Decode(ghostStr));
+    free(ghostStr);
+    #else
+    // Desktop version - streamed from the file while it plays
+    LoadGhost(game.ghost.player, fopen(GHOST_FILE, "rb"));
+    #endif
 
-    SDL_Color outlineColor = {135, 206, 235, 255}; // Light blue outline
-    SDL_Surface *surface = TTF_RenderText_Shaded(g_Font, ss.str().c_str(), textColor, outlineColor);
-    if (!surface)
-        return;
+    if (game.ghost.player.loaded && game.ghost.player.seed != game.levelSeed)
+    {
+        printf("Ghost is for seed %u, not showing it\n", game.ghost.player.seed);
+        CloseGhost(game.ghost.player);
+    }
+}
 
-    // Create texture
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(g_Renderer, surface);
-    SDL_FreeSurface(surface);
-    if (!texture) return;
+void SaveGhostRun(const ByteWriter& ghost)
+{
+    #ifdef __EMSCRIPTEN__
+    std::string encoded = Base64Encode(ghost.bytes.data(), ghost.bytes.size());
+    WriteStorageWhenIdle("ghost", encoded.c_str());
+    #else
+    QueueFileWrite(g_Writer, GHOST_FILE, std::vector<uint8_t>(ghost.bytes), WRITE_REPLACE);
+    #endif
+}
 
-    // Center the text
-    SDL_Rect messageRect = {
-        WIN_MESSAGE_X - surface->w / 2,  // Center horizontally
-        WIN_MESSAGE_Y - surface->h / 2,  // Center vertically
-        surface->w,
-        surface->h
-    };
+// Called when the timer starts
+void StartGhostRun(GameContext& game)
+{
+    if (game.endlessMode) return;
 
-    SDL_RenderCopy(g_Renderer, texture, nullptr, &messageRect);
-    SDL_DestroyTexture(texture);
+    StartGhostRecording(game.ghost.recorder);
+    RestartGhost(game.ghost.player);
 }
 
-void UpdateEggAnimation(float deltaTime)
+void StopGhostRun(GameContext& game)
 {
-    // printf("deltaTime: %.4f, eggAnimationTime: %.4f, EGG_ANIMATION_SPEED: %.4f\n",
-    //        deltaTime, g_EggAnimationTime, EGG_ANIMATION_SPEED);
+    game.ghost.recorder.active = false;
+    game.ghost.visible = false;
+}
 
-    int oldSprite = g_GameState.currentEggSprite;
-    
-    if (!g_GameState.eggIsHeld)
+void UpdateGhost(GameContext& game)
+{
+    if (!game.state.timerActive) return;
+
+    RecordGhostFrame(game.ghost.recorder, game.state.egg.x, game.state.egg.y);
+    game.ghost.visible = StepGhost(game.ghost.player, game.ghost.egg.x, game.ghost.egg.y);
+}
+
+// Keeps the run as the new ghost if it beat the old one
+void FinishGhostRun(GameContext& game, Uint32 time)
+{
+    game.ghost.visible = false;
+    if (!game.ghost.recorder.active) return;
+
+    bool isBest = !game.ghost.player.loaded || time < game.ghost.player.durationMs;
+    ByteWriter ghost;
+    FinishGhostRecording(game.ghost.recorder, game.levelSeed, time, ghost);
+    if (!isBest) return;
+
+    printf("New best run, saving ghost (%zu bytes)\n", ghost.bytes.size());
+    CloseGhost(game.ghost.player);  // Releases the file before it gets rewritten
+    SaveGhostRun(ghost);
+    LoadGhost(game.ghost.player, std::move(ghost.bytes));  // From memory, the file may not be written yet
+}
+
+// Opens path and takes the level seed from it, before the level is built
+bool OpenReplay(GameContext& game, const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file)
     {
-        // When flying/idle, use closed egg sprite
-        g_GameState.currentEggSprite = 0;
-        g_EggAnimationTime = 0.0f;
+        printf("Could not open replay %s\n", path);
+        return false;
     }
-    else
+
+    OpenByteReader(game.replay.player.reader, file);
+    if (!StartReplayPlayback(game.replay.player))
     {
-        // When held, cycle through sprites
-        g_EggAnimationTime += deltaTime;
-        if (g_EggAnimationTime >= EGG_ANIMATION_SPEED)
-        {
-            g_EggAnimationTime = 0.0f;
-            if (g_GameState.currentEggSprite!=2)
-                g_GameState.currentEggSprite++; // clamps at the third animation
-        }
+        printf("%s is not a replay this build can play\n", path);
+        CloseByteReader(game.replay.player.reader);
+        return false;
     }
 
-    if (oldSprite != g_GameState.currentEggSprite) {
-        printf("Egg sprite changed from %d to %d (%s)\n", 
-               oldSprite, 
-               g_GameState.currentEggSprite,
-               g_GameState.eggIsHeld ? "held" : "not held");
+    if (game.replay.player.header.buildHash != BUILD_HASH)
+        printf("Replay was recorded by build %08x, this is %08x\n", game.replay.player.header.buildHash, (unsigned)BUILD_HASH);
+    if (!ReplayPhysicsMatch(game.replay.player.header))
+        printf("Replay was recorded with different physics constants, expect it to diverge\n");
+    if (!LayoutTunablesAreDefault())
+        printf("Layout tunables differ from the defaults the replay was recorded with, expect it to diverge\n");
+
+    game.levelSeed = game.replay.player.header.seed;
+    game.fixedPhysics = (game.replay.player.header.flags & REPLAY_FLAG_FIXED_PHYSICS) != 0;
+    game.replay.playing = true;
+    printf("Playing replay %s (seed %u)\n", path, game.levelSeed);
+    return true;
+}
+
+void StopReplayPlayback(GameContext& game)
+{
+    const ReplayPlayer& player = game.replay.player;
+    switch (player.status)
+    {
+    case REPLAY_FINISHED:
+        printf("Replay finished at frame %u (%s), all checksums matched\n",
+               player.endFrame, player.won ? "reached the nest" : "did not finish");
+        break;
+    case REPLAY_DIVERGED:
+        if (player.everyFrame)
+            printf("Replay diverged at frame %u\n", player.divergedFrame);
+        else
+            printf("Replay diverged between frame %u and %u\n", player.lastGoodChecksumFrame, player.divergedFrame);
+        break;
+    case REPLAY_CORRUPT:
+        printf("Replay data ended unexpectedly after frame %u\n", player.lastGoodChecksumFrame);
+        break;
     }
+
+    CloseByteReader(game.replay.player.reader);
+    game.replay.playing = false;
+    printf("Back to live input\n");
 }
 
-// First, move the sprite dimension loading to a separate function
-void LoadSquirrelSpriteDimensions(GameObject& squirrel) {
-    for (int i = 0; i < SPRITE_SQUIRREL_MAX_VALUE; i++) {
-        int width, height;
-        SDL_QueryTexture(g_SquirrelTextures[i], nullptr, nullptr, &width, &height);
-        squirrel.spriteWidths[i] = static_cast<int>(width * SQUIRREL_SCALE);
-        squirrel.spriteHeights[i] = static_cast<int>(height * SQUIRREL_SCALE);
+// Desktop records with --record, or in memory when submitting to a leaderboard, which
+// only takes runs with their replay. The web build always records and keeps the last
+// session that reached the nest. Replays start at launch, so one per session, and only
+// a session's first win can be submitted.
+void StartSessionRecording(GameContext& game)
+{
+#ifndef __EMSCRIPTEN__
+    if (!game.replay.recordPath && !g_Leaderboard.enabled) return;
+#endif
+    if (game.replay.playing) return;
+    if (game.endlessMode)
+    {
+        // Chunks arrive from a worker thread, so the same inputs need not give the same run
+        printf("Replays are not recorded in endless mode\n");
+        return;
     }
+    if (!LayoutTunablesAreDefault())
+    {
+        printf("Layout tunables differ from the defaults, which replays cannot describe, not recording\n");
+        return;
+    }
+    StartReplayRecording(game.replay.recorder, game.levelSeed, game.fixedPhysics ? REPLAY_FLAG_FIXED_PHYSICS : 0);
+}
+
+// frame is the last one simulated
+void FinishReplayRun(GameContext& game, bool won, uint32_t frame)
+{
+    if (!game.replay.recorder.active) return;
+
+    FinishReplayRecording(game.replay.recorder, frame, won);
+    const std::vector<uint8_t>& bytes = game.replay.recorder.writer.bytes;
+
+    #ifdef __EMSCRIPTEN__
+    if (!won) return;
+    std::string encoded = Base64Encode(bytes.data(), bytes.size());
+    WriteStorageWhenIdle("replay", encoded.c_str());
+    #else
+    if (!game.replay.recordPath) return;  // Recorded for the leaderboard only
+    QueueFileWrite(g_Writer, game.replay.recordPath, std::vector<uint8_t>(bytes), WRITE_REPLACE);
+    #endif
+    printf("Replay saved: %u frames in %zu bytes\n", frame + 1, bytes.size());
+}
+
+void RenderWinMessage()
+{
+    const GameState& game = g_View->game;
+    if (game.timerActive || !game.winAchieved) return;  // Only show when game is won
+
+    // Calculate final time
+    int minutes = (g_View->lastElapsedTime / 1000) / 60;
+    int seconds = (g_View->lastElapsedTime / 1000) % 60;
+    int milliseconds = g_View->lastElapsedTime % 1000;
+
+    // Format win message
+    char text[48];
+    snprintf(text, sizeof(text), "Final Time: %02d:%02d.%02d", minutes, seconds, milliseconds / 10);
+
+    int width, height;
+    SDL_Texture* texture = GetTextTexture(text, WIN_MESSAGE_FONT_SIZE, width, height);
+    if (!texture) return;
+
+    // Center the text
+    SDL_Rect messageRect = {
+        WIN_MESSAGE_X - width / 2,  // Center horizontally
+        WIN_MESSAGE_Y - height / 2,  // Center vertically
+        width,
+        height
+    };
+
+    DrawCopy(texture, &messageRect);
 }
 
 void RenderInstructions()
 {
+    const GameState& game = g_View->game;
     // Change condition to show instructions when egg is in nest
-    if (g_GameState.isInNest)
+    if (game.isInNest)
     {
         // Calculate the background rectangle dimensions
         int textWidth = 280;  // Adjust this value to fit your text
@@ -1433,14 +1688,14 @@ void RenderInstructions()
         int textY = 400;  // Move text to top of screen
         
         // Draw background rectangle
-        SDL_SetRenderDrawColor(g_Renderer, 135, 206, 235, 180);  // Light blue with some transparency
+        SetDrawColor(135, 206, 235, 180);  // Light blue with some transparency
         SDL_Rect bgRect = {
             textX - 10,
             textY - 10,
             textWidth + 20,
             textHeight + 20
         };
-        SDL_RenderFillRect(g_Renderer, &bgRect);
+        DrawFillRect(&bgRect);
 
         // Change instruction text for initial nest release
         RenderText("Press ENTER or SPACE", 
@@ -1458,10 +1713,10 @@ void RenderInstructions()
                   textY + 80, 
                   INSTRUCTION_FONT_SIZE);
 
-        RenderLastScores();
+        RenderScoreBoard();
     }
     // Keep existing instructions for when floor squirrel has the egg
-    else if (g_GameState.eggIsHeld && g_GameState.activeSquirrel == &g_GameState.floorSquirrel)
+    else if (game.eggIsHeld && game.activeSquirrel == FLOOR_SQUIRREL_HANDLE)
     {
         // Calculate the background rectangle dimensions
         int textWidth = 340;  // Adjust this value to fit your text
@@ -1470,14 +1725,14 @@ void RenderInstructions()
         int textY = INSTRUCTION_Y;
         
         // Draw background rectangle
-        SDL_SetRenderDrawColor(g_Renderer, 135, 206, 235, 180);  // Light blue with some transparency
+        SetDrawColor(135, 206, 235, 180);  // Light blue with some transparency
         SDL_Rect bgRect = {
             textX - 10,           // Add some padding
             textY - 10,           // Add some padding
             textWidth ,       // Add padding on both sides
             textHeight + 2       // Add padding on both sides
         };
-        SDL_RenderFillRect(g_Renderer, &bgRect);
+        DrawFillRect(&bgRect);
         
 
         // Render the text
@@ -1495,227 +1750,754 @@ void RenderInstructions()
                   textX, 
                   textY + 80, 
                   INSTRUCTION_FONT_SIZE);
-        RenderLastScores();
+        RenderScoreBoard();
     }
 }
 
-void RenderText(const char* text, int x, int y, int fontSize)
+TTF_Font* GetSizedFont(int fontSize)
 {
-    // Set font size
+    for (const auto& font : g_TextCache.fonts)
+    {
+        if (font.first == fontSize) return font.second;
+    }
+
     TTF_Font* sizedFont = TTF_OpenFont("assets/VCR_OSD_MONO_1.001.ttf", fontSize);
     if (!sizedFont) {
         printf("Failed to load font for size %d! SDL_ttf Error: %s\n", fontSize, TTF_GetError());
-        return;
+        return nullptr;
     }
+    g_TextCache.fonts.push_back({fontSize, sizedFont});
+    return sizedFont;
+}
+
+// Texture for text at fontSize, rasterized only if it was not drawn recently.
+// Owned by the cache: valid until the next call.
+SDL_Texture* GetTextTexture(const char* text, int fontSize, int& width, int& height)
+{
+    CachedText* oldest = nullptr;
+    for (CachedText& entry : g_TextCache.entries)
+    {
+        if (entry.fontSize == fontSize && entry.text == text)
+        {
+            entry.lastUsed = g_TextCache.renderCount;
+            width = entry.width;
+            height = entry.height;
+            return entry.texture;
+        }
+        if (!oldest || entry.lastUsed < oldest->lastUsed) oldest = &entry;
+    }
+
+    TTF_Font* sizedFont = GetSizedFont(fontSize);
+    if (!sizedFont) return nullptr;
 
     // Create surface
     SDL_Color textColor = {255, 255, 255, 255};  // White text
     SDL_Color outlineColor = {135, 206, 235, 255};  // Light blue outline
     SDL_Surface* surface = TTF_RenderText_Shaded(sizedFont, text, textColor, outlineColor);
-    if (!surface) {
-        TTF_CloseFont(sizedFont);
-        return;
-    }
+    if (!surface) return nullptr;
 
     // Create texture
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(g_Renderer, surface);
-    if (!texture) {
-        SDL_FreeSurface(surface);
-        TTF_CloseFont(sizedFont);
-        return;
+    SDL_Texture* texture = CreateTexture(surface);
+    width = surface->w;
+    height = surface->h;
+    SDL_FreeSurface(surface);
+    if (!texture) return nullptr;
+
+    // Strings that change every frame (the timer) keep replacing the least recently drawn one
+    if (g_TextCache.entries.size() < TEXT_CACHE_SIZE)
+    {
+        g_TextCache.entries.push_back(CachedText());
+        oldest = &g_TextCache.entries.back();
+    }
+    else
+    {
+        // Every entry drawn this frame: the recorded draws still need the texture
+        if (oldest->lastUsed == g_TextCache.renderCount) FlushDrawCommands();
+        SDL_DestroyTexture(oldest->texture);
     }
+    *oldest = {text, fontSize, texture, width, height, g_TextCache.renderCount};
+    return texture;
+}
+
+void RenderText(const char* text, int x, int y, int fontSize)
+{
+    int width, height;
+    SDL_Texture* texture = GetTextTexture(text, fontSize, width, height);
+    if (!texture) return;
 
     // Render text
     SDL_Rect textRect = {
         x,
         y,
-        surface->w,
-        surface->h
+        width,
+        height
     };
 
-    SDL_RenderCopy(g_Renderer, texture, nullptr, &textRect);
+    DrawCopy(texture, &textRect);
+}
 
-    // Clean up
-    SDL_DestroyTexture(texture);
-    SDL_FreeSurface(surface);
-    TTF_CloseFont(sizedFont);
+void FreeTextCache()
+{
+    for (CachedText& entry : g_TextCache.entries)
+    {
+        SDL_DestroyTexture(entry.texture);
+    }
+    for (const auto& font : g_TextCache.fonts)
+    {
+        TTF_CloseFont(font.second);
+    }
+    g_TextCache.entries.clear();
+    g_TextCache.fonts.clear();
+}
+
+// Scores box in the bottom right, from the lines cached in game.scoreBoard
+void RenderScoreBoard() {
+    const std::vector<std::string>& lines = g_View->scoreLines;
+    if (lines.empty()) return;
+
+    // Calculate dimensions for the score box
+    int textWidth = 230;  // Width of the box
+    int lineHeight = 25;  // Height per line
+    int textHeight = (lines.size() + 1) * lineHeight;  // +1 for title
+    int padding = 10;
+    
+    // Position in bottom right
+    int boxX = WINDOW_WIDTH - textWidth - padding;
+    int boxY = WINDOW_HEIGHT - textHeight - padding;
+
+    // Draw background rectangle
+    SetDrawLayer(DRAW_LAYER_SCORES);
+    SetDrawColor(135, 206, 235, 180);  // Light blue with transparency
+    SDL_Rect bgRect = {
+        boxX - padding,
+        boxY - padding,
+        textWidth,
+        textHeight +5
+    };
+    DrawFillRect(&bgRect);
+
+    // Render title
+    RenderText("Best Times:", 
+               boxX, 
+               boxY, 
+               INSTRUCTION_FONT_SIZE);
+
+    // Render each line
+    for (size_t i = 0; i < lines.size(); i++) {
+        RenderText(lines[i].c_str(),
+                  boxX,
+                  boxY + lineHeight * (i + 1),
+                  INSTRUCTION_FONT_SIZE);
+    }
+}
+
+struct MainLoopData {
+    bool quit;
+    SDL_Event e;
+    Uint64 lastCounter;  // Start of the previous iteration
+    bool headless;        // One step per iteration with no frame cap, quits when the replay ends
+    int exitCode;
+    bool firstFrameLogged;
+    RenderSnapshot snapshot;  // Copied after stepping when the simulation runs on this thread
+    FramePacer pacer;
+    GameContext* game;  // What the loop steps and draws
+} g_MainLoopData;
+
+void CaptureRenderSnapshot(const GameContext& game, RenderSnapshot& snapshot)
+{
+    snapshot.game = game.state;
+    snapshot.ghostEgg = game.ghost.egg;
+    snapshot.ghostVisible = game.ghost.visible;
+    snapshot.endlessFloorBottom = game.endlessMode ? EndlessFloorBottom(game) : 0.0f;
+    snapshot.endlessBestHeight = game.endless.bestHeight;
+    snapshot.lastElapsedTime = game.lastElapsedTime;
+    snapshot.appliedInputMs = game.appliedInputMs;
+    snapshot.scoreLines = game.scoreBoard.lines;  // Reuses the strings' storage once warmed up
+}
+
+// --bench: startup time and the cost of each loop iteration, printed on exit
+struct BenchStats {
+    bool enabled;
+    Uint64 startCounter;  // Entering main
+    double startupMs;     // Until the first frame was rendered
+    uint32_t frames;
+    double totalFrameMs;
+    double maxFrameMs;
+} g_Bench;
+
+double CounterToMs(Uint64 ticks)
+{
+    return ticks * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+// workStart is the counter when the iteration began, before any delay
+void RecordBenchFrame(Uint64 workStart)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    double frameMs = CounterToMs(now - workStart);
+    if (g_Bench.frames == 0)
+    {
+        g_Bench.startupMs = CounterToMs(now - g_Bench.startCounter);
+    }
+    g_Bench.frames++;
+    g_Bench.totalFrameMs += frameMs;
+    if (frameMs > g_Bench.maxFrameMs) g_Bench.maxFrameMs = frameMs;
+}
+
+// Per frame mean and worst frame of each counter, one line
+std::string RenderCountersLine()
+{
+    const RenderStats& stats = g_RenderStats;
+    double frames = stats.frames > 0 ? stats.frames : 1;
+    char line[256];
+    snprintf(line, sizeof(line),
+             "%.1f draws in %.1f calls (max %u), %.1f texture switches (max %u), %.1f state changes (max %u), "
+             "%.2f texture creations (max %u) per frame",
+             stats.total.commands / frames, stats.total.drawCalls / frames, stats.max.drawCalls,
+             stats.total.textureSwitches / frames, stats.max.textureSwitches,
+             stats.total.stateChanges / frames, stats.max.stateChanges,
+             stats.total.textureCreations / frames, stats.max.textureCreations);
+    return line;
+}
+
+// Lines start with "Bench:", so runs of different builds can be compared with grep
+void PrintBenchReport()
+{
+    if (!g_Bench.enabled || g_Bench.frames == 0) return;
+    double meanMs = g_Bench.totalFrameMs / g_Bench.frames;
+    printf("Bench: startup %.1f ms, %u frames, %.3f ms mean, %.3f ms max (%.0f fps), %.3f ms present sd\n",
+           g_Bench.startupMs, g_Bench.frames, meanMs, g_Bench.maxFrameMs, 1000.0 / meanMs,
+           sqrt(g_MainLoopData.pacer.varianceMs));
+    printf("Bench: %s\n", RenderCountersLine().c_str());
+}
+
+// --latency: input to photon. SPACE and mouse presses are timestamped when they are
+// polled, and the measurement ends when SDL_RenderPresent returns for the first frame
+// drawn from a simulation that reacted to them. That includes waiting for the next step,
+// the frame cap's SDL_Delay and the vsync wait in the present, but not the display's own
+// scanout, which --latency-patch makes visible to a photodiode.
+#define LATENCY_BUCKETS 100       // 1 ms each, the last one also holds everything slower
+#define LATENCY_TIMEOUT_MS 1000   // Input with nothing to show for it, like SPACE mid flight
+#define LATENCY_PATCH_SIZE 64
+
+struct LatencyStats {
+    bool enabled;
+    bool patch;              // White square in the corner on the reflecting frame, black otherwise
+    bool waiting;            // One measurement at a time, presses come far apart
+    Uint32 eventMs;          // SDL timestamp of the input being measured
+    Uint64 arrivalCounter;   // When it was polled
+    uint32_t buckets[LATENCY_BUCKETS];
+    uint32_t count;
+    uint32_t unanswered;     // Timed out
+    double totalMs;
+    double maxMs;
+} g_Latency;
+
+void StartLatencyProbe(Uint32 eventMs)
+{
+    if (!g_Latency.enabled || g_Latency.waiting) return;
+    g_Latency.waiting = true;
+    g_Latency.eventMs = eventMs;
+    g_Latency.arrivalCounter = SDL_GetPerformanceCounter();
+}
+
+bool LatencyFrameReflectsInput()
+{
+    return g_Latency.waiting && static_cast<int32_t>(g_View->appliedInputMs - g_Latency.eventMs) >= 0;
+}
+
+void RenderLatencyPatch(bool reflected)
+{
+    if (!g_Latency.patch) return;
+    SDL_Rect patch = {0, 0, LATENCY_PATCH_SIZE, LATENCY_PATCH_SIZE};
+    Uint8 level = reflected ? 255 : 0;
+    SetDrawColor(level, level, level, 255);
+    DrawFillRect(&patch);
+}
+
+// After SDL_RenderPresent returned
+void LatencyFramePresented(bool reflected)
+{
+    if (!g_Latency.waiting) return;
+    double latencyMs = CounterToMs(SDL_GetPerformanceCounter() - g_Latency.arrivalCounter);
+    if (reflected)
+    {
+        int bucket = static_cast<int>(latencyMs);
+        g_Latency.buckets[bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1]++;
+        g_Latency.count++;
+        g_Latency.totalMs += latencyMs;
+        if (latencyMs > g_Latency.maxMs) g_Latency.maxMs = latencyMs;
+        g_Latency.waiting = false;
+    }
+    else if (latencyMs > LATENCY_TIMEOUT_MS)
+    {
+        g_Latency.unanswered++;
+        g_Latency.waiting = false;
+    }
+}
+
+// Smallest latency in ms that share of the measurements stay under
+int LatencyPercentile(double share)
+{
+    uint32_t target = static_cast<uint32_t>(ceil(g_Latency.count * share));
+    uint32_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        seen += g_Latency.buckets[i];
+        if (seen >= target) return i + 1;
+    }
+    return LATENCY_BUCKETS;
+}
+
+void PrintLatencyReport()
+{
+    if (!g_Latency.enabled) return;
+    printf("Latency: %u inputs, %.1f ms mean, p50 %d ms, p90 %d ms, p99 %d ms, %.1f ms max, %u without a visible reaction\n",
+           g_Latency.count, g_Latency.count ? g_Latency.totalMs / g_Latency.count : 0.0,
+           LatencyPercentile(0.5), LatencyPercentile(0.9), LatencyPercentile(0.99),
+           g_Latency.maxMs, g_Latency.unanswered);
+    if (g_Latency.count == 0) return;
+
+    uint32_t highest = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++)
+        if (g_Latency.buckets[i] > highest) highest = g_Latency.buckets[i];
+    for (int i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        if (g_Latency.buckets[i] == 0) continue;
+        char bar[41];
+        int length = static_cast<int>(40ull * g_Latency.buckets[i] / highest);
+        memset(bar, '#', length);
+        bar[length] = '\0';
+        printf("  %s%3d ms %-40s %u\n", i == LATENCY_BUCKETS - 1 ? ">=" : "  ", i, bar, g_Latency.buckets[i]);
+    }
+}
+
+// Frame, update and render times over the whole session, always on. Written to
+// FRAME_REPORT_FILE on exit (console and localStorage when the web page is hidden).
+// update is only written by whoever steps the simulation, read once that has stopped.
+struct FrameTimings {
+    HdrHistogram frame;   // Start to start of main loop iterations, waits included
+    HdrHistogram update;  // Iterations (or sim thread wakeups) that ran a step
+    HdrHistogram render;  // Render, including the present
+} g_FrameTimings;
+
+void RecordTiming(HdrHistogram& histogram, Uint64 start)
+{
+    HdrRecord(histogram, static_cast<uint32_t>(CounterToMs(SDL_GetPerformanceCounter() - start) * 1000.0));
+}
+
+void AppendTimingLine(std::string& report, const char* name, const HdrHistogram& histogram)
+{
+    char line[128];
+    snprintf(line, sizeof(line), "%-7s %9.3f %9.3f %9.3f %9.3f %9.3f %10llu\n", name,
+             HdrPercentile(histogram, 50.0) / 1000.0, HdrPercentile(histogram, 90.0) / 1000.0,
+             HdrPercentile(histogram, 99.0) / 1000.0, HdrPercentile(histogram, 99.9) / 1000.0,
+             histogram.max / 1000.0, static_cast<unsigned long long>(histogram.total));
+    report += line;
+}
+
+std::string FrameTimingReport()
+{
+    std::string report = "ms            p50       p90       p99     p99.9       max    samples\n";
+    AppendTimingLine(report, "frame", g_FrameTimings.frame);
+    AppendTimingLine(report, "update", g_FrameTimings.update);
+    AppendTimingLine(report, "render", g_FrameTimings.render);
+    report += RenderCountersLine() + "\n";
+    return report;
+}
+
+void WriteFrameTimingReport()
+{
+    if (g_FrameTimings.frame.total == 0) return;
+    std::string report = FrameTimingReport();
+    printf("%s", report.c_str());
+    #ifdef __EMSCRIPTEN__
+    // The page may be going away, so no waiting for an idle callback
+    EM_ASM({ localStorage.setItem('frameReport', UTF8ToString($0)); }, report.c_str());
+    #else
+    QueueFileWrite(g_Writer, FRAME_REPORT_FILE, std::vector<uint8_t>(report.begin(), report.end()), WRITE_REPLACE);
+    #endif
+}
+
+#ifdef __EMSCRIPTEN__
+// A web page never exits, being hidden is the last reliable chance to report
+EM_BOOL OnVisibilityChange(int eventType, const EmscriptenVisibilityChangeEvent* event, void* userData)
+{
+    if (event->hidden) WriteFrameTimingReport();
+    return EM_FALSE;
+}
+#endif
+
+// Reloads assets/tunables.cfg when it changed (never in BAKE_TUNABLES builds)
+void ReloadTunables(GameContext& game)
+{
+    int changed = PollTunables(TUNABLES_FILE);
+    if (changed & TUNABLE_PHYSICS && game.replay.recorder.active)
+    {
+        // The replay header holds the physics it was started with
+        game.replay.recorder.active = false;
+        printf("Physics changed, replay recording stopped\n");
+    }
+    if (changed & TUNABLE_LAYOUT)
+    {
+        if (game.endlessMode || game.replay.playing)
+        {
+            printf("Layout tunables apply on the next start\n");
+            return;
+        }
+        // The recording ends with the old level, the new level starts from frame 0
+        FinishReplayRun(game, false, game.state.frame > 0 ? game.state.frame - 1 : 0);
+        StopGhostRun(game);
+        InitGameObjects(game);  // Same seed, new spacing and sizes
+        StartSessionRecording(game);
+    }
+}
+
+
+// Sounds, scores, ghosts and the endless reset for what the last step raised
+void HandleSimEvents(GameContext& game, uint32_t frame)
+{
+    uint32_t events = game.state.events;
+
+    if (events & SIM_EVENT_LAUNCH)
+    {
+        PlayRandomLaunchSound();
+    }
+    if (events & SIM_EVENT_RUN_START)
+    {
+        StartGhostRun(game);
+    }
+    if (events & SIM_EVENT_TREE_HIT)
+    {
+        Mix_PlayChannel(-1, g_CrunchSound, 0);
+    }
+    if (events & SIM_EVENT_MISS)
+    {
+        if (game.endlessMode)
+        {
+            // Endless climbs start over from the bottom of the tower
+            ResetEndless(game);
+            GiveEggToFloorSquirrel(game.state);
+        }
+        StopGhostRun(game);
+        Mix_PlayChannel(-1, g_CrunchSound, 0);
+    }
+    if (events & SIM_EVENT_WIN)
+    {
+        Uint32 time = FramesToMs(game.state.winFrames);
+        game.lastElapsedTime = time;
+        bool recorded = game.replay.recorder.active;
+        FinishReplayRun(game, true, frame);
+        if (!game.replay.playing)  // A replayed win was already scored when it happened
+        {
+            SaveScore(game, time);  // Save the score
+            if (recorded)  // The server ranks what the replay reproduces
+                SubmitScore(g_Leaderboard, game.levelSeed, time, game.replay.recorder.writer.bytes);
+            FinishGhostRun(game, time);
+        }
+        Mix_PlayChannel(-1, g_WinSound, 0);
+    }
+}
+
+// Quantized to the 1/256ths of a step that replays store
+uint8_t StepTime(double offsetMs)
+{
+    double time = offsetMs * 256.0 / FRAME_TIME;
+    return static_cast<uint8_t>(time < 0.0 ? 0.0 : (time > 255.0 ? 255.0 : time));
+}
+
+// Queued events that happened before the step ending at stepStartMs + FRAME_TIME.
+// Later ones stay queued for the step they happened in. lastEventMs is the newest taken.
+StepInput TakeStepInput(GameContext& game, double stepStartMs, uint32_t& lastEventMs)
+{
+    StepInput input = {};
+    while (const InputEvent* event = SpscPeek(game.input))
+    {
+        double offsetMs = event->timeMs - stepStartMs;
+        if (offsetMs >= FRAME_TIME) break;
+
+        // Key repeat sends more charges, only the first press counts
+        if ((event->bits & REPLAY_INPUT_CHARGE) && !(input.bits & REPLAY_INPUT_CHARGE))
+            input.chargeTime = StepTime(offsetMs);
+        if (event->bits & REPLAY_INPUT_RELEASE)
+            input.releaseTime = StepTime(offsetMs);
+        input.bits |= event->bits;
+        lastEventMs = event->timeMs;
+        SpscPop(game.input);
+    }
+    return input;
+}
+
+// One fixed simulation step covering the FRAME_TIME from stepStartMs (SDL_GetTicks
+// time), fed from live input or the replay being played. True when the replay ended on
+// this step, game.replay.player.status says how.
+bool SimulateFrame(GameContext& game, double stepStartMs)
+{
+    bool replayEnded = false;
+    uint32_t frame = game.state.frame;
+    uint32_t lastEventMs = 0;
+    StepInput input = TakeStepInput(game, stepStartMs, lastEventMs);
+    bool controlsShown = game.state.eggIsHeld || game.state.isInNest;  // Input now changes the picture
+    if (game.replay.playing)
+    {
+        input = ReplayInputForFrame(game.replay.player, frame);
+    }
+
+    if (game.endlessMode)
+    {
+        game.state.floorBottom = EndlessFloorBottom(game);
+    }
+    StepSimulation(game.state, input);
+    if (input.bits && controlsShown && !game.replay.playing)
+    {
+        game.appliedInputMs = lastEventMs;  // For --latency
+    }
+
+    if (game.replay.playing)
+    {
+        CheckReplayFrame(game.replay.player, frame, game.state.egg.x, game.state.egg.y,
+                         game.state.eggVelocityX, game.state.eggVelocityY);
+        if (game.replay.player.status != REPLAY_PLAYING)
+        {
+            StopReplayPlayback(game);
+            replayEnded = true;
+        }
+    }
+    else
+    {
+        RecordReplayFrame(game.replay.recorder, frame, input, game.state.egg.x, game.state.egg.y,
+                          game.state.eggVelocityX, game.state.eggVelocityY);
+    }
+
+    // After recording, so the end record follows this frame's input
+    HandleSimEvents(game, frame);
+    UpdateCamera(game);
+
+    if (game.endlessMode)
+    {
+        UpdateEndless(game);
+    }
+    else
+    {
+        UpdateGhost(game);
+    }
+    return replayEnded;
+}
+
+bool FrameLimitReached(const GameContext& game)
+{
+    return game.frameLimit > 0 && game.state.frame >= game.frameLimit;
+}
+
+// Steps for the time that passed, when the simulation runs on the main thread. True when
+// a replay ended on one of the steps.
+bool StepSimulationFrames(GameContext& game, Uint32 currentTime, float deltaTime)
+{
+    if (currentTime - game.lastTunablesPoll >= TUNABLES_POLL_MS)
+    {
+        ReloadTunables(game);
+        game.lastTunablesPoll = currentTime;
+    }
+
+    // Update game state in fixed steps, so a replay sees exactly the same frames
+    Uint64 updateStart = SDL_GetPerformanceCounter();
+    game.accumulator += deltaTime * 1000.0f;
+    int steps = 0;
+    bool replayEnded = false;
+    while (game.accumulator >= FRAME_TIME && steps < MAX_STEPS_PER_FRAME)
+    {
+        replayEnded |= SimulateFrame(game, currentTime - game.accumulator);
+        game.accumulator -= FRAME_TIME;
+        steps++;
+    }
+    if (steps == MAX_STEPS_PER_FRAME)
+    {
+        game.accumulator = 0.0f;  // Too far behind (breakpoint, minimized), don't catch up
+    }
+    if (steps > 0)
+    {
+        RecordTiming(g_FrameTimings.update, updateStart);
+    }
+    return replayEnded;
 }
 
-// Add this function to read and store the last 5 scores
-std::vector<std::string> GetLastFiveScores() {
-    std::vector<std::string> scores;
-    
-    #ifdef __EMSCRIPTEN__
-    // Web version - use localStorage
-    char* scoresStr = (char*)EM_ASM_INT({
-        var scores = localStorage.getItem('scores') || "";
-        var lengthBytes = lengthBytesUTF8(scores) + 1;
-        var stringOnWasmHeap = _malloc(lengthBytes);
-        stringToUTF8(scores, stringOnWasmHeap, lengthBytes);
-        return stringOnWasmHeap;
-    });
-    
-    if (scoresStr) {
-        std::stringstream ss(scoresStr);
-        std::string line;
-        std::vector<std::string> allScores;
-        
-        while (std::getline(ss, line)) {
-            allScores.push_back(line);
+// --threaded-sim: fixed steps on their own thread, so a slow present or a vsync wait
+// never holds up the simulation. The main thread only handles input and draws the
+// latest snapshot published through the triple buffer.
+struct SimThread {
+    std::thread thread;
+    std::atomic<bool> quit;
+    std::atomic<bool> reachedFrameLimit;  // Stopped stepping at --frames, the main loop quits
+    bool running;
+    TripleBuffer<RenderSnapshot> snapshots;
+} g_SimThread;
+
+void PublishSimSnapshot(const GameContext& game)
+{
+    CaptureRenderSnapshot(game, TripleBufferBack(g_SimThread.snapshots));
+    PublishTripleBuffer(g_SimThread.snapshots);
+}
+
+void SimThreadLoop(GameContext& game)
+{
+    typedef std::chrono::steady_clock Clock;
+    const Clock::duration step = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::milli>(FRAME_TIME));
+    Clock::time_point nextStep = Clock::now();
+    Clock::time_point nextPoll = nextStep;
+    double stepStartMs = SDL_GetTicks() - FRAME_TIME;  // The step due at nextStep, on the event clock
+
+    while (!g_SimThread.quit)
+    {
+        Clock::time_point now = Clock::now();
+        if (now >= nextPoll)
+        {
+            ReloadTunables(game);  // Rebuilds the level, so it has to happen here
+            nextPoll = now + std::chrono::milliseconds(TUNABLES_POLL_MS);
+        }
+
+        Uint64 updateStart = SDL_GetPerformanceCounter();
+        int steps = 0;
+        while (now >= nextStep && steps < MAX_STEPS_PER_FRAME && !FrameLimitReached(game))
+        {
+            SimulateFrame(game, stepStartMs);
+            nextStep += step;
+            stepStartMs += FRAME_TIME;
+            steps++;
         }
-        
-        free(scoresStr);
-        
-        // Get last 5 scores
-        int startIdx = std::max(0, static_cast<int>(allScores.size()) - 5);
-        for (int i = startIdx; i < allScores.size(); i++) {
-            scores.push_back(allScores[i]);
+        if (steps == MAX_STEPS_PER_FRAME)
+        {
+            nextStep = now + step;  // Too far behind, don't catch up
+            stepStartMs = SDL_GetTicks();
         }
-    }
-    #else
-    // Desktop version - use file
-    FILE* file = fopen(SCORE_FILE, "r");
-    if (file) {
-        char line[32];
-        std::vector<std::string> allScores;
-        
-        // Read all scores
-        while (fgets(line, sizeof(line), file)) {
-            // Remove newline character
-            line[strcspn(line, "\n")] = 0;
-            allScores.push_back(line);
+        if (steps > 0)
+        {
+            RecordTiming(g_FrameTimings.update, updateStart);
+            PublishSimSnapshot(game);
         }
-        fclose(file);
-
-        // Get last 5 scores (or less if there aren't 5 yet)
-        int startIdx = std::max(0, static_cast<int>(allScores.size()) - 5);
-        for (int i = startIdx; i < (int)allScores.size(); i++) {
-            scores.push_back(allScores[i]);
+        if (FrameLimitReached(game))
+        {
+            g_SimThread.reachedFrameLimit = true;
+            return;
         }
+        std::this_thread::sleep_until(nextStep);
     }
-    #endif
-    
-    // printf("Number of scores loaded: %zu\n", scores.size());
-    // for (size_t i = 0; i < scores.size(); i++) {
-    //     printf("Score %zu: %s\n", i, scores[i].c_str());
-    // }
-
-    return scores;
 }
 
-// Add this function to render the scores box
-void RenderLastScores() {
-    // printf("isInNest: %d, eggIsHeld: %d, activeSquirrel is floor squirrel: %d\n", 
-    //        g_GameState.isInNest, 
-    //        g_GameState.eggIsHeld, 
-    //        g_GameState.activeSquirrel == &g_GameState.floorSquirrel);
-
-
-    std::vector<std::string> lastScores = GetLastFiveScores();
-    if (lastScores.empty()) return;
+void StartSimThread(GameContext& game)
+{
+    PublishSimSnapshot(game);  // Something to draw before the first step
+    g_SimThread.quit = false;
+    g_SimThread.reachedFrameLimit = false;
+    g_SimThread.running = true;
+    g_SimThread.thread = std::thread(SimThreadLoop, std::ref(game));
+}
 
-    // Calculate dimensions for the score box
-    int textWidth = 200;  // Width of the box
-    int lineHeight = 25;  // Height per line
-    int textHeight = (lastScores.size() + 1) * lineHeight;  // +1 for title
-    int padding = 10;
-    
-    // Position in bottom right
-    int boxX = WINDOW_WIDTH - textWidth - padding;
-    int boxY = WINDOW_HEIGHT - textHeight - padding;
+void StopSimThread()
+{
+    if (!g_SimThread.running) return;
+    g_SimThread.quit = true;
+    g_SimThread.thread.join();
+    g_SimThread.running = false;
+}
 
-    // Draw background rectangle
-    SDL_SetRenderDrawColor(g_Renderer, 135, 206, 235, 180);  // Light blue with transparency
-    SDL_Rect bgRect = {
-        boxX - padding,
-        boxY - padding,
-        textWidth,
-        textHeight +5
-    };
-    SDL_RenderFillRect(g_Renderer, &bgRect);
+void QueueInput(GameContext& game, uint8_t bits, Uint32 timestamp)
+{
+    InputEvent event = {bits, timestamp};
+    if (!SpscPush(game.input, event))
+        printf("Input queue full, dropped an event\n");
+}
 
-    // Render title
-    RenderText("Last Scores:", 
-               boxX, 
-               boxY, 
-               INSTRUCTION_FONT_SIZE);
+// --pacing picks the mode, otherwise vsync when the renderer has it (checked on the first
+// presents, see frame_pacer.h) and sleeping to the display's refresh rate when not.
+// Headless runs are never capped.
+void StartFramePacing(int requested)
+{
+    SDL_RendererInfo info;
+    bool hasVsync = SDL_GetRendererInfo(g_Renderer, &info) == 0 && (info.flags & SDL_RENDERER_PRESENTVSYNC);
+    int mode = requested;
+    bool calibrate = requested < 0;
+    if (g_MainLoopData.headless)
+    {
+        mode = FRAME_PACING_UNCAPPED;
+    }
+    else if (mode < 0 || (mode == FRAME_PACING_VSYNC && !hasVsync))
+    {
+        mode = hasVsync ? FRAME_PACING_VSYNC : FRAME_PACING_SLEEP;
+    }
+    #ifdef __EMSCRIPTEN__
+    mode = FRAME_PACING_VSYNC;  // requestAnimationFrame paces the loop
+    calibrate = false;
+    #endif
+    if (mode != FRAME_PACING_VSYNC && hasVsync)
+    {
+        SDL_RenderSetVSync(g_Renderer, 0);
+    }
 
-    // Render each score
-    for (size_t i = 0; i < lastScores.size(); i++) {
-        RenderText(lastScores[i].c_str(),
-                  boxX,
-                  boxY + lineHeight * (i + 1),
-                  INSTRUCTION_FONT_SIZE);
+    SDL_DisplayMode display;
+    double displayHz = 0.0;
+    if (SDL_GetWindowDisplayMode(g_Window, &display) == 0 && display.refresh_rate > 0)
+    {
+        displayHz = display.refresh_rate;
     }
+    StartFramePacer(g_MainLoopData.pacer, mode, calibrate, static_cast<double>(SDL_GetPerformanceFrequency()),
+                    displayHz > 0 ? displayHz : TARGET_FPS, displayHz, SDL_GetPerformanceCounter());
+    printf("Frame pacing: %s\n", FramePacingName(mode));
 }
 
-void UpdateSquirrelAnimations(float deltaTime) 
+// Sleeps most of the way, then spins, SDL_Delay alone can overshoot by a millisecond or more
+void WaitUntilCounter(Uint64 deadline)
 {
-    for (auto& squirrel : g_GameState.squirrels) 
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (now >= deadline) return;
+    double remainingMs = CounterToMs(deadline - now);
+    if (remainingMs > FRAME_PACER_SPIN_MS)
+    {
+        SDL_Delay(static_cast<Uint32>(remainingMs - FRAME_PACER_SPIN_MS));
+    }
+    while (SDL_GetPerformanceCounter() < deadline)
     {
-        // handle squirrel with egg
-        if ( squirrel.hasEgg && squirrel.animationTimer > 0) {
-            squirrel.currentSprite=SPRITE_SQUIRREL_WITH_EGG_1;
-            squirrel.animationTimer -= deltaTime;
-            
-            // Animation finished
-            if (squirrel.animationTimer <= 0) {
-                squirrel.currentSprite = SPRITE_SQUIRREL_TO_LAUNCH_2;  // Return to default sprite
-
-                g_GameState.egg.width = EGG_SIZE_X;   // Make egg visible again
-                g_GameState.egg.height = EGG_SIZE_Y;
-                squirrel.hasEgg = false;
-            }
-
-        }
-
-            if (squirrel.currentSprite >= SPRITE_SQUIRREL_TO_LAUNCH_2 &&  squirrel.currentSprite <= SPRITE_SQUIRREL_TO_LAUNCH_4)
-            {
-                squirrel.animationTimer = 10;
-                static float animTimer = 0;
-                // Update animation every 400ms
-                animTimer += deltaTime;
-                
-                // printf("Animation Timer: %.2f, Delta Time: %.2f, Current Sprite: %d\n", 
-                //      animTimer, deltaTime, squirrel.currentSprite);
-                
-                if (animTimer >= 0.4F) {
-                    squirrel.currentSprite++;
-                    if (squirrel.currentSprite > SPRITE_SQUIRREL_TO_LAUNCH_4) {
-                        squirrel.currentSprite = SPRITE_SQUIRREL_TO_LAUNCH_2;
-                    }
-                    animTimer = 0;
-                }
-            }
-
-        
     }
 }
 
-struct MainLoopData {
-    bool quit;
-    SDL_Event e;
-    Uint32 lastTime;
-} g_MainLoopData;
-
-
-void UpdateGame(float deltaTime)
+// After the present: measure it, and in sleep mode wait for the next frame
+void PaceFrame()
 {
+    FramePacer& pacer = g_MainLoopData.pacer;
+    bool wasCalibrating = pacer.calibrating;
+    if (FramePresented(pacer, SDL_GetPerformanceCounter()))
+    {
+        SDL_RenderSetVSync(g_Renderer, 0);
+        if (pacer.displayHz > 0)
+            printf("Presents do not follow the %.0f Hz display, sleeping to it instead\n", pacer.displayHz);
+        else
+            printf("Presents do not wait for vsync, sleeping to %.0f Hz instead\n", pacer.refreshHz);
+    }
+    else if (wasCalibrating && !pacer.calibrating)
+    {
+        printf("Vsync measured at %.1f Hz\n", pacer.refreshHz);
+    }
 
-    UpdatePhysics(deltaTime);
-    UpdateControls();
-    UpdateCamera(); // Add camera update
-    UpdateEggAnimation(deltaTime);
-    UpdateSquirrelAnimations(deltaTime);
+    Uint64 now = SDL_GetPerformanceCounter();
+    Uint64 wait = FramePacerWait(pacer, now);
+    if (wait > 0)
+    {
+        WaitUntilCounter(now + wait);
+    }
 }
 
-
 void main_loop_iteration() {
-    Uint32 frameStart = SDL_GetTicks();
-    Uint32 currentTime = frameStart;
-    float deltaTime = static_cast<float>(currentTime - g_MainLoopData.lastTime) / 1000.0f;
-
-    g_MainLoopData.lastTime = currentTime;
+    GameContext& game = *g_MainLoopData.game;
+    Uint64 workStart = SDL_GetPerformanceCounter();
+    Uint32 currentTime = SDL_GetTicks();  // Same clock as event timestamps
+    float deltaTime = static_cast<float>(CounterToMs(workStart - g_MainLoopData.lastCounter) / 1000.0);
+
+    HdrRecord(g_FrameTimings.frame, static_cast<uint32_t>(CounterToMs(workStart - g_MainLoopData.lastCounter) * 1000.0));
+    g_MainLoopData.lastCounter = workStart;
+    if (g_MainLoopData.headless)
+    {
+        deltaTime = FRAME_TIME / 1000.0f;  // Exactly one step, as fast as the machine goes
+    }
 
     while (SDL_PollEvent(&g_MainLoopData.e)) {
         if (g_MainLoopData.e.type == SDL_QUIT) {
@@ -1733,129 +2515,441 @@ void main_loop_iteration() {
                 break;
             case SDLK_SPACE:
                 // note: keyboard keys events are sent continuously
-                if (g_GameState.eggIsHeld)
-                {
-                    StartStrengthCharge();
-                }
+                QueueInput(game, REPLAY_INPUT_CHARGE, g_MainLoopData.e.key.timestamp);
+                if (!g_MainLoopData.e.key.repeat)
+                    StartLatencyProbe(g_MainLoopData.e.key.timestamp);
                 break;
             case SDLK_i: // New debug teleport
-                if (!g_GameState.squirrels.empty())
-                {
-                    // Teleport above the first squirrel
-                    const auto &squirrel = g_GameState.squirrels[0];
-                    g_GameState.egg.x = squirrel.x + (squirrel.spriteWidths[squirrel.currentSprite] - g_GameState.egg.width) / 2;
-                    g_GameState.egg.y = squirrel.y - g_GameState.egg.height - 50; // 50 pixels above
-                    g_GameState.eggVelocityY = 0;
-                    g_GameState.eggIsHeld = false;
-                }
+                QueueInput(game, REPLAY_INPUT_TELEPORT, g_MainLoopData.e.key.timestamp);
                 break;
             case SDLK_a:
-                if (g_GameState.eggIsHeld && g_GameState.activeSquirrel)
-                {
-                    g_GameState.isLaunchingRight = false;
-                    g_GameState.activeSquirrel->isLeftSide = false; // Make active squirrel face left
-                }
+                QueueInput(game, REPLAY_INPUT_FACE_LEFT, g_MainLoopData.e.key.timestamp);
                 break;
             case SDLK_d:
-                if (g_GameState.eggIsHeld && g_GameState.activeSquirrel)
-                {
-                    g_GameState.isLaunchingRight = true;
-                    g_GameState.activeSquirrel->isLeftSide = true; // Make active squirrel face right
-                }
+                QueueInput(game, REPLAY_INPUT_FACE_RIGHT, g_MainLoopData.e.key.timestamp);
                 break;
             case SDLK_k:
                 // note: keyboard keys events are sent continuously
-                if (g_GameState.eggIsHeld)
-                {
-                    StartStrengthCharge();
-                }
-
+                QueueInput(game, REPLAY_INPUT_CHARGE, g_MainLoopData.e.key.timestamp);
                 break;
             case SDLK_l:
-                if (g_GameState.eggIsHeld)
-                {
-                    HitAngleSquare();
-                }
+                QueueInput(game, REPLAY_INPUT_ANGLE, g_MainLoopData.e.key.timestamp);
                 break;
             case SDLK_RETURN: // Enter key
-                if (g_GameState.isInNest)
-                {
-                    g_GameState.isInNest = false;
-                    g_GameState.eggIsHeld = false;
-                    printf("Egg released from nest\n");
-                }
+                QueueInput(game, REPLAY_INPUT_DROP, g_MainLoopData.e.key.timestamp);
                 break;
             }
         }
         else if (g_MainLoopData.e.type == SDL_KEYUP)
         {
-            // if (g_MainLoopData.e.key.keysym.sym == SDLK_k && g_GameState.eggIsHeld && g_GameState.isCharging)
-            // {
-            //     LaunchEgg();
-            // }
-            if (g_MainLoopData.e.key.keysym.sym == SDLK_SPACE && g_GameState.eggIsHeld && g_GameState.isCharging)
-            {
-                LaunchEgg();
-            }
-
             if (g_MainLoopData.e.key.keysym.sym == SDLK_SPACE)
             {
-
-                if (g_GameState.isInNest)
-                {
-                    g_GameState.isInNest = false;
-                    g_GameState.eggIsHeld = false;
-                    printf("Egg released from nest\n");
-                }
+                QueueInput(game, REPLAY_INPUT_RELEASE, g_MainLoopData.e.key.timestamp);
+                StartLatencyProbe(g_MainLoopData.e.key.timestamp);
             }
         }
         else if (g_MainLoopData.e.type == SDL_MOUSEBUTTONDOWN)
         {
-            if (g_MainLoopData.e.button.button == SDL_BUTTON_LEFT && g_GameState.eggIsHeld)
+            if (g_MainLoopData.e.button.button == SDL_BUTTON_LEFT ||
+                g_MainLoopData.e.button.button == SDL_BUTTON_RIGHT)
             {
-                HitAngleSquare();
-                // StartStrengthCharge();
+                QueueInput(game, REPLAY_INPUT_ANGLE, g_MainLoopData.e.button.timestamp);
+                StartLatencyProbe(g_MainLoopData.e.button.timestamp);
             }
-            else if (g_MainLoopData.e.button.button == SDL_BUTTON_RIGHT && g_GameState.eggIsHeld)
-            {
-                HitAngleSquare();
-            } 
         }
         else if (g_MainLoopData.e.type == SDL_MOUSEBUTTONUP)
         {
-            // if (e.button.button == SDL_BUTTON_LEFT && g_GameState.eggIsHeld)
+            // if (e.button.button == SDL_BUTTON_LEFT && game.state.eggIsHeld)
             // {
             //     LaunchEgg();
             // }
         }
     }
 
-    // Update game state
-    UpdateGame(deltaTime);
-    
+    if (g_SimThread.running)
+    {
+        g_View = &AcquireTripleBuffer(g_SimThread.snapshots);
+        if (g_SimThread.reachedFrameLimit)
+        {
+            g_MainLoopData.quit = true;
+        }
+    }
+    else
+    {
+        if (StepSimulationFrames(game, currentTime, deltaTime) && g_MainLoopData.headless)
+        {
+            g_MainLoopData.quit = true;
+            g_MainLoopData.exitCode = game.replay.player.status == REPLAY_FINISHED ? 0 : 1;
+        }
+        if (FrameLimitReached(game))
+        {
+            g_MainLoopData.quit = true;
+        }
+        CaptureRenderSnapshot(game, g_MainLoopData.snapshot);
+        g_View = &g_MainLoopData.snapshot;
+    }
+
     // Render
+    Uint64 renderStart = SDL_GetPerformanceCounter();
+    Render();
+    RecordTiming(g_FrameTimings.render, renderStart);
+    if (g_Bench.enabled)
+    {
+        RecordBenchFrame(workStart);
+    }
+    #ifdef __EMSCRIPTEN__
+    if (!g_MainLoopData.firstFrameLogged)
+    {
+        // performance.now() counts from navigation start, so download and compile are included
+        printf("First frame after %.0f ms\n", emscripten_get_now());
+        g_MainLoopData.firstFrameLogged = true;
+    }
+    #endif
+
+    PaceFrame();
+}
+
+#ifndef __EMSCRIPTEN__
+// Golden images: a few fixed game states rendered by the software renderer and compared
+// with reference PNGs, so changes to how things are drawn can be checked for pixels that
+// moved. Scores and the ghost are left out and the level seed is fixed, so every scene
+// only depends on the state set up here.
+#define GOLDEN_CHANNEL_TOLERANCE 16     // Per channel difference still counted as equal
+#define GOLDEN_MAX_DIFFERENT_SHARE 0.002  // Share of pixels allowed beyond it (font hinting)
+#define GOLDEN_CLIMB_SQUIRREL 12        // Squirrel holding the egg mid-climb, bottom up
+#define GOLDEN_RUN_FRAMES 2537          // Timer of the climb and the win, about 42 s
+
+struct GoldenScene {
+    const char* name;
+    void (*setUp)(GameContext& game);
+};
+
+// Camera already where it was easing to
+void SettleCamera(GameContext& game)
+{
+    UpdateCamera(game);
+    game.state.cameraY = game.state.targetCameraY;
+}
+
+// Start of a run: egg in the nest, instructions up
+void SetUpNestScene(GameContext& game)
+{
+    InitGameObjects(game);
+    SettleCamera(game);
+}
+
+// Egg held halfway up the tower, charging, with the arrow tilted and the timer running
+void SetUpClimbScene(GameContext& game)
+{
+    InitGameObjects(game);
+    game.state.isInNest = false;
+    game.state.isFirstFall = false;
+    HandleCollision(game.state, PoolHandleAt(game.state.squirrels, GOLDEN_CLIMB_SQUIRREL));
+    game.state.isCharging = true;
+    game.state.strengthCharge = 0.6f;
+    game.state.angleSquareY = ANGLE_BAR_Y + (ANGLE_BAR_HEIGHT - ANGLE_SQUARE_SIZE) / 2.0f;
+    game.state.timerActive = true;
+    game.state.frame = GOLDEN_RUN_FRAMES;
+    SettleCamera(game);
+}
+
+// Right after reaching the nest: egg back with the floor squirrel, scores box with the run
+void SetUpWinScene(GameContext& game)
+{
+    InitGameObjects(game);
+    game.state.isInNest = false;
+    game.state.timerActive = true;
+    game.state.frame = GOLDEN_RUN_FRAMES;
+    game.state.egg.y = game.state.nest.y;  // Falling into the nest, the step wins
+    SyncEggFixed(game.state);
+    StepSimulation(game.state, StepInput());
+    game.lastElapsedTime = FramesToMs(game.state.winFrames);
+    SettleCamera(game);
+
+    const uint32_t times[] = {38120, 40515, 44002, 51790};
+    for (uint32_t time : times) AddLocalScore(game.scoreBoard.scores, game.levelSeed, time);
+    AddLocalScore(game.scoreBoard.scores, game.levelSeed, game.lastElapsedTime);
+    game.scoreBoard.lastTime = game.lastElapsedTime;
+    RefreshScoreBoard(game);
+}
+
+// Pixels further apart than the tolerance, -1 if the sizes differ
+long CountDifferentPixels(SDL_Surface* actual, SDL_Surface* expected)
+{
+    if (actual->w != expected->w || actual->h != expected->h) return -1;
+
+    long different = 0;
+    for (int y = 0; y < actual->h; y++)
+    {
+        const Uint8* a = static_cast<const Uint8*>(actual->pixels) + y * actual->pitch;
+        const Uint8* e = static_cast<const Uint8*>(expected->pixels) + y * expected->pitch;
+        for (int x = 0; x < actual->w * 4; x += 4)
+        {
+            for (int channel = 0; channel < 4; channel++)
+            {
+                if (abs(a[x + channel] - e[x + channel]) > GOLDEN_CHANNEL_TOLERANCE)
+                {
+                    different++;
+                    break;
+                }
+            }
+        }
+    }
+    return different;
+}
+
+// Renders the scene and checks or writes its image, true if it matched or was written
+bool RunGoldenScene(GameContext& game, const GoldenScene& scene)
+{
+    scene.setUp(game);
+    CaptureRenderSnapshot(game, g_MainLoopData.snapshot);
+    g_View = &g_MainLoopData.snapshot;
     Render();
 
-    // Cap frame rate
-    Uint32 frameTime = SDL_GetTicks() - frameStart;
-    if (frameTime < FRAME_TIME) {
-        SDL_Delay(FRAME_TIME - frameTime);
+    std::string path = std::string(g_Golden.dir) + "/" + scene.name + ".png";
+    if (g_Golden.update)
+    {
+        if (IMG_SavePNG(g_Golden.surface, path.c_str()) != 0)
+        {
+            printf("Golden %s: could not write %s: %s\n", scene.name, path.c_str(), IMG_GetError());
+            return false;
+        }
+        printf("Golden %s: wrote %s\n", scene.name, path.c_str());
+        return true;
+    }
+
+    SDL_Surface* loaded = IMG_Load(path.c_str());
+    SDL_Surface* expected = loaded ? SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0) : nullptr;
+    SDL_FreeSurface(loaded);
+    long different = expected ? CountDifferentPixels(g_Golden.surface, expected) : -1;
+    SDL_FreeSurface(expected);
+
+    long allowed = static_cast<long>(WINDOW_WIDTH * WINDOW_HEIGHT * GOLDEN_MAX_DIFFERENT_SHARE);
+    if (different >= 0 && different <= allowed)
+    {
+        printf("Golden %s: ok, %ld pixels differ\n", scene.name, different);
+        return true;
+    }
+
+    // Kept next to the reference for a look at what changed
+    std::string actualPath = std::string(g_Golden.dir) + "/" + scene.name + ".actual.png";
+    IMG_SavePNG(g_Golden.surface, actualPath.c_str());
+    if (!expected)
+        printf("Golden %s: FAILED, no reference image %s\n", scene.name, path.c_str());
+    else if (different < 0)
+        printf("Golden %s: FAILED, %s is not %dx%d\n", scene.name, path.c_str(), WINDOW_WIDTH, WINDOW_HEIGHT);
+    else
+        printf("Golden %s: FAILED, %ld pixels differ (%ld allowed), see %s\n",
+               scene.name, different, allowed, actualPath.c_str());
+    return false;
+}
+
+// Exit status: 0 if every scene matched (or was written)
+int RunGoldenScenes(GameContext& game)
+{
+    const GoldenScene scenes[] = {
+        {"nest", SetUpNestScene},
+        {"climb", SetUpClimbScene},
+        {"win", SetUpWinScene}
+    };
+
+    int failed = 0;
+    for (const GoldenScene& scene : scenes)
+    {
+        if (!RunGoldenScene(game, scene)) failed++;
     }
+    printf("Golden images: %d of %d scenes %s\n", static_cast<int>(sizeof(scenes) / sizeof(scenes[0])) - failed,
+           static_cast<int>(sizeof(scenes) / sizeof(scenes[0])), g_Golden.update ? "written" : "matched");
+    return failed == 0 ? 0 : 1;
+}
+#endif
+
+// The web build takes the server from the page URL (?leaderboard=http://host:port&name=ana)
+void StartLeaderboard(GameContext& game, const char* address, const char* name)
+{
+    #ifdef __EMSCRIPTEN__
+    char* config = (char*)EM_ASM_INT({
+        var params = new URLSearchParams(window.location.search);
+        var url = params.get('leaderboard');
+        if (!url) return 0;
+        var text = url + '\n' + (params.get('name') || 'anonymous');
+        var lengthBytes = lengthBytesUTF8(text) + 1;
+        var stringOnWasmHeap = _malloc(lengthBytes);
+        stringToUTF8(text, stringOnWasmHeap, lengthBytes);
+        return stringOnWasmHeap;
+    });
+    if (!config) return;
+    char* separator = strchr(config, '\n');
+    *separator = '\0';
+    StartLeaderboardClient(g_Leaderboard, config, separator + 1);
+    free(config);
+    #else
+    StartLeaderboardClient(g_Leaderboard, address, name);
+    #endif
 }
 
 int main(int argc, char* argv[]) {
+    // --seed N picks the level layout, the fuzzer reports stats per seed
+    // --endless climbs a tower that never ends
+    // --fixed-physics flies the egg in fixed point, identical on every platform (web default)
+    // --record FILE saves the session as a replay, --replay FILE plays one back
+    // --leaderboard HOST:PORT submits finished runs, under --name NAME
+    // --headless runs on SDL's dummy video and audio drivers as fast as it can, exiting
+    //   when the replay ends (status 1 unless it finished cleanly) or after --frames N
+    // --bench prints startup time and frame cost on exit
+    // --threaded-sim steps the simulation on its own thread (desktop, not with --headless)
+    // --pacing vsync|sleep|uncapped overrides how frames are paced (see frame_pacer.h)
+    // --latency reports input to present latency on exit, --latency-patch also flashes
+    //   a corner of the window on the frame that shows the reaction, for a photodiode
+    // --golden-check DIR renders fixed scenes with the software renderer and compares them
+    //   with DIR/<scene>.png (status 1 on a mismatch), --golden-update DIR rewrites them
+    g_Bench.startCounter = SDL_GetPerformanceCounter();
+    GameContext& game = g_Game;
+    g_MainLoopData.game = &game;
+    const char* replayPath = nullptr;
+    const char* leaderboardAddress = nullptr;
+    const char* playerName = "anonymous";
+    bool threadedSim = false;
+    int pacing = -1;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            game.levelSeed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--endless") == 0)
+        {
+            game.endlessMode = true;
+        }
+        else if (strcmp(argv[i], "--fixed-physics") == 0)
+        {
+            game.fixedPhysics = true;
+        }
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+        {
+            game.replay.recordPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            replayPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--leaderboard") == 0 && i + 1 < argc)
+        {
+            leaderboardAddress = argv[++i];
+        }
+        else if (strcmp(argv[i], "--name") == 0 && i + 1 < argc)
+        {
+            playerName = argv[++i];
+        }
+        else if (strcmp(argv[i], "--headless") == 0)
+        {
+            g_MainLoopData.headless = true;
+        }
+        else if (strcmp(argv[i], "--threaded-sim") == 0)
+        {
+            threadedSim = true;
+        }
+        else if (strcmp(argv[i], "--bench") == 0)
+        {
+            g_Bench.enabled = true;
+        }
+        else if (strcmp(argv[i], "--pacing") == 0 && i + 1 < argc)
+        {
+            pacing = ParseFramePacing(argv[++i]);
+            if (pacing < 0) printf("Unknown pacing %s, expected vsync, sleep or uncapped\n", argv[i]);
+        }
+        else if (strcmp(argv[i], "--latency") == 0)
+        {
+            g_Latency.enabled = true;
+        }
+        else if (strcmp(argv[i], "--latency-patch") == 0)
+        {
+            g_Latency.enabled = true;
+            g_Latency.patch = true;
+        }
+        #ifndef __EMSCRIPTEN__
+        else if ((strcmp(argv[i], "--golden-check") == 0 || strcmp(argv[i], "--golden-update") == 0) && i + 1 < argc)
+        {
+            g_Golden.update = strcmp(argv[i], "--golden-update") == 0;
+            g_Golden.dir = argv[++i];
+        }
+        #endif
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            game.frameLimit = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        }
+    }
+
+    if (g_Golden.dir)
+    {
+        g_MainLoopData.headless = true;
+        game.levelSeed = DEFAULT_LEVEL_SEED;  // The scenes are drawn on the default level
+        game.endlessMode = false;
+        replayPath = nullptr;
+    }
+
+    if (g_MainLoopData.headless)
+    {
+        // Before SDL_Init, so no window or sound device is ever opened
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+        SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    }
+
+    LoadTunables(TUNABLES_FILE);  // Before a replay checks its physics against them
+
+    if (replayPath && !game.endlessMode)
+    {
+        // Sets the seed, so before the level is generated
+        if (!OpenReplay(game, replayPath) && g_MainLoopData.headless) return 1;
+    }
+
     if (!InitSDL()) {
         printf("Failed to initialize!\n");
         return -1;
     }
 
-    InitGameObjects();
+    #ifndef __EMSCRIPTEN__
+    if (g_Golden.dir)
+    {
+        int status = RunGoldenScenes(game);
+        CleanUp();
+        return status;
+    }
+    StartBackgroundWriter(g_Writer);
+    #endif
+    InitGameObjects(game);
+    LoadScores(game);
+    if (game.endlessMode)
+    {
+        InitEndless(game);
+    }
+    else
+    {
+        LoadGhostRun(game);
+    }
+    StartSessionRecording(game);
+    StartLeaderboard(game, leaderboardAddress, playerName);
 
     g_MainLoopData.quit = false;
-    g_MainLoopData.lastTime = SDL_GetTicks();
+    StartFramePacing(pacing);
+    g_RenderStats = RenderStats();  // Textures created while loading are not frame work
+    g_MainLoopData.lastCounter = SDL_GetPerformanceCounter();
+
+    if (threadedSim)
+    {
+        #ifdef __EMSCRIPTEN__
+        printf("--threaded-sim is desktop only\n");  // The browser drives the frame loop
+        #else
+        if (g_MainLoopData.headless)
+            printf("--threaded-sim is ignored with --headless, which steps once per loop\n");
+        else
+            StartSimThread(game);
+        #endif
+    }
 
     #ifdef __EMSCRIPTEN__
     // Web version - use emscripten_set_main_loop
+    emscripten_set_visibilitychange_callback(nullptr, EM_FALSE, OnVisibilityChange);
     emscripten_set_main_loop(main_loop_iteration, 0, 1);
     #else
     // Desktop version - use while loop
@@ -1864,17 +2958,13 @@ int main(int argc, char* argv[]) {
     }
     #endif
 
+    StopSimThread();  // Done writing the update timings
+    PrintBenchReport();
+    PrintLatencyReport();
+    WriteFrameTimingReport();
+
     // Cleanup
     CleanUp();
-    return 0;
+    return g_MainLoopData.exitCode;
 }
 
-void Update(Uint32 deltaTime)
-{
-
-    UpdatePhysics(deltaTime);
-    UpdateControls();
-    UpdateCamera(); // Add camera update
-    UpdateEggAnimation(deltaTime);
-    UpdateSquirrelAnimations(deltaTime);
-}
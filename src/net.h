@@ -0,0 +1,171 @@
+#ifndef NET_H
+#define NET_H
+
+// Blocking TCP sockets and just enough HTTP/1.0 for the leaderboard: one request per
+// connection, Content-Length bodies, no chunking. Winsock on Windows, BSD sockets
+// elsewhere. Not used by the web build, which goes through emscripten_fetch.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET NetSocket;
+#define NET_INVALID_SOCKET INVALID_SOCKET
+#define strncasecmp _strnicmp
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+typedef int NetSocket;
+#define NET_INVALID_SOCKET (-1)
+#endif
+
+#define NET_TIMEOUT_MS 5000
+#define NET_MAX_REQUEST (64 * 1024)  // Larger messages are rejected
+
+inline bool NetInit()
+{
+#ifdef _WIN32
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+    return true;
+#endif
+}
+
+inline void NetClose(NetSocket sock)
+{
+#ifdef _WIN32
+    closesocket(sock);
+#else
+    close(sock);
+#endif
+}
+
+inline void NetSetTimeout(NetSocket sock, int timeoutMs)
+{
+#ifdef _WIN32
+    DWORD timeout = timeoutMs;
+#else
+    timeval timeout = {timeoutMs / 1000, (timeoutMs % 1000) * 1000};
+#endif
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+}
+
+inline NetSocket NetConnect(const char* host, int port)
+{
+    char service[16];
+    snprintf(service, sizeof(service), "%d", port);
+
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    if (getaddrinfo(host, service, &hints, &addresses) != 0) return NET_INVALID_SOCKET;
+
+    NetSocket sock = NET_INVALID_SOCKET;
+    for (addrinfo* address = addresses; address; address = address->ai_next)
+    {
+        sock = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (sock == NET_INVALID_SOCKET) continue;
+        NetSetTimeout(sock, NET_TIMEOUT_MS);
+        if (connect(sock, address->ai_addr, static_cast<int>(address->ai_addrlen)) == 0) break;
+        NetClose(sock);
+        sock = NET_INVALID_SOCKET;
+    }
+    freeaddrinfo(addresses);
+    return sock;
+}
+
+inline NetSocket NetListen(int port)
+{
+    NetSocket sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock == NET_INVALID_SOCKET) return sock;
+
+    int reuse = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (bind(sock, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(sock, 64) != 0)
+    {
+        NetClose(sock);
+        return NET_INVALID_SOCKET;
+    }
+    return sock;
+}
+
+inline bool NetSendAll(NetSocket sock, const char* data, size_t size)
+{
+    while (size > 0)
+    {
+        int sent = send(sock, data, static_cast<int>(size), 0);
+        if (sent <= 0) return false;
+        data += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+struct HttpMessage {
+    std::string startLine;  // "POST /scores HTTP/1.0" or "HTTP/1.0 200 OK"
+    std::string body;
+};
+
+// Reads headers, then Content-Length bytes of body (none without the header)
+inline bool NetReadHttp(NetSocket sock, HttpMessage& message)
+{
+    std::string data;
+    char buffer[4096];
+    size_t headerEnd = std::string::npos;
+    size_t contentLength = 0;
+
+    while (headerEnd == std::string::npos || data.size() < headerEnd + 4 + contentLength)
+    {
+        int received = recv(sock, buffer, sizeof(buffer), 0);
+        if (received <= 0 || data.size() + received > NET_MAX_REQUEST) return false;
+        data.append(buffer, received);
+
+        if (headerEnd == std::string::npos && (headerEnd = data.find("\r\n\r\n")) != std::string::npos)
+        {
+            for (size_t line = data.find("\r\n") + 2; line < headerEnd; line = data.find("\r\n", line) + 2)
+            {
+                if (strncasecmp(data.c_str() + line, "Content-Length:", 15) == 0)
+                    contentLength = strtoul(data.c_str() + line + 15, nullptr, 10);
+            }
+        }
+    }
+
+    message.startLine = data.substr(0, data.find("\r\n"));
+    message.body = data.substr(headerEnd + 4, contentLength);
+    return true;
+}
+
+// Value of key in a query string ("?seed=2&n=10"), or fallback
+inline long HttpQueryValue(const std::string& target, const char* key, long fallback)
+{
+    size_t keyLength = strlen(key);
+    size_t pos = target.find('?');
+    while (pos != std::string::npos)
+    {
+        pos++;
+        if (target.compare(pos, keyLength, key) == 0 && pos + keyLength < target.size() &&
+            target[pos + keyLength] == '=')
+            return atol(target.c_str() + pos + keyLength + 1);
+        pos = target.find('&', pos);
+    }
+    return fallback;
+}
+
+#endif // NET_H
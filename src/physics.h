@@ -0,0 +1,196 @@
+#ifndef PHYSICS_H
+#define PHYSICS_H
+
+// Egg flight and launch math shared by the game and the headless tools.
+// Nothing in here may depend on SDL so the tools can build without it.
+
+#include <cmath>
+#include <cstdlib>
+
+#include "tunables.h"  // GRAVITY, LAUNCH_POWER_SCALE and the other tuned values
+#include "fixed_point.h"
+
+// Physics advances one fixed step per frame at TARGET_FPS
+#define TARGET_FPS 60
+#define FRAME_TIME (1000.0f / TARGET_FPS)
+
+#define WINDOW_WIDTH 800
+#define WINDOW_HEIGHT 600
+#define TREE_WIDTH 75
+#define EGG_SIZE_SCALE 1.0f
+#define EGG_SIZE_X (int)(50*EGG_SIZE_SCALE)
+#define EGG_SIZE_Y (int)(75*EGG_SIZE_SCALE)
+#define ANGLE_BAR_WIDTH 20
+#define ANGLE_BAR_HEIGHT 200
+#define ANGLE_BAR_X 240
+#define ANGLE_BAR_Y 370
+#define ANGLE_SQUARE_SIZE 15
+#define PI 3.14159265359f
+
+// Same layout as SDL_Rect, so the game can convert freely
+struct SimRect {
+    int x, y;
+    int w, h;
+};
+
+inline bool RectsOverlap(const SimRect& a, const SimRect& b)
+{
+    return (a.x < b.x + b.w &&
+            a.x + a.w > b.x &&
+            a.y < b.y + b.h &&
+            a.y + a.h > b.y);
+}
+
+enum {
+    TREE_HIT_NONE,
+    TREE_HIT_LEFT,
+    TREE_HIT_RIGHT
+};
+
+// Advances a flying egg by one physics frame (gravity, movement and tree bounce).
+// outRect receives the collision rect at the new position, before the tree bounce
+// correction, which is the rect the catch and win checks are made against.
+inline int StepEggFlight(float& x, float& y, float& velocityX, float& velocityY,
+                         int width, int height,
+                         const SimRect& leftTree, const SimRect& rightTree,
+                         SimRect& outRect)
+{
+    // Apply gravity
+    velocityY += GRAVITY;
+    if (velocityY > TERMINAL_VELOCITY)
+        velocityY = TERMINAL_VELOCITY;
+
+    // Calculate new position
+    float newX = x + velocityX;
+    float newY = y + velocityY;
+
+    outRect = {
+        static_cast<int>(newX),
+        static_cast<int>(newY),
+        width,
+        height
+    };
+
+    int treeHit = TREE_HIT_NONE;
+    if (RectsOverlap(outRect, leftTree))
+    {
+        newX = leftTree.x + leftTree.w;
+        velocityX = fabs(velocityX) * 0.5f;
+        treeHit = TREE_HIT_LEFT;
+    }
+    else if (RectsOverlap(outRect, rightTree))
+    {
+        newX = rightTree.x - width;
+        velocityX = -fabs(velocityX) * 0.5f;
+        treeHit = TREE_HIT_RIGHT;
+    }
+
+    if (treeHit != TREE_HIT_NONE)
+    {
+        // Reduce vertical velocity on collision (applied twice, as tuned during the jam)
+        velocityY *= 0.5f;
+        velocityY *= 0.5f;
+    }
+
+    x = newX;
+    y = newY;
+    return treeHit;
+}
+
+// StepEggFlight in 16.16 fixed point, for GameState::fixedPhysics. Same rules, but every
+// step gives the same bits on every platform. Position and velocity stay fixed point
+// from step to step, see fixed_point.h.
+inline int StepEggFlightFixed(Fixed& x, Fixed& y, Fixed& velocityX, Fixed& velocityY,
+                              int width, int height,
+                              const SimRect& leftTree, const SimRect& rightTree,
+                              SimRect& outRect)
+{
+    Fixed fixedVelocityX = velocityX;
+    Fixed fixedVelocityY = velocityY + FixedFromFloat(GRAVITY);
+    Fixed terminalVelocity = FixedFromFloat(TERMINAL_VELOCITY);
+    if (fixedVelocityY > terminalVelocity)
+        fixedVelocityY = terminalVelocity;
+
+    Fixed newX = x + fixedVelocityX;
+    Fixed newY = y + fixedVelocityY;
+
+    outRect = {
+        FixedToInt(newX),
+        FixedToInt(newY),
+        width,
+        height
+    };
+
+    int treeHit = TREE_HIT_NONE;
+    if (RectsOverlap(outRect, leftTree))
+    {
+        newX = FixedFromInt(leftTree.x + leftTree.w);
+        fixedVelocityX = abs(fixedVelocityX) / 2;
+        treeHit = TREE_HIT_LEFT;
+    }
+    else if (RectsOverlap(outRect, rightTree))
+    {
+        newX = FixedFromInt(rightTree.x - width);
+        fixedVelocityX = -abs(fixedVelocityX) / 2;
+        treeHit = TREE_HIT_RIGHT;
+    }
+
+    if (treeHit != TREE_HIT_NONE)
+    {
+        fixedVelocityY /= 4;  // The float path halves twice
+    }
+
+    x = newX;
+    y = newY;
+    velocityX = fixedVelocityX;
+    velocityY = fixedVelocityY;
+    return treeHit;
+}
+
+// Angle square position to launch angle in radians (0 at bottom, PI/2 at top)
+inline float LaunchAngleFromSquare(float angleSquareY)
+{
+    float normalizedY = (ANGLE_BAR_Y + ANGLE_BAR_HEIGHT - ANGLE_SQUARE_SIZE - angleSquareY)
+                     / (ANGLE_BAR_HEIGHT - ANGLE_SQUARE_SIZE);
+    return normalizedY * PI / 2;
+}
+
+inline void LaunchVelocity(float strengthCharge, float angle, bool launchRight,
+                           float& velocityX, float& velocityY)
+{
+    float power = LAUNCH_POWER_SCALE * strengthCharge;
+
+    velocityX = launchRight ? power * cos(angle) : -power * cos(angle);
+    velocityY = -power * sin(angle);
+}
+
+// LaunchAngleFromSquare and LaunchVelocity in fixed point, with table sine and cosine
+inline void LaunchVelocityFixed(float strengthCharge, float angleSquareY, bool launchRight,
+                                Fixed& velocityX, Fixed& velocityY)
+{
+    // 0 at the bottom of the bar, FIXED_ONE (a quarter turn) at the top
+    Fixed fromBottom = FixedFromInt(ANGLE_BAR_Y + ANGLE_BAR_HEIGHT - ANGLE_SQUARE_SIZE) - FixedFromFloat(angleSquareY);
+    Fixed turn = fromBottom / (ANGLE_BAR_HEIGHT - ANGLE_SQUARE_SIZE);
+
+    Fixed power = FixedMul(FixedFromFloat(LAUNCH_POWER_SCALE), FixedFromFloat(strengthCharge));
+    Fixed horizontal = FixedMul(power, FixedQuarterCosine(turn));
+
+    velocityX = launchRight ? horizontal : -horizontal;
+    velocityY = -FixedMul(power, FixedQuarterSine(turn));
+}
+
+// Where the egg sits once a squirrel catches it (hand tuned to land on the tail)
+inline void EggCatchPosition(float squirrelX, float squirrelY, int squirrelSpriteWidth,
+                             bool squirrelIsLeftSide, bool isFloorSquirrel,
+                             int eggWidth, int eggHeight,
+                             float& eggX, float& eggY)
+{
+    int offset_y = -110, offset_x = 50;
+    if (squirrelIsLeftSide) { offset_y = -110; offset_x = 0; }
+    if (isFloorSquirrel)    { offset_y = -110; offset_x = 0; }
+
+    eggY = squirrelY + eggHeight + offset_y;
+    eggX = squirrelX + offset_x + (squirrelSpriteWidth - eggWidth) / 2;
+}
+
+#endif // PHYSICS_H
@@ -0,0 +1,331 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+// Replay files: the inputs of a whole session, enough to re-run it frame for frame.
+// The simulation runs in fixed TARGET_FPS steps and reads its input as a bitfield per
+// step, plus when within the step a charge started or ended, so recording only has to
+// store the steps that had any input.
+//
+// Layout (little endian):
+//   header: magic, version, seed, build hash, checksum interval, REPLAY_FLAG_* byte
+//     (version 3 on), physics constants
+//   records: varint (frames since previous record << 2 | kind), then
+//     REPLAY_RECORD_INPUT     one byte of REPLAY_INPUT_* bits, then a byte of chargeTime
+//                             if it has REPLAY_INPUT_CHARGE and of releaseTime if it has
+//                             REPLAY_INPUT_RELEASE (version 2 on, version 1 has neither)
+//     REPLAY_RECORD_CHECKSUM  u16 of the egg state, every checksumInterval frames
+//                             unless it did not change (egg held), which skips most
+//     REPLAY_RECORD_END       one byte, nonzero if the run reached the nest
+// From version 4 the interval is 1 and a frame without a checksum means the egg did not
+// change, so playback checks every frame and names the first one that drifted. That costs
+// three bytes per frame of flight, a 60 second run comes to a few kilobytes. Older
+// versions checked every 30 frames and can only name the window.
+
+#include <cstring>
+
+#include "encoding.h"
+#include "physics.h"
+
+#ifndef BUILD_HASH
+#define BUILD_HASH 0  // The Makefile passes the short git hash
+#endif
+
+#define REPLAY_MAGIC 0x50524B43u  // "CKRP"
+#define REPLAY_VERSION 4
+#define REPLAY_OLDEST_VERSION 1  // Before sub-step input times, still plays back
+#define REPLAY_CHECKSUM_INTERVAL 1  // Frames, every frame the egg moved
+#define REPLAY_PHYSICS_CONSTANTS 7
+
+// Inputs the simulation acts on, applied in this bit order within a frame
+enum {
+    REPLAY_INPUT_CHARGE     = 1 << 0,  // Space / K down
+    REPLAY_INPUT_ANGLE      = 1 << 1,  // Mouse button / L
+    REPLAY_INPUT_FACE_LEFT  = 1 << 2,  // A
+    REPLAY_INPUT_FACE_RIGHT = 1 << 3,  // D
+    REPLAY_INPUT_RELEASE    = 1 << 4,  // Space up: launch, or leave the nest
+    REPLAY_INPUT_DROP       = 1 << 5,  // Enter: leave the nest
+    REPLAY_INPUT_TELEPORT   = 1 << 6   // I (debug)
+};
+
+#define REPLAY_INPUT_DEBUG REPLAY_INPUT_TELEPORT  // Inputs no verified run may contain
+
+// One step's input. The times say how far into the step, in 1/256ths, the key went
+// down or up, so a launch does not depend on which frame happened to poll the event.
+struct StepInput {
+    uint8_t bits;         // REPLAY_INPUT_*
+    uint8_t chargeTime;   // With REPLAY_INPUT_CHARGE
+    uint8_t releaseTime;  // With REPLAY_INPUT_RELEASE
+};
+
+// How the run was simulated, the player has to simulate it the same way
+enum {
+    REPLAY_FLAG_FIXED_PHYSICS = 1 << 0  // GameState::fixedPhysics
+};
+
+enum {
+    REPLAY_RECORD_INPUT,
+    REPLAY_RECORD_CHECKSUM,
+    REPLAY_RECORD_END
+};
+
+struct ReplayHeader {
+    uint8_t version;
+    uint32_t seed;
+    uint32_t buildHash;
+    uint32_t checksumInterval;
+    uint8_t flags;  // REPLAY_FLAG_*, 0 before version 3
+    float physics[REPLAY_PHYSICS_CONSTANTS];
+};
+
+// What this build simulates with, in header order
+inline void CurrentPhysicsConstants(float* constants)
+{
+    const float values[REPLAY_PHYSICS_CONSTANTS] = {
+        static_cast<float>(TARGET_FPS), GRAVITY, TERMINAL_VELOCITY, STRENGTH_CHARGE_RATE,
+        ANGLE_GRAVITY, ANGLE_JUMP_POWER, LAUNCH_POWER_SCALE
+    };
+    memcpy(constants, values, sizeof(values));
+}
+
+// 16 bit FNV-1a fold of the egg position and velocity
+inline uint16_t EggStateChecksum(float x, float y, float velocityX, float velocityY)
+{
+    const float state[4] = {x, y, velocityX, velocityY};
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(state);
+
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(state); i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return static_cast<uint16_t>(hash ^ (hash >> 16));
+}
+
+struct ReplayRecorder {
+    ByteWriter writer;
+    uint32_t lastRecordFrame;
+    uint16_t lastChecksum;
+    bool active;
+};
+
+inline void WriteReplayRecord(ReplayRecorder& recorder, uint32_t frame, int kind)
+{
+    WriteVarint(recorder.writer, ((frame - recorder.lastRecordFrame) << 2) | kind);
+    recorder.lastRecordFrame = frame;
+}
+
+inline void StartReplayRecording(ReplayRecorder& recorder, uint32_t seed, uint8_t flags)
+{
+    recorder.writer.bytes.clear();
+    recorder.writer.bytes.reserve(4096);
+    recorder.lastRecordFrame = 0;
+    recorder.lastChecksum = 0;
+    recorder.active = true;
+
+    float constants[REPLAY_PHYSICS_CONSTANTS];
+    CurrentPhysicsConstants(constants);
+
+    WriteU32(recorder.writer, REPLAY_MAGIC);
+    WriteByte(recorder.writer, REPLAY_VERSION);
+    WriteU32(recorder.writer, seed);
+    WriteU32(recorder.writer, BUILD_HASH);
+    WriteByte(recorder.writer, REPLAY_CHECKSUM_INTERVAL);
+    WriteByte(recorder.writer, flags);
+    for (int i = 0; i < REPLAY_PHYSICS_CONSTANTS; i++)
+    {
+        uint32_t bits;
+        memcpy(&bits, &constants[i], sizeof(bits));
+        WriteU32(recorder.writer, bits);
+    }
+}
+
+// Call once per simulated frame, after the frame ran with input
+inline void RecordReplayFrame(ReplayRecorder& recorder, uint32_t frame, const StepInput& input,
+                              float x, float y, float velocityX, float velocityY)
+{
+    if (!recorder.active) return;
+
+    if (input.bits)
+    {
+        WriteReplayRecord(recorder, frame, REPLAY_RECORD_INPUT);
+        WriteByte(recorder.writer, input.bits);
+        if (input.bits & REPLAY_INPUT_CHARGE) WriteByte(recorder.writer, input.chargeTime);
+        if (input.bits & REPLAY_INPUT_RELEASE) WriteByte(recorder.writer, input.releaseTime);
+    }
+    if (frame % REPLAY_CHECKSUM_INTERVAL != 0) return;
+
+    uint16_t checksum = EggStateChecksum(x, y, velocityX, velocityY);
+    if (frame == 0 || checksum != recorder.lastChecksum)
+    {
+        recorder.lastChecksum = checksum;
+        WriteReplayRecord(recorder, frame, REPLAY_RECORD_CHECKSUM);
+        WriteByte(recorder.writer, static_cast<uint8_t>(checksum));
+        WriteByte(recorder.writer, static_cast<uint8_t>(checksum >> 8));
+    }
+}
+
+inline void FinishReplayRecording(ReplayRecorder& recorder, uint32_t frame, bool won)
+{
+    if (!recorder.active) return;
+
+    WriteReplayRecord(recorder, frame, REPLAY_RECORD_END);
+    WriteByte(recorder.writer, won ? 1 : 0);
+    recorder.active = false;
+}
+
+enum {
+    REPLAY_PLAYING,
+    REPLAY_FINISHED,   // Reached the end record
+    REPLAY_DIVERGED,   // A checksum did not match
+    REPLAY_CORRUPT     // Ran out of data or hit an unknown record
+};
+
+struct ReplayPlayer {
+    ByteReader reader;
+    ReplayHeader header;
+    int status;
+
+    // Next record, read ahead so the frame it applies to is known
+    uint32_t nextFrame;
+    int nextKind;
+
+    // With a checksum every frame a missing record means the egg did not change, so every
+    // frame is checked against the last recorded checksum
+    bool everyFrame;
+    bool haveChecksum;
+    uint16_t expectedChecksum;
+
+    uint32_t lastGoodChecksumFrame;
+    uint32_t divergedFrame;  // First checked frame that did not match
+    uint32_t endFrame;
+    bool won;
+};
+
+inline void ReadNextReplayRecord(ReplayPlayer& player)
+{
+    uint32_t tagged;
+    if (!ReadVarint(player.reader, tagged) || (tagged & 3) > REPLAY_RECORD_END)
+    {
+        player.status = REPLAY_CORRUPT;
+        return;
+    }
+    player.nextFrame += tagged >> 2;
+    player.nextKind = tagged & 3;
+}
+
+// reader must already be open. Fails on anything that is not a replay of a known version.
+inline bool StartReplayPlayback(ReplayPlayer& player)
+{
+    uint32_t magic = 0;
+    uint8_t version = 0, interval = 0;
+    if (!ReadU32(player.reader, magic) || magic != REPLAY_MAGIC ||
+        !ReadByte(player.reader, version) ||
+        version < REPLAY_OLDEST_VERSION || version > REPLAY_VERSION ||
+        !ReadU32(player.reader, player.header.seed) ||
+        !ReadU32(player.reader, player.header.buildHash) ||
+        !ReadByte(player.reader, interval) || interval == 0)
+    {
+        return false;
+    }
+    player.header.version = version;
+    player.header.checksumInterval = interval;
+    player.header.flags = 0;
+    if (version >= 3 && !ReadByte(player.reader, player.header.flags)) return false;
+
+    for (int i = 0; i < REPLAY_PHYSICS_CONSTANTS; i++)
+    {
+        uint32_t bits;
+        if (!ReadU32(player.reader, bits)) return false;
+        memcpy(&player.header.physics[i], &bits, sizeof(bits));
+    }
+
+    player.status = REPLAY_PLAYING;
+    player.nextFrame = 0;
+    player.everyFrame = interval == 1;
+    player.haveChecksum = false;
+    player.expectedChecksum = 0;
+    player.lastGoodChecksumFrame = 0;
+    player.divergedFrame = 0;
+    player.endFrame = 0;
+    player.won = false;
+    ReadNextReplayRecord(player);
+    return player.status == REPLAY_PLAYING;
+}
+
+// Whether the recording was made with the physics this build runs
+inline bool ReplayPhysicsMatch(const ReplayHeader& header)
+{
+    float constants[REPLAY_PHYSICS_CONSTANTS];
+    CurrentPhysicsConstants(constants);
+    return memcmp(constants, header.physics, sizeof(constants)) == 0;
+}
+
+// Input for frame, call before simulating it
+inline StepInput ReplayInputForFrame(ReplayPlayer& player, uint32_t frame)
+{
+    StepInput input = {};
+    bool timed = player.header.version >= 2;
+    while (player.status == REPLAY_PLAYING &&
+           player.nextKind == REPLAY_RECORD_INPUT && player.nextFrame == frame)
+    {
+        uint8_t bits;
+        if (!ReadByte(player.reader, bits) ||
+            (timed && (bits & REPLAY_INPUT_CHARGE) && !ReadByte(player.reader, input.chargeTime)) ||
+            (timed && (bits & REPLAY_INPUT_RELEASE) && !ReadByte(player.reader, input.releaseTime)))
+        {
+            player.status = REPLAY_CORRUPT;
+            break;
+        }
+        input.bits |= bits;
+        ReadNextReplayRecord(player);
+    }
+    return input;
+}
+
+// Call after simulating frame, checks the egg against the recording
+inline void CheckReplayFrame(ReplayPlayer& player, uint32_t frame,
+                             float x, float y, float velocityX, float velocityY)
+{
+    if (player.status != REPLAY_PLAYING) return;
+
+    bool recorded = player.nextFrame == frame && player.nextKind == REPLAY_RECORD_CHECKSUM;
+    if (recorded)
+    {
+        uint8_t low, high;
+        if (!ReadByte(player.reader, low) || !ReadByte(player.reader, high))
+        {
+            player.status = REPLAY_CORRUPT;
+            return;
+        }
+        player.expectedChecksum = static_cast<uint16_t>(low | (high << 8));
+        player.haveChecksum = true;
+    }
+
+    if (recorded || (player.everyFrame && player.haveChecksum))
+    {
+        if (player.expectedChecksum != EggStateChecksum(x, y, velocityX, velocityY))
+        {
+            player.status = REPLAY_DIVERGED;
+            player.divergedFrame = frame;
+            return;
+        }
+        player.lastGoodChecksumFrame = frame;
+    }
+    if (recorded) ReadNextReplayRecord(player);
+
+    if (player.status == REPLAY_PLAYING && player.nextKind == REPLAY_RECORD_END && player.nextFrame == frame)
+    {
+        uint8_t won;
+        if (!ReadByte(player.reader, won))
+        {
+            player.status = REPLAY_CORRUPT;
+            return;
+        }
+        player.won = won != 0;
+        player.endFrame = frame;
+        player.status = REPLAY_FINISHED;
+    }
+}
+
+#endif // REPLAY_H
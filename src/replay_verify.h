@@ -0,0 +1,114 @@
+#ifndef REPLAY_VERIFY_H
+#define REPLAY_VERIFY_H
+
+// Re-runs a replay through the simulation and accepts it only if the egg reaches the
+// nest on the frame the replay says it did. The run time comes from the simulation's
+// frame count, never from the client. Shared by the replay verifier and the leaderboard
+// server, which checks every submitted run this way before ranking it.
+// Include after defining SIM_LOG, like simulation.h.
+
+#include <cstdint>
+
+#include "simulation.h"
+
+#define VERIFIER_MAX_FRAMES (TARGET_FPS * 60 * 60)  // Give up on anything longer than an hour
+
+enum {
+    VERIFY_OK,          // Reached the nest on the recorded frame
+    VERIFY_NOT_WON,     // Replays fine but never reaches the nest
+    VERIFY_MISMATCH,    // Replay claims a win the simulation does not reproduce (or the reverse)
+    VERIFY_DIVERGED,    // A checksum did not match
+    VERIFY_CORRUPT,     // Truncated or malformed record stream
+    VERIFY_BAD_FILE,    // Unreadable, or not a replay of this version
+    VERIFY_TOO_LONG,
+    VERIFY_DEBUG_INPUT, // Used a debug key (REPLAY_INPUT_DEBUG), never a valid run
+    VERIFY_RESULT_COUNT
+};
+
+struct VerifyResult {
+    int result;
+    uint32_t seed;
+    uint32_t frames;      // Frames simulated
+    uint32_t runFrames;   // First launch to nest, when won
+    uint32_t divergedAfter;
+    uint32_t divergedAt;
+    bool foreignBuild;    // Recorded by another build hash or with other physics
+};
+
+inline const char* VerifyResultName(int result)
+{
+    static const char* names[VERIFY_RESULT_COUNT] = {
+        "ok", "not_won", "mismatch", "diverged", "corrupt", "bad_file", "too_long", "debug_input"
+    };
+    return result >= 0 && result < VERIFY_RESULT_COUNT ? names[result] : "unknown";
+}
+
+// state is scratch, large enough that callers keep one per thread off the stack
+inline VerifyResult VerifyReplay(const uint8_t* data, size_t size, const SquirrelMetrics& metrics, GameState& state)
+{
+    VerifyResult verdict = {};
+
+    ReplayPlayer player = {};
+    OpenByteReader(player.reader, data, size);
+    if (!StartReplayPlayback(player))
+    {
+        verdict.result = VERIFY_BAD_FILE;
+        return verdict;
+    }
+    verdict.seed = player.header.seed;
+    verdict.foreignBuild = player.header.buildHash != BUILD_HASH || !ReplayPhysicsMatch(player.header);
+
+    InitSimulation(state, player.header.seed, metrics);
+    state.fixedPhysics = (player.header.flags & REPLAY_FLAG_FIXED_PHYSICS) != 0;
+
+    uint32_t frame = 0;
+    while (player.status == REPLAY_PLAYING && frame < VERIFIER_MAX_FRAMES)
+    {
+        StepInput input = ReplayInputForFrame(player, frame);
+        if (input.bits & REPLAY_INPUT_DEBUG)
+        {
+            verdict.frames = frame;
+            verdict.result = VERIFY_DEBUG_INPUT;
+            return verdict;
+        }
+        StepSimulation(state, input);
+        CheckReplayFrame(player, frame, state.egg.x, state.egg.y, state.eggVelocityX, state.eggVelocityY);
+        frame++;
+    }
+    verdict.frames = frame;
+
+    switch (player.status)
+    {
+    case REPLAY_PLAYING:
+        verdict.result = VERIFY_TOO_LONG;
+        break;
+    case REPLAY_DIVERGED:
+        verdict.result = VERIFY_DIVERGED;
+        verdict.divergedAfter = player.lastGoodChecksumFrame;
+        verdict.divergedAt = player.divergedFrame;
+        break;
+    case REPLAY_CORRUPT:
+        verdict.result = VERIFY_CORRUPT;
+        break;
+    case REPLAY_FINISHED:
+        // The recording ends on the frame of the win, and only the simulation's word counts
+        bool simWonNow = (state.events & SIM_EVENT_WIN) != 0;
+        if (player.won && simWonNow)
+        {
+            verdict.result = VERIFY_OK;
+            verdict.runFrames = state.winFrames;
+        }
+        else if (player.won || state.winAchieved)
+        {
+            verdict.result = VERIFY_MISMATCH;
+        }
+        else
+        {
+            verdict.result = VERIFY_NOT_WON;
+        }
+        break;
+    }
+    return verdict;
+}
+
+#endif // REPLAY_VERIFY_H
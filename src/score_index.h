@@ -0,0 +1,67 @@
+#ifndef SCORE_INDEX_H
+#define SCORE_INDEX_H
+
+// Order statistics over run times: how many runs were faster than t, and which time
+// holds rank k. Times are kept in one sorted vector, so memory follows the number of
+// runs, four bytes each, whatever times are submitted. Queries are a binary search;
+// adding a run shifts the slower ones along, a memmove even at a million runs a seed.
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#define SCORE_INDEX_MAX_MS (60u * 60u * 1000u)  // An hour, slower runs count as this
+
+struct ScoreIndex {
+    std::vector<uint32_t> times;  // Ascending, ties kept side by side
+    uint32_t count = 0;
+};
+
+inline uint32_t ClampScoreTime(uint32_t timeMs)
+{
+    return timeMs < SCORE_INDEX_MAX_MS ? timeMs : SCORE_INDEX_MAX_MS - 1;
+}
+
+inline void ResetScoreIndex(ScoreIndex& index)
+{
+    index.times.clear();
+    index.count = 0;
+}
+
+inline void AddScore(ScoreIndex& index, uint32_t timeMs)
+{
+    timeMs = ClampScoreTime(timeMs);
+    index.times.insert(std::upper_bound(index.times.begin(), index.times.end(), timeMs), timeMs);
+    index.count++;
+}
+
+// Runs strictly faster than timeMs
+inline uint32_t CountFasterScores(const ScoreIndex& index, uint32_t timeMs)
+{
+    auto first = std::lower_bound(index.times.begin(), index.times.end(), timeMs);
+    return static_cast<uint32_t>(first - index.times.begin());
+}
+
+// 1 for a new best, ties share the better rank
+inline uint32_t ScoreRank(const ScoreIndex& index, uint32_t timeMs)
+{
+    return CountFasterScores(index, timeMs) + 1;
+}
+
+// Share of recorded runs this time beats, 0 to 100
+inline float ScorePercentile(const ScoreIndex& index, uint32_t timeMs)
+{
+    if (index.count == 0) return 100.0f;
+    uint32_t slower = index.count - CountFasterScores(index, timeMs + 1);
+    return 100.0f * slower / index.count;
+}
+
+// Time at rank (1 = fastest)
+inline bool ScoreAtRank(const ScoreIndex& index, uint32_t rank, uint32_t& timeMs)
+{
+    if (rank == 0 || rank > index.count) return false;
+    timeMs = index.times[rank - 1];
+    return true;
+}
+
+#endif // SCORE_INDEX_H
@@ -0,0 +1,708 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+// The game simulation without SDL: level setup, input, egg physics, catches, the
+// timer and squirrel animations, all on a GameState passed in by the caller.
+// The game steps it once per FRAME_TIME and reacts to the SIM_EVENT_* flags (sounds,
+// scores, ghosts); the replay verifier steps it as fast as it can.
+// Textures ride along as opaque pointers that only the game ever dereferences.
+
+#include <cstdint>
+#include <cstdio>
+
+#include "physics.h"
+#include "level.h"
+#include "entity_pool.h"
+#include "replay.h"
+
+#ifndef SIM_LOG
+#define SIM_LOG printf  // Headless tools define this away before including
+#endif
+
+struct SDL_Texture;
+
+#define EGG_ANIMATION_SPEED 0.7f  // Adjust speed as needed, measured in seconds
+#define SQUIRREL_ANIMATION_FRAME 0.4f  // Launch animation frame time, measured in seconds
+
+struct GameObject {
+    float x, y;
+    int width, height;
+    SDL_Texture* texture;
+    bool isLeftSide;  // Used for squirrels to determine which side they're on
+    int currentSprite = 0;
+    int spriteWidths[SPRITE_SQUIRREL_MAX_VALUE] = {0};
+    int spriteHeights[SPRITE_SQUIRREL_MAX_VALUE] = {0};
+    int branchType;      // For branches: which type of branch (0-2)
+    int positionIndex;   // For squirrels: which position on the branch (0-1)
+    float animationTimer;  // Track animation duration, measured in seconds
+    bool hasEgg;          // Track if squirrel has egg
+    uint8_t alpha = 255;  // Texture alpha modulation, for the ghost egg
+};
+
+// Room for a whole level or every resident endless chunk (8 chunks of 32), whichever is larger
+#define LEVEL_ENTITY_CAPACITY 256
+static_assert(LEVEL_ENTITY_CAPACITY >= LEVEL_MAX_BRANCHES, "a whole level must fit");
+
+// activeSquirrel value for the floor squirrel, which lives outside the pools
+#define FLOOR_SQUIRREL_HANDLE (INVALID_ENTITY_HANDLE - 1)
+
+typedef EntityPool<GameObject, LEVEL_ENTITY_CAPACITY> LevelEntityPool;
+
+// Raised by a step for the game to react to, cleared at the start of the next one
+enum {
+    SIM_EVENT_LAUNCH    = 1 << 0,  // Egg left a squirrel
+    SIM_EVENT_TREE_HIT  = 1 << 1,
+    SIM_EVENT_CATCH     = 1 << 2,  // A branch squirrel caught the egg
+    SIM_EVENT_MISS      = 1 << 3,  // Egg fell, now with the floor squirrel
+    SIM_EVENT_WIN       = 1 << 4,  // Egg reached the nest, winFrames is set
+    SIM_EVENT_RUN_START = 1 << 5   // Timer started with this launch
+};
+
+struct GameState {
+    GameObject egg;
+    float eggVelocityY;  // Vertical velocity of egg
+    float eggVelocityX;  // Add horizontal velocity
+    bool eggIsHeld;      // Whether a squirrel is holding the egg
+    LevelEntityPool squirrels;  // Bottom to top
+    LevelEntityPool branches;
+    GameObject leftTree;
+    GameObject rightTree;
+    float strengthCharge;     // 0.0 to 1.0
+    bool isCharging;         // Is left mouse being held
+    bool isDepletingCharge;  // Has charge maxed out
+    float angleSquareY;      // Position in the angle bar
+    float angleSquareVelocity;
+    GameObject floorSquirrel;  // New floor squirrel
+    bool isLaunchingRight;  // Direction flag
+    EntityHandle activeSquirrel = FLOOR_SQUIRREL_HANDLE;  // Squirrel currently holding egg
+    float cameraY;  // Vertical camera offset
+    float targetCameraY;  // Target position for smooth scrolling
+    int currentEggSprite = 0;
+    GameObject nest;
+    bool isInNest;  // New flag to track if egg is in starting position
+    bool isFirstFall = 1;
+
+    uint32_t frame;            // Steps since InitSimulation
+    uint32_t timerStartFrame;  // Frame of the launch that started the timer
+    bool timerActive;
+    bool winAchieved;
+    uint32_t winFrames;        // First launch to nest, the authoritative run time
+    uint32_t events;           // SIM_EVENT_* from the last step
+
+    bool endless;              // No nest, falling out of view is a miss
+    bool fixedPhysics;         // Flight and launch in fixed point (fixed_point.h), kept by InitSimulation
+    Fixed eggFixedX, eggFixedY;  // fixedPhysics flight state, egg.x, egg.y and eggVelocity*
+    Fixed eggFixedVelocityX;     // are float copies of it for drawing and replay checks
+    Fixed eggFixedVelocityY;
+    float floorBottom;         // Misses below this (moves with the endless origin)
+    float eggAnimationTime;
+    float squirrelAnimationTime;  // Launch animation, shared by all squirrels
+
+    Level level;  // Generation scratch, reused so rebuilding the level does not allocate
+};
+
+inline uint32_t FramesToMs(uint32_t frames)
+{
+    return static_cast<uint32_t>(frames * 1000ull / TARGET_FPS);
+}
+
+inline void SetSquirrelSpriteDimensions(GameObject& squirrel, const SquirrelMetrics& metrics)
+{
+    for (int i = 0; i < SPRITE_SQUIRREL_MAX_VALUE; i++) {
+        squirrel.spriteWidths[i] = metrics.spriteWidths[i];
+        squirrel.spriteHeights[i] = metrics.spriteHeights[i];
+    }
+}
+
+inline GameObject MakeBranchObject(const LevelBranch& levelBranch, float offsetY)
+{
+    GameObject branch = {
+        levelBranch.x,
+        offsetY + levelBranch.y,
+        levelBranch.extension,
+        BRANCH_HEIGHT,
+        nullptr,  // Drawn with the texture for branchType
+        levelBranch.isLeft,
+        levelBranch.branchType
+    };
+    return branch;
+}
+
+inline GameObject MakeSquirrelObject(const LevelSquirrel& levelSquirrel, float offsetY, const SquirrelMetrics& metrics)
+{
+    GameObject squirrel = {
+        levelSquirrel.x,
+        offsetY + levelSquirrel.y,
+        metrics.spriteWidths[0],
+        metrics.spriteHeights[0],
+        nullptr,  // Drawn with the texture for currentSprite
+        levelSquirrel.isLeftSide,
+        SPRITE_SQUIRREL_WITHOUT_EGG_0,  // currentSprite
+        {0},  // spriteWidths
+        {0},  // spriteHeights
+        -1,   // branchType (not used for squirrels)
+        levelSquirrel.positionIndex,
+        0.0f,           // animationTimer
+        false           // hasEgg
+    };
+    SetSquirrelSpriteDimensions(squirrel, metrics);
+    return squirrel;
+}
+
+inline void BuildLevel(GameState& state, uint32_t seed, const SquirrelMetrics& metrics)
+{
+    // Clear existing branches and squirrels, O(1) and invalidates old handles
+    ResetPool(state.branches);
+    ResetPool(state.squirrels);
+
+    // Same seed, same level on every platform (see level.h)
+    GenerateLevel(seed, DefaultLevelParams(), metrics, state.level);
+
+    for (const LevelBranch& levelBranch : state.level.branches)
+    {
+        if (!PoolAppend(state.branches, MakeBranchObject(levelBranch, 0.0f))) break;
+    }
+
+    for (const LevelSquirrel& levelSquirrel : state.level.squirrels)
+    {
+        if (!PoolAppend(state.squirrels, MakeSquirrelObject(levelSquirrel, 0.0f, metrics))) break;
+    }
+
+    if (PoolCount(state.squirrels) < static_cast<int>(state.level.squirrels.size()))
+        SIM_LOG("Level has %zu squirrels, only %d fit\n", state.level.squirrels.size(), LEVEL_ENTITY_CAPACITY);
+    SIM_LOG("Generated %d branches and squirrels (seed %u)\n", PoolCount(state.branches), seed);
+}
+
+// Everything back to the start of a run: egg in the nest, timer stopped
+inline void InitSimulation(GameState& state, uint32_t seed, const SquirrelMetrics& metrics)
+{
+    // Setup trees
+    state.leftTree = {
+        0.0f,
+        0.0f,
+        TREE_WIDTH,
+        static_cast<int>(TOTAL_GAME_HEIGHT),
+        nullptr,
+        true
+    };
+
+    state.rightTree = {
+        static_cast<float>(WINDOW_WIDTH - TREE_WIDTH),
+        0.0f,
+        TREE_WIDTH,
+        static_cast<int>(TOTAL_GAME_HEIGHT),
+        nullptr,
+        false
+    };
+
+    // Position floor squirrel at the bottom of the total height plus an offset
+    float floorX, floorY;
+    FloorSquirrelPosition(metrics, TOTAL_GAME_HEIGHT, floorX, floorY);
+    state.floorSquirrel = {
+        floorX,
+        floorY,
+        metrics.spriteWidths[0],
+        metrics.spriteHeights[0],
+        nullptr,
+        true
+    };
+    SetSquirrelSpriteDimensions(state.floorSquirrel, metrics);
+
+    // Generate branches and squirrels
+    BuildLevel(state, seed, metrics);
+
+    // Initialize nest position at the top-middle of the screen
+    SimRect nestRect = NestRect();
+    state.nest = GameObject();
+    state.nest.x = nestRect.x;
+    state.nest.y = nestRect.y;
+    state.nest.width = NEST_SIZE;
+    state.nest.height = NEST_SIZE;
+
+    // Initialize egg position on nest
+    state.egg = {
+        state.nest.x + (NEST_SIZE - EGG_SIZE_X) / 2,  // Center egg on nest
+        state.nest.y,
+        EGG_SIZE_X,
+        EGG_SIZE_Y,
+        nullptr,
+        false
+    };
+
+    state.eggVelocityY = 0.0f;
+    state.eggVelocityX = 0.0f;
+    state.eggIsHeld = false;
+    state.isInNest = true;  // Start in nest
+    state.isFirstFall = true;
+
+    state.strengthCharge = 0.0f;
+    state.isCharging = false;
+    state.isDepletingCharge = false;
+    state.angleSquareY = ANGLE_BAR_Y + ANGLE_BAR_HEIGHT - ANGLE_SQUARE_SIZE;
+    state.angleSquareVelocity = 0.0f;
+    state.isLaunchingRight = true;  // Default to right direction
+    state.activeSquirrel = FLOOR_SQUIRREL_HANDLE;  // Start with floor squirrel
+    state.cameraY = 0.0f;
+    state.targetCameraY = 0.0f;
+    state.currentEggSprite = 0;
+
+    state.frame = 0;
+    state.timerStartFrame = 0;
+    state.timerActive = false;
+    state.winAchieved = false;
+    state.winFrames = 0;
+    state.events = 0;
+
+    state.endless = false;
+    state.floorBottom = TOTAL_GAME_HEIGHT;
+    state.eggAnimationTime = 0.0f;
+    state.squirrelAnimationTime = 0.0f;
+}
+
+// Floor squirrel or a live pooled one, nullptr once the handle went stale (evicted or reset)
+inline GameObject* GetSquirrel(GameState& state, EntityHandle handle)
+{
+    if (handle == FLOOR_SQUIRREL_HANDLE) return &state.floorSquirrel;
+    return PoolGet(state.squirrels, handle);
+}
+
+inline const GameObject* GetSquirrel(const GameState& state, EntityHandle handle)
+{
+    if (handle == FLOOR_SQUIRREL_HANDLE) return &state.floorSquirrel;
+    return PoolGet(state.squirrels, handle);
+}
+
+inline void HandleCollision(GameState& state, EntityHandle squirrelHandle)
+{
+    GameObject* squirrel = GetSquirrel(state, squirrelHandle);
+    if (!squirrel) return;
+
+    state.eggIsHeld = true;
+    state.eggVelocityX = 0;
+    state.eggVelocityY = 0;
+    EggCatchPosition(squirrel->x, squirrel->y, squirrel->spriteWidths[squirrel->currentSprite],
+                     squirrel->isLeftSide, squirrelHandle == FLOOR_SQUIRREL_HANDLE,
+                     state.egg.width, state.egg.height,
+                     state.egg.x, state.egg.y);
+    state.activeSquirrel = squirrelHandle;
+    state.isLaunchingRight = squirrel->isLeftSide;
+
+    // Reset control states
+    state.strengthCharge = 0.0f;
+    state.isCharging = false;
+    state.isDepletingCharge = false;
+    state.angleSquareY = ANGLE_BAR_Y + ANGLE_BAR_HEIGHT - ANGLE_SQUARE_SIZE;
+    state.angleSquareVelocity = 0.0f;
+
+    state.currentEggSprite = 0;  // Reset animation
+    state.eggAnimationTime = 0.0f;
+
+    squirrel->hasEgg = true;
+    squirrel->currentSprite = SPRITE_SQUIRREL_WITH_EGG_1;     // Switch to catching animation
+    squirrel->animationTimer = 0.5f; // Set animation duration to 0.5 seconds
+}
+
+// Takes the float egg position and velocity as the fixed point flight state, for
+// whatever moves the egg other than a flight step: launches, the nest, teleports
+inline void SyncEggFixed(GameState& state)
+{
+    state.eggFixedX = FixedFromFloat(state.egg.x);
+    state.eggFixedY = FixedFromFloat(state.egg.y);
+    state.eggFixedVelocityX = FixedFromFloat(state.eggVelocityX);
+    state.eggFixedVelocityY = FixedFromFloat(state.eggVelocityY);
+}
+
+inline void CopyEggFixedToFloat(GameState& state)
+{
+    state.egg.x = FixedToFloat(state.eggFixedX);
+    state.egg.y = FixedToFloat(state.eggFixedY);
+    state.eggVelocityX = FixedToFloat(state.eggFixedVelocityX);
+    state.eggVelocityY = FixedToFloat(state.eggFixedVelocityY);
+}
+
+// After a miss: floor squirrel holds the egg and the timer stops
+inline void GiveEggToFloorSquirrel(GameState& state)
+{
+    HandleCollision(state, FLOOR_SQUIRREL_HANDLE);
+
+    state.timerActive = false;
+    state.floorSquirrel.currentSprite = 2;
+    state.egg.width = EGG_SIZE_X; // Make egg visible again
+    state.egg.height = EGG_SIZE_Y;
+    state.floorSquirrel.animationTimer = 0.0;
+    state.isFirstFall = 0; // clears after falling the first time
+}
+
+inline void UpdatePhysics(GameState& state)
+{
+    // Skip physics if egg is still in nest
+    if (state.isInNest || state.eggIsHeld) {
+        return;
+    }
+
+    // Tree collisions
+    SimRect leftTreeRect = {
+        static_cast<int>(state.leftTree.x),
+        static_cast<int>(state.leftTree.y),
+        state.leftTree.width,
+        state.leftTree.height
+    };
+
+    SimRect rightTreeRect = {
+        static_cast<int>(state.rightTree.x),
+        static_cast<int>(state.rightTree.y),
+        state.rightTree.width,
+        state.rightTree.height
+    };
+
+    // Gravity, movement and tree bounce, shared with the level solver
+    SimRect eggRect;
+    int treeHit;
+    if (state.fixedPhysics)
+    {
+        treeHit = StepEggFlightFixed(state.eggFixedX, state.eggFixedY,
+                                     state.eggFixedVelocityX, state.eggFixedVelocityY,
+                                     state.egg.width, state.egg.height,
+                                     leftTreeRect, rightTreeRect, eggRect);
+        CopyEggFixedToFloat(state);
+    }
+    else
+        treeHit = StepEggFlight(state.egg.x, state.egg.y,
+                                state.eggVelocityX, state.eggVelocityY,
+                                state.egg.width, state.egg.height,
+                                leftTreeRect, rightTreeRect, eggRect);
+
+    if (treeHit != TREE_HIT_NONE)
+    {
+        SIM_LOG("%s Tree Collision - Adjusting Velocities: VelX=%.2f, VelY=%.2f\n",
+                treeHit == TREE_HIT_LEFT ? "Left" : "Right",
+                state.eggVelocityX, state.eggVelocityY);
+        state.events |= SIM_EVENT_TREE_HIT;
+    }
+
+    // Check collision with squirrels
+    for (int i = 0; i < PoolCount(state.squirrels); i++)
+    {
+        EntityHandle handle = PoolHandleAt(state.squirrels, i);
+        const GameObject& squirrel = *PoolGet(state.squirrels, handle);
+        SimRect squirrelRect = {
+            static_cast<int>(squirrel.x),
+            static_cast<int>(squirrel.y),
+            squirrel.spriteWidths[squirrel.currentSprite],
+            squirrel.spriteHeights[squirrel.currentSprite]
+        };
+
+        if (RectsOverlap(eggRect, squirrelRect) &&
+            state.activeSquirrel != handle &&
+            !state.isFirstFall) // does not check collision on first fall
+        {
+            HandleCollision(state, handle);
+            state.events |= SIM_EVENT_CATCH;
+            SIM_LOG("Egg caught by squirrel!\n");
+            break;
+        }
+    }
+
+    // Reset if egg goes off screen (left, right, or bottom) or hits bottom
+    bool fellOffScreen = state.endless && state.egg.y > state.cameraY + WINDOW_HEIGHT;
+    if (state.egg.y > state.floorBottom - EGG_SIZE_Y || fellOffScreen ||
+        state.egg.x < -state.egg.width ||
+        state.egg.x > WINDOW_WIDTH)
+    {
+        SIM_LOG("Egg missed - giving to floor squirrel\n");
+        GiveEggToFloorSquirrel(state);
+        state.events |= SIM_EVENT_MISS;
+    }
+
+    SimRect floorSquirrelRect = {
+        static_cast<int>(state.floorSquirrel.x),
+        static_cast<int>(state.floorSquirrel.y),
+        state.floorSquirrel.spriteWidths[state.floorSquirrel.currentSprite],
+        state.floorSquirrel.spriteHeights[state.floorSquirrel.currentSprite]
+    };
+
+    if (RectsOverlap(eggRect, floorSquirrelRect) && state.activeSquirrel != FLOOR_SQUIRREL_HANDLE)
+    {
+        HandleCollision(state, FLOOR_SQUIRREL_HANDLE);
+        SIM_LOG("Egg caught by floor squirrel!\n");
+
+        state.floorSquirrel.currentSprite = 2;
+        state.egg.width = EGG_SIZE_X; // Make egg visible again
+        state.egg.height = EGG_SIZE_Y;
+        state.floorSquirrel.animationTimer = 0.0;
+    }
+
+    SimRect nestRect = {
+        static_cast<int>(state.nest.x),
+        static_cast<int>(state.nest.y),
+        state.nest.width,
+        state.nest.height
+    };
+
+    // Check if egg reached the top - win condition (endless mode has no top)
+    if (!state.endless && RectsOverlap(eggRect, nestRect) && state.timerActive)  // Only win once
+    {
+        SIM_LOG("win condition achieved\n");
+        state.timerActive = false;  // Stop the timer
+        state.winAchieved = true;
+        state.winFrames = state.frame - state.timerStartFrame;
+        state.events |= SIM_EVENT_WIN;
+
+        // teleport to floor squirrel
+        state.egg.x = state.floorSquirrel.x +
+            (state.floorSquirrel.spriteWidths[state.floorSquirrel.currentSprite] - state.egg.width) / 2;
+        state.egg.y = state.floorSquirrel.y - state.egg.height;
+        state.eggVelocityX = 0;
+        state.eggVelocityY = 0;
+        state.eggIsHeld = true;
+        state.activeSquirrel = FLOOR_SQUIRREL_HANDLE;
+    }
+}
+
+inline void UpdateControls(GameState& state)
+{
+    // Update strength bar
+    if (state.isCharging && !state.isDepletingCharge)
+    {
+        state.strengthCharge += STRENGTH_CHARGE_RATE;  // Adjust speed as needed
+        if (state.strengthCharge >= 1.0f)
+        {
+            state.strengthCharge = 1.0f;
+            state.isDepletingCharge = true;
+        }
+    }
+    else if (state.isDepletingCharge)
+    {
+        state.strengthCharge -= STRENGTH_CHARGE_RATE;  // Adjust speed as needed
+        if (state.strengthCharge <= 0.0f)
+        {
+            // Instead of dropping the egg, restart the charge cycle
+            state.strengthCharge = 0.0f;
+            state.isDepletingCharge = false;  // Switch back to charging mode
+            // Note: We keep isCharging true to continue the cycle
+        }
+    }
+
+    // Update angle square physics
+    if (state.eggIsHeld)
+    {
+        // Apply gravity to angle square
+        state.angleSquareVelocity += ANGLE_GRAVITY;
+        state.angleSquareY += state.angleSquareVelocity;
+
+        // Constrain to bar bounds
+        float maxY = ANGLE_BAR_Y + ANGLE_BAR_HEIGHT - ANGLE_SQUARE_SIZE;
+        if (state.angleSquareY > maxY)
+        {
+            state.angleSquareY = maxY;
+            state.angleSquareVelocity = 0;
+        }
+        else if (state.angleSquareY < ANGLE_BAR_Y)
+        {
+            state.angleSquareY = ANGLE_BAR_Y;
+            state.angleSquareVelocity = 0;
+        }
+    }
+}
+
+// stepFraction: how far into this step the key went down. The step's UpdateControls
+// adds a whole step of charge, so start below zero by the part that was not held.
+inline void StartStrengthCharge(GameState& state, float stepFraction = 0.0f)
+{
+    if (state.eggIsHeld && !state.isCharging)
+    {
+        state.isCharging = true;
+        state.isDepletingCharge = false;
+        state.strengthCharge = -STRENGTH_CHARGE_RATE * stepFraction;
+    }
+}
+
+// Charge stepFraction of a step after the last UpdateControls, for a release between steps
+inline float ChargeAfter(const GameState& state, float stepFraction)
+{
+    float change = STRENGTH_CHARGE_RATE * stepFraction;
+    float charge = state.isDepletingCharge ? state.strengthCharge - change : state.strengthCharge + change;
+    return charge < 0.0f ? 0.0f : (charge > 1.0f ? 1.0f : charge);
+}
+
+inline void HitAngleSquare(GameState& state)
+{
+    // Jump the angle square with strength based on current charge
+    // float jumpPower = ANGLE_JUMP_POWER * state.strengthCharge;
+    float jumpPower = ANGLE_JUMP_POWER;
+    state.angleSquareVelocity = -jumpPower;
+}
+
+inline void LaunchEgg(GameState& state)
+{
+    if (GameObject* activeSquirrel = GetSquirrel(state, state.activeSquirrel))
+    {
+        activeSquirrel->currentSprite = 0;  // Change back to normal sprite
+    }
+    // Calculate angle (0 at bottom, PI/2 at top)
+    float angle = LaunchAngleFromSquare(state.angleSquareY);
+
+    // Calculate velocities using trigonometry
+    if (state.fixedPhysics)
+    {
+        SyncEggFixed(state);
+        LaunchVelocityFixed(state.strengthCharge, state.angleSquareY, state.isLaunchingRight,
+                            state.eggFixedVelocityX, state.eggFixedVelocityY);
+        CopyEggFixedToFloat(state);
+    }
+    else
+        LaunchVelocity(state.strengthCharge, angle, state.isLaunchingRight,
+                       state.eggVelocityX, state.eggVelocityY);
+
+    // Release the egg
+    state.eggIsHeld = false;
+    state.isCharging = false;
+
+    SIM_LOG("Launch - Power: %.2f, Angle: %.2f degrees, Direction: %s, VelX: %.2f, VelY: %.2f\n",
+            LAUNCH_POWER_SCALE * state.strengthCharge, angle * 180 / PI, state.isLaunchingRight ? "Right" : "Left",
+            state.eggVelocityX, state.eggVelocityY);
+
+    // if timer had not started yet, start it
+    if (!state.timerActive)
+    {
+        state.timerStartFrame = state.frame;
+        state.timerActive = true;
+        state.winAchieved = false;
+        state.events |= SIM_EVENT_RUN_START;
+    }
+    state.currentEggSprite = 0;  // Reset to closed sprite when launching
+    state.events |= SIM_EVENT_LAUNCH;
+}
+
+inline float StepFraction(uint8_t stepTime)
+{
+    return stepTime / 256.0f;
+}
+
+// Acts on one frame of input, in REPLAY_INPUT_* bit order
+inline void ApplyInput(GameState& state, const StepInput& stepInput)
+{
+    uint8_t input = stepInput.bits;
+    if ((input & REPLAY_INPUT_CHARGE) && state.eggIsHeld)
+    {
+        StartStrengthCharge(state, StepFraction(stepInput.chargeTime));
+    }
+    if ((input & REPLAY_INPUT_ANGLE) && state.eggIsHeld)
+    {
+        HitAngleSquare(state);
+    }
+    if ((input & REPLAY_INPUT_FACE_LEFT) && state.eggIsHeld && GetSquirrel(state, state.activeSquirrel))
+    {
+        state.isLaunchingRight = false;
+        GetSquirrel(state, state.activeSquirrel)->isLeftSide = false; // Make active squirrel face left
+    }
+    if ((input & REPLAY_INPUT_FACE_RIGHT) && state.eggIsHeld && GetSquirrel(state, state.activeSquirrel))
+    {
+        state.isLaunchingRight = true;
+        GetSquirrel(state, state.activeSquirrel)->isLeftSide = true; // Make active squirrel face right
+    }
+    if ((input & REPLAY_INPUT_RELEASE) && state.eggIsHeld && state.isCharging)
+    {
+        state.strengthCharge = ChargeAfter(state, StepFraction(stepInput.releaseTime));
+        LaunchEgg(state);
+    }
+    if ((input & (REPLAY_INPUT_RELEASE | REPLAY_INPUT_DROP)) && state.isInNest)
+    {
+        state.isInNest = false;
+        state.eggIsHeld = false;
+        SyncEggFixed(state);
+        SIM_LOG("Egg released from nest\n");
+    }
+    if ((input & REPLAY_INPUT_TELEPORT) && !PoolEmpty(state.squirrels))
+    {
+        // Teleport above the first squirrel
+        const GameObject& squirrel = *PoolGet(state.squirrels, PoolHandleAt(state.squirrels, 0));
+        state.egg.x = squirrel.x + (squirrel.spriteWidths[squirrel.currentSprite] - state.egg.width) / 2;
+        state.egg.y = squirrel.y - state.egg.height - 50; // 50 pixels above
+        state.eggVelocityY = 0;
+        state.eggIsHeld = false;
+        SyncEggFixed(state);
+    }
+}
+
+inline void UpdateEggAnimation(GameState& state, float deltaTime)
+{
+    int oldSprite = state.currentEggSprite;
+
+    if (!state.eggIsHeld)
+    {
+        // When flying/idle, use closed egg sprite
+        state.currentEggSprite = 0;
+        state.eggAnimationTime = 0.0f;
+    }
+    else
+    {
+        // When held, cycle through sprites
+        state.eggAnimationTime += deltaTime;
+        if (state.eggAnimationTime >= EGG_ANIMATION_SPEED)
+        {
+            state.eggAnimationTime = 0.0f;
+            if (state.currentEggSprite != 2)
+                state.currentEggSprite++; // clamps at the third animation
+        }
+    }
+
+    if (oldSprite != state.currentEggSprite) {
+        SIM_LOG("Egg sprite changed from %d to %d (%s)\n",
+                oldSprite,
+                state.currentEggSprite,
+                state.eggIsHeld ? "held" : "not held");
+    }
+}
+
+inline void UpdateSquirrelAnimations(GameState& state, float deltaTime)
+{
+    for (auto& squirrel : state.squirrels)
+    {
+        // handle squirrel with egg
+        if (squirrel.hasEgg && squirrel.animationTimer > 0) {
+            squirrel.currentSprite = SPRITE_SQUIRREL_WITH_EGG_1;
+            squirrel.animationTimer -= deltaTime;
+
+            // Animation finished
+            if (squirrel.animationTimer <= 0) {
+                squirrel.currentSprite = SPRITE_SQUIRREL_TO_LAUNCH_2;  // Return to default sprite
+
+                state.egg.width = EGG_SIZE_X;   // Make egg visible again
+                state.egg.height = EGG_SIZE_Y;
+                squirrel.hasEgg = false;
+            }
+        }
+
+        if (squirrel.currentSprite >= SPRITE_SQUIRREL_TO_LAUNCH_2 && squirrel.currentSprite <= SPRITE_SQUIRREL_TO_LAUNCH_4)
+        {
+            squirrel.animationTimer = 10;
+            // Update animation every 400ms
+            state.squirrelAnimationTime += deltaTime;
+
+            if (state.squirrelAnimationTime >= SQUIRREL_ANIMATION_FRAME) {
+                squirrel.currentSprite++;
+                if (squirrel.currentSprite > SPRITE_SQUIRREL_TO_LAUNCH_4) {
+                    squirrel.currentSprite = SPRITE_SQUIRREL_TO_LAUNCH_2;
+                }
+                state.squirrelAnimationTime = 0;
+            }
+        }
+    }
+}
+
+// One fixed FRAME_TIME step. Check state.events afterwards for what happened.
+inline void StepSimulation(GameState& state, const StepInput& input)
+{
+    const float deltaTime = FRAME_TIME / 1000.0f;
+
+    state.events = 0;
+    ApplyInput(state, input);
+    UpdatePhysics(state);
+    UpdateControls(state);
+    UpdateEggAnimation(state, deltaTime);
+    UpdateSquirrelAnimations(state, deltaTime);
+    state.frame++;
+}
+
+#endif // SIMULATION_H
@@ -0,0 +1,244 @@
+// Batch runner: holds thousands of independent worlds in one array and steps them all on
+// every core, each with its own seed and its own input, from a bot (bot.h) or from a
+// replay file. Worlds are handed out by a work-stealing pool (work_stealing.h), so short
+// runs and long ones share the cores evenly. Reports the aggregate throughput in world
+// steps per second, the number to watch when tuning, evaluating bots or verifying
+// replays in bulk.
+//
+//   batch_runner --worlds 4096 --policy solver --seeds 0:64
+//   batch_runner --worlds 10000 replays/*.rpl
+
+#define SIM_LOG(...) ((void)0)
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "../bot.h"
+#include "../work_stealing.h"
+
+#define BATCH_DEFAULT_STEPS (TARGET_FPS * 60 * 5)  // Per world
+
+struct BatchConfig {
+    int worlds;
+    int threads;
+    int policy;
+    uint32_t firstSeed;
+    uint32_t lastSeed;  // Exclusive, bot world i plays firstSeed + i % count
+    uint32_t steps;
+    bool fixedPhysics;
+    std::vector<const char*> replayPaths;  // When given, world i plays replay i % count instead
+};
+
+// Everything one world needs, so the array is the whole batch
+struct World {
+    GameState state;
+    Bot bot;
+    ReplayPlayer player;
+    bool replayed;   // Input comes from player, not bot
+    uint32_t steps;
+    bool won;
+    bool diverged;
+};
+
+bool ReadWholeFile(const char* path, std::vector<uint8_t>& bytes)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    bytes.clear();
+    uint8_t buffer[4096];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        bytes.insert(bytes.end(), buffer, buffer + count);
+    fclose(file);
+    return true;
+}
+
+// Sets up world index, false if its replay cannot be played
+bool StartWorld(World& world, int index, const BatchConfig& config, const std::vector<std::vector<uint8_t>>& replays,
+                const SquirrelMetrics& metrics)
+{
+    world.steps = 0;
+    world.won = false;
+    world.diverged = false;
+    world.replayed = !replays.empty();
+
+    if (world.replayed)
+    {
+        const std::vector<uint8_t>& bytes = replays[index % replays.size()];
+        world.player = {};
+        OpenByteReader(world.player.reader, bytes.data(), bytes.size());
+        if (!StartReplayPlayback(world.player)) return false;
+        InitSimulation(world.state, world.player.header.seed, metrics);
+        world.state.fixedPhysics = (world.player.header.flags & REPLAY_FLAG_FIXED_PHYSICS) != 0;
+        return true;
+    }
+
+    InitSimulation(world.state, config.firstSeed + static_cast<uint32_t>(index) % (config.lastSeed - config.firstSeed), metrics);
+    world.state.fixedPhysics = config.fixedPhysics;
+    StartBot(world.bot, config.policy, static_cast<uint32_t>(index));
+    return true;
+}
+
+void RunWorld(World& world, uint32_t maxSteps)
+{
+    GameState& state = world.state;
+    while (world.steps < maxSteps && !world.won)
+    {
+        if (world.replayed)
+        {
+            if (world.player.status != REPLAY_PLAYING) break;
+            StepSimulation(state, ReplayInputForFrame(world.player, world.steps));
+            CheckReplayFrame(world.player, world.steps, state.egg.x, state.egg.y, state.eggVelocityX, state.eggVelocityY);
+        }
+        else
+        {
+            StepSimulation(state, BotStepInput(world.bot, state));
+        }
+        world.steps++;
+        world.won = (state.events & SIM_EVENT_WIN) != 0;
+    }
+    world.diverged = world.replayed && world.player.status == REPLAY_DIVERGED;
+}
+
+void PrintUsage()
+{
+    printf("Usage: batch_runner [options] [REPLAY...]\n");
+    printf("  --worlds N              worlds in the batch (default 2048)\n");
+    printf("  --threads N             worker threads (default: all cores)\n");
+    printf("  --steps N               most steps per world (default 5 minutes)\n");
+    printf("  --policy scripted|solver  bot for worlds without a replay (default solver)\n");
+    printf("  --seeds FIRST:LAST      level seeds for bot worlds, LAST exclusive (default the game's seed)\n");
+    printf("  --fixed-physics         bot worlds simulate like --fixed-physics in the game\n");
+    printf("With replay files, world i plays replay i %% count on the replay's seed instead.\n");
+}
+
+bool ParseArgs(int argc, char* argv[], BatchConfig& config)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--", 2) != 0)
+        {
+            config.replayPaths.push_back(arg);
+            continue;
+        }
+        if (strcmp(arg, "--fixed-physics") == 0) { config.fixedPhysics = true; continue; }
+        if (strcmp(arg, "--help") == 0) return false;
+        if (i + 1 >= argc)
+        {
+            printf("Missing value for %s\n", arg);
+            return false;
+        }
+        const char* value = argv[++i];
+
+        if (strcmp(arg, "--worlds") == 0)       config.worlds = atoi(value);
+        else if (strcmp(arg, "--threads") == 0) config.threads = atoi(value);
+        else if (strcmp(arg, "--steps") == 0)   config.steps = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (strcmp(arg, "--policy") == 0)
+        {
+            config.policy = ParseBotPolicy(value);
+            if (config.policy < 0)
+            {
+                printf("Unknown policy %s\n", value);
+                return false;
+            }
+        }
+        else if (strcmp(arg, "--seeds") == 0)
+        {
+            unsigned first, last;
+            if (sscanf(value, "%u:%u", &first, &last) != 2 || last <= first)
+            {
+                printf("--seeds expects FIRST:LAST with LAST > FIRST\n");
+                return false;
+            }
+            config.firstSeed = first;
+            config.lastSeed = last;
+        }
+        else
+        {
+            printf("Unknown option %s\n", arg);
+            return false;
+        }
+    }
+    return config.worlds > 0 && config.steps > 0;
+}
+
+int main(int argc, char* argv[])
+{
+    BatchConfig config = {};
+    config.worlds = 2048;
+    config.threads = static_cast<int>(std::thread::hardware_concurrency());
+    config.policy = BOT_POLICY_SOLVER;
+    config.firstSeed = DEFAULT_LEVEL_SEED;
+    config.lastSeed = DEFAULT_LEVEL_SEED + 1;
+    config.steps = BATCH_DEFAULT_STEPS;
+
+    if (!ParseArgs(argc, argv, config))
+    {
+        PrintUsage();
+        return 1;
+    }
+    if (config.threads < 1) config.threads = 1;
+
+    SquirrelMetrics metrics;
+    if (!LoadSquirrelMetricsFromPng(metrics))
+    {
+        printf("Run from the repository root so assets/ can be found\n");
+        return 1;
+    }
+
+    std::vector<std::vector<uint8_t>> replays(config.replayPaths.size());
+    for (size_t i = 0; i < replays.size(); i++)
+    {
+        if (!ReadWholeFile(config.replayPaths[i], replays[i]))
+        {
+            printf("Cannot read %s\n", config.replayPaths[i]);
+            return 1;
+        }
+    }
+
+    // One allocation for the whole batch, about 45 KB a world
+    std::vector<World> worlds(config.worlds);
+    std::vector<uint8_t> started(config.worlds);
+    uint32_t worldCount = static_cast<uint32_t>(config.worlds);
+
+    auto setUpStart = std::chrono::steady_clock::now();
+    RunWorkStealing(config.threads, worldCount, [&](int, uint32_t index) {
+        started[index] = StartWorld(worlds[index], static_cast<int>(index), config, replays, metrics);
+    });
+    auto runStart = std::chrono::steady_clock::now();
+    uint32_t steals = RunWorkStealing(config.threads, worldCount, [&](int, uint32_t index) {
+        if (started[index]) RunWorld(worlds[index], config.steps);
+    });
+    auto end = std::chrono::steady_clock::now();
+
+    uint64_t steps = 0;
+    uint32_t won = 0, diverged = 0, failed = 0;
+    for (uint32_t i = 0; i < worldCount; i++)
+    {
+        if (!started[i])
+        {
+            failed++;
+            continue;
+        }
+        steps += worlds[i].steps;
+        if (worlds[i].won) won++;
+        if (worlds[i].diverged) diverged++;
+    }
+
+    double setUpSeconds = std::chrono::duration<double>(runStart - setUpStart).count();
+    double seconds = std::chrono::duration<double>(end - runStart).count();
+    if (config.replayPaths.empty())
+        printf("%d worlds of %s bots on seeds %u:%u\n", config.worlds, BotPolicyName(config.policy), config.firstSeed, config.lastSeed);
+    else
+        printf("%d worlds over %zu replays\n", config.worlds, config.replayPaths.size());
+    printf("  %u won, %u diverged, %u could not start\n", won, diverged, failed);
+    printf("  set up in %.2fs, %llu steps in %.2fs on %d threads, %u steals\n", setUpSeconds,
+           static_cast<unsigned long long>(steps), seconds, config.threads, steals);
+    printf("  %.2fM world steps/s (%.2fM per thread)\n", steps / seconds / 1e6, steps / seconds / 1e6 / config.threads);
+    return diverged == 0 && failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,275 @@
+// Bot runner: plays whole runs with bots (bot.h) on every core, each bot in its own
+// headless world, and sends what they do down the paths a player's runs take: replay
+// files, the local scores file and the leaderboard server. A load test with realistic
+// traffic, and a quick way to see how a level plays for good and bad players.
+//
+//   bot_runner --bots 500 --policy solver --seeds 0:50
+//   bot_runner --bots 200 --replays bot-replays --scores bot-scores.bin --leaderboard localhost:8080
+//   bot_runner --bots 200 --seeds 0:50 --min-win-rate 20   (exits 1 if fewer won)
+
+#define SIM_LOG(...) ((void)0)
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../bot.h"
+#include "../background_writer.h"
+#include "../local_scores.h"
+#include "../leaderboard_client.h"
+
+#define BOT_RUNNER_MAX_FRAMES (TARGET_FPS * 60 * 5)  // A bot that has not won in 5 minutes stops
+
+struct BotRunnerConfig {
+    int bots;
+    int threads;
+    int policy;
+    uint32_t firstSeed;
+    uint32_t lastSeed;  // Exclusive, bot i plays firstSeed + i % count
+    uint32_t maxFrames;
+    float minWinRate;   // Percent, below it the run fails
+    bool fixedPhysics;
+    const char* replayDir;
+    const char* scoresPath;
+    const char* leaderboardAddress;
+};
+
+struct BotRun {
+    uint32_t seed;
+    bool won;
+    uint32_t frames;     // Simulated
+    uint32_t runFrames;  // First launch to nest, when won
+    uint32_t launches;
+    uint32_t misses;
+};
+
+struct BotRunnerShared {
+    const BotRunnerConfig* config;
+    SquirrelMetrics metrics;
+    std::atomic<int> nextBot;
+    std::vector<BotRun> runs;  // One per bot, written by whoever ran it
+    BackgroundWriter writer;
+    std::mutex scoresMutex;
+    LocalScores scores;
+    LeaderboardClient leaderboard;
+};
+
+// Scores go through the same append and compaction as the game's, and the leaderboard
+// gets the replay to verify
+void SaveBotScore(BotRunnerShared& shared, uint32_t seed, uint32_t timeMs, const std::vector<uint8_t>& replay)
+{
+    const BotRunnerConfig& config = *shared.config;
+    if (config.scoresPath)
+    {
+        ByteWriter writer;
+        bool replace;
+        {
+            std::lock_guard<std::mutex> lock(shared.scoresMutex);
+            replace = SaveLocalScore(shared.scores, seed, timeMs, writer);
+        }
+        QueueFileWrite(shared.writer, config.scoresPath, std::move(writer.bytes), replace ? WRITE_REPLACE : WRITE_APPEND);
+    }
+    SubmitScore(shared.leaderboard, seed, timeMs, replay);
+}
+
+BotRun RunBot(BotRunnerShared& shared, int index, GameState& state, Bot& bot, ReplayRecorder& recorder)
+{
+    const BotRunnerConfig& config = *shared.config;
+    BotRun run = {};
+    run.seed = config.firstSeed + static_cast<uint32_t>(index) % (config.lastSeed - config.firstSeed);
+
+    InitSimulation(state, run.seed, shared.metrics);
+    state.fixedPhysics = config.fixedPhysics;
+    StartBot(bot, config.policy, static_cast<uint32_t>(index));
+    if (config.replayDir || config.leaderboardAddress) StartReplayRecording(recorder, run.seed, config.fixedPhysics ? REPLAY_FLAG_FIXED_PHYSICS : 0);
+
+    uint32_t frame = 0;
+    for (; frame < config.maxFrames && !run.won; frame++)
+    {
+        StepInput input = BotStepInput(bot, state);
+        StepSimulation(state, input);
+        RecordReplayFrame(recorder, frame, input, state.egg.x, state.egg.y, state.eggVelocityX, state.eggVelocityY);
+
+        if (state.events & SIM_EVENT_LAUNCH) run.launches++;
+        if (state.events & SIM_EVENT_MISS) run.misses++;
+        if (state.events & SIM_EVENT_WIN)
+        {
+            run.won = true;
+            run.runFrames = state.winFrames;
+        }
+    }
+    run.frames = frame;
+
+    if (recorder.active)
+    {
+        FinishReplayRecording(recorder, frame - 1, run.won);
+        if (config.replayDir)
+        {
+            std::string path = std::string(config.replayDir) + "/bot-" + std::to_string(index) + ".rpl";
+            QueueFileWrite(shared.writer, path.c_str(), std::vector<uint8_t>(recorder.writer.bytes), WRITE_REPLACE);
+        }
+    }
+    if (run.won) SaveBotScore(shared, run.seed, FramesToMs(run.runFrames), recorder.writer.bytes);
+    return run;
+}
+
+void BotWorker(BotRunnerShared* shared)
+{
+    std::unique_ptr<GameState> state(new GameState());  // Pools are large, keep them off the stack
+    Bot bot = {};
+    ReplayRecorder recorder = {};
+
+    while (true)
+    {
+        int index = shared->nextBot.fetch_add(1);
+        if (index >= shared->config->bots) break;
+        shared->runs[index] = RunBot(*shared, index, *state, bot, recorder);
+    }
+}
+
+void PrintUsage()
+{
+    printf("Usage: bot_runner [options]\n");
+    printf("  --bots N                runs to play, one bot each (default 100)\n");
+    printf("  --policy scripted|solver  how the bots play (default scripted)\n");
+    printf("  --seeds FIRST:LAST      level seeds, LAST exclusive (default the game's seed)\n");
+    printf("  --threads N             worker threads (default: all cores)\n");
+    printf("  --frames N              give up on a run after N steps (default 5 minutes)\n");
+    printf("  --fixed-physics         simulate like --fixed-physics in the game\n");
+    printf("  --replays DIR           save every run as DIR/bot-N.rpl (DIR must exist)\n");
+    printf("  --scores FILE           add won runs to a local scores file\n");
+    printf("  --leaderboard HOST:PORT submit won runs, as \"bot\"\n");
+    printf("  --min-win-rate P        exit with 1 when fewer than P%% of the runs won\n");
+}
+
+bool ParseArgs(int argc, char* argv[], BotRunnerConfig& config)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        if (strcmp(arg, "--fixed-physics") == 0) { config.fixedPhysics = true; continue; }
+        if (strcmp(arg, "--help") == 0) return false;
+        if (i + 1 >= argc)
+        {
+            printf("Missing value for %s\n", arg);
+            return false;
+        }
+        const char* value = argv[++i];
+
+        if (strcmp(arg, "--bots") == 0)             config.bots = atoi(value);
+        else if (strcmp(arg, "--threads") == 0)     config.threads = atoi(value);
+        else if (strcmp(arg, "--frames") == 0)      config.maxFrames = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (strcmp(arg, "--replays") == 0)     config.replayDir = value;
+        else if (strcmp(arg, "--scores") == 0)      config.scoresPath = value;
+        else if (strcmp(arg, "--leaderboard") == 0) config.leaderboardAddress = value;
+        else if (strcmp(arg, "--min-win-rate") == 0) config.minWinRate = static_cast<float>(atof(value));
+        else if (strcmp(arg, "--policy") == 0)
+        {
+            config.policy = ParseBotPolicy(value);
+            if (config.policy < 0)
+            {
+                printf("Unknown policy %s\n", value);
+                return false;
+            }
+        }
+        else if (strcmp(arg, "--seeds") == 0)
+        {
+            unsigned first, last;
+            if (sscanf(value, "%u:%u", &first, &last) != 2 || last <= first)
+            {
+                printf("--seeds expects FIRST:LAST with LAST > FIRST\n");
+                return false;
+            }
+            config.firstSeed = first;
+            config.lastSeed = last;
+        }
+        else
+        {
+            printf("Unknown option %s\n", arg);
+            return false;
+        }
+    }
+    return config.bots > 0 && config.maxFrames > 0;
+}
+
+int main(int argc, char* argv[])
+{
+    BotRunnerConfig config = {};
+    config.bots = 100;
+    config.threads = static_cast<int>(std::thread::hardware_concurrency());
+    config.policy = BOT_POLICY_SCRIPTED;
+    config.firstSeed = DEFAULT_LEVEL_SEED;
+    config.lastSeed = DEFAULT_LEVEL_SEED + 1;
+    config.maxFrames = BOT_RUNNER_MAX_FRAMES;
+
+    if (!ParseArgs(argc, argv, config))
+    {
+        PrintUsage();
+        return 1;
+    }
+    if (config.threads < 1) config.threads = 1;
+
+    BotRunnerShared shared;
+    shared.config = &config;
+    shared.nextBot = 0;
+    shared.runs.resize(config.bots);
+
+    if (!LoadSquirrelMetricsFromPng(shared.metrics))
+    {
+        printf("Run from the repository root so assets/ can be found\n");
+        return 1;
+    }
+    if (config.scoresPath) LoadLocalScoresFile(shared.scores, config.scoresPath);
+    StartBackgroundWriter(shared.writer);
+    StartLeaderboardClient(shared.leaderboard, config.leaderboardAddress, "bot");
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < config.threads; i++)
+        workers.emplace_back(BotWorker, &shared);
+    for (std::thread& worker : workers)
+        worker.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    StopBackgroundWriter(shared.writer);
+    if (config.leaderboardAddress) StopLeaderboardClient(shared.leaderboard, true);  // Posts the last batches
+
+    uint64_t frames = 0, launches = 0, misses = 0, wonFrames = 0;
+    uint32_t wins = 0, bestFrames = 0;
+    for (const BotRun& run : shared.runs)
+    {
+        frames += run.frames;
+        launches += run.launches;
+        misses += run.misses;
+        if (!run.won) continue;
+        wins++;
+        wonFrames += run.runFrames;
+        if (bestFrames == 0 || run.runFrames < bestFrames) bestFrames = run.runFrames;
+    }
+
+    printf("%d %s bots on seeds %u:%u: %u won (%.1f%%)\n", config.bots, BotPolicyName(config.policy),
+           config.firstSeed, config.lastSeed, wins, 100.0 * wins / config.bots);
+    if (wins > 0)
+        printf("  run time mean %.3fs, best %.3fs\n", FramesToMs(static_cast<uint32_t>(wonFrames / wins)) / 1000.0,
+               FramesToMs(bestFrames) / 1000.0);
+    printf("  %.1f launches and %.1f misses per run\n", static_cast<double>(launches) / config.bots,
+           static_cast<double>(misses) / config.bots);
+    printf("  %llu steps in %.2fs on %d threads (%.0f steps/s)\n", static_cast<unsigned long long>(frames),
+           seconds, config.threads, frames / seconds);
+
+    if (100.0 * wins / config.bots < config.minWinRate)
+    {
+        printf("Win rate below the required %.1f%%\n", config.minWinRate);
+        return 1;
+    }
+    return 0;
+}
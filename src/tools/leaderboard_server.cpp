@@ -0,0 +1,430 @@
+// Leaderboard server: keeps run times per level seed and answers rank queries over HTTP.
+// A score is a replay: the server re-simulates it (replay_verify.h) and ranks the time
+// the simulation reaches the nest in, whatever the client thinks it was. Every accepted
+// score is appended to a log file before it is answered, and the index is rebuilt from
+// that log on startup, so the process can simply be killed. One request per connection,
+// handled in turn, which is plenty for batched submissions.
+// Run from the repository root, the simulation needs the squirrel sprites in assets/.
+//
+//   leaderboard_server --port 8080 --log leaderboard.log
+//
+//   POST /scores              body: one "seed replay name" line per score, replay in base64
+//                             -> {"accepted":2,"ranks":[14,3]}  (rank 0 = rejected: unreadable,
+//                                not verified as a win on that seed, or an hour or slower)
+//   GET  /top?seed=2&n=10     -> {"seed":2,"count":1234,"top":[{"rank":1,"timeMs":40120,"name":"ana"},...]}
+//   GET  /rank?seed=2&timeMs=41234
+//                             -> {"seed":2,"count":1234,"rank":17,"percentile":98.6}
+
+#define SIM_LOG(...) ((void)0)
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../encoding.h"
+#include "../net.h"
+#include "../replay_verify.h"
+#include "../score_index.h"
+
+#define LEADERBOARD_LOG_MAGIC 0x424C4B43u  // "CKLB"
+#define LEADERBOARD_LOG_VERSION 1
+#define LEADERBOARD_NAME_MAX 16
+#define LEADERBOARD_TOP_MAX 100
+#define LEADERBOARD_BATCH_MAX 256  // Scores per POST
+
+struct ScoreEntry {
+    uint32_t seed;
+    uint32_t timeMs;
+    char name[LEADERBOARD_NAME_MAX + 1];
+};
+
+// All runs on one seed
+struct Leaderboard {
+    ScoreIndex index;                         // Ranks and percentiles
+    std::multimap<uint32_t, uint32_t> byTime;  // Time to entry, walked in order for the top list
+};
+
+struct ServerConfig {
+    int port;
+    const char* logPath;
+};
+
+SquirrelMetrics g_Metrics;
+std::unique_ptr<GameState> g_VerifyState;  // Scratch for re-simulating submissions
+std::vector<ScoreEntry> g_Entries;
+std::unordered_map<uint32_t, Leaderboard> g_Boards;
+FILE* g_Log = nullptr;
+
+// Keeps letters, digits, space, '-' and '_', so names never need escaping
+void SanitizeName(const char* name, size_t length, char* out)
+{
+    size_t written = 0;
+    for (size_t i = 0; i < length && written < LEADERBOARD_NAME_MAX; i++)
+    {
+        char c = name[i];
+        bool allowed = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                       c == ' ' || c == '-' || c == '_';
+        if (allowed) out[written++] = c;
+    }
+    if (written == 0)
+    {
+        strcpy(out, "anonymous");
+        return;
+    }
+    out[written] = '\0';
+}
+
+// Returns the rank the entry took on its seed
+uint32_t IndexEntry(uint32_t entryIndex)
+{
+    const ScoreEntry& entry = g_Entries[entryIndex];
+    Leaderboard& board = g_Boards[entry.seed];
+    AddScore(board.index, entry.timeMs);
+    board.byTime.emplace(entry.timeMs, entryIndex);
+    return ScoreRank(board.index, entry.timeMs);
+}
+
+void WriteLogEntry(ByteWriter& writer, const ScoreEntry& entry)
+{
+    size_t nameLength = strlen(entry.name);
+    WriteVarint(writer, entry.seed);
+    WriteVarint(writer, entry.timeMs);
+    WriteByte(writer, static_cast<uint8_t>(nameLength));
+    writer.bytes.insert(writer.bytes.end(), entry.name, entry.name + nameLength);
+}
+
+// Reads every whole entry back. A torn write at the end (crash mid-append) is cut off.
+bool OpenLog(const char* path)
+{
+    std::vector<uint8_t> bytes;
+    FILE* file = fopen(path, "rb");
+    if (file)
+    {
+        uint8_t buffer[65536];
+        size_t count;
+        while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+            bytes.insert(bytes.end(), buffer, buffer + count);
+        fclose(file);
+    }
+
+    size_t goodSize = 0;
+    if (!bytes.empty())
+    {
+        ByteReader reader;
+        OpenByteReader(reader, bytes.data(), bytes.size());
+        uint32_t magic = 0;
+        uint8_t version = 0;
+        if (!ReadU32(reader, magic) || magic != LEADERBOARD_LOG_MAGIC ||
+            !ReadByte(reader, version) || version != LEADERBOARD_LOG_VERSION)
+        {
+            printf("%s is not a version %d leaderboard log\n", path, LEADERBOARD_LOG_VERSION);
+            return false;
+        }
+        goodSize = reader.pos;
+
+        while (reader.pos < reader.size)
+        {
+            ScoreEntry entry = {};
+            uint8_t nameLength = 0;
+            if (!ReadVarint(reader, entry.seed) || !ReadVarint(reader, entry.timeMs) ||
+                !ReadByte(reader, nameLength) || nameLength > LEADERBOARD_NAME_MAX ||
+                reader.pos + nameLength > reader.size)
+                break;
+            memcpy(entry.name, reader.data + reader.pos, nameLength);
+            reader.pos += nameLength;
+
+            g_Entries.push_back(entry);
+            IndexEntry(static_cast<uint32_t>(g_Entries.size() - 1));
+            goodSize = reader.pos;
+        }
+    }
+
+    if (bytes.empty() || goodSize < bytes.size())
+    {
+        // New log, or rewrite the whole entries so appends line up again
+        if (!bytes.empty())
+            printf("Dropping %zu trailing bytes of a partial entry\n", bytes.size() - goodSize);
+
+        ByteWriter header;
+        if (bytes.empty())
+        {
+            WriteU32(header, LEADERBOARD_LOG_MAGIC);
+            WriteByte(header, LEADERBOARD_LOG_VERSION);
+        }
+        else
+        {
+            header.bytes.assign(bytes.begin(), bytes.begin() + goodSize);
+        }
+        file = fopen(path, "wb");
+        if (!file || fwrite(header.bytes.data(), 1, header.bytes.size(), file) != header.bytes.size())
+        {
+            printf("Could not write %s\n", path);
+            if (file) fclose(file);
+            return false;
+        }
+        fclose(file);
+    }
+
+    g_Log = fopen(path, "ab");
+    if (!g_Log)
+    {
+        printf("Could not open %s for appending\n", path);
+        return false;
+    }
+    printf("Loaded %zu scores over %zu seeds from %s\n", g_Entries.size(), g_Boards.size(), path);
+    return true;
+}
+
+// Parses one "seed replay name" line and re-simulates the replay. False unless it is a
+// win on that seed, entry then has the simulation's time.
+bool VerifySubmission(const std::string& text, ScoreEntry& entry)
+{
+    unsigned long seed = 0;
+    int replayStart = 0;
+    if (sscanf(text.c_str(), "%lu %n", &seed, &replayStart) != 1 || replayStart == 0) return false;
+
+    size_t replayEnd = text.find(' ', replayStart);
+    if (replayEnd == std::string::npos) replayEnd = text.size();
+    std::vector<uint8_t> replay = Base64Decode(text.substr(replayStart, replayEnd - replayStart).c_str());
+
+    VerifyResult verdict = VerifyReplay(replay.data(), replay.size(), g_Metrics, *g_VerifyState);
+    uint32_t timeMs = FramesToMs(verdict.runFrames);
+    if (verdict.result != VERIFY_OK || verdict.seed != seed || timeMs == 0 || timeMs >= SCORE_INDEX_MAX_MS)
+    {
+        const char* reason = verdict.result != VERIFY_OK ? VerifyResultName(verdict.result)
+                           : verdict.seed != seed             ? "replay of another seed"
+                                                              : "too slow";
+        printf("Rejected a run on seed %lu: %s\n", seed, reason);
+        return false;
+    }
+
+    entry.seed = static_cast<uint32_t>(seed);
+    entry.timeMs = timeMs;
+    size_t nameStart = replayEnd < text.size() ? replayEnd + 1 : text.size();
+    SanitizeName(text.c_str() + nameStart, text.size() - nameStart, entry.name);
+    return true;
+}
+
+// The batch hits the log in one write before any of it is indexed
+std::string HandleSubmit(const std::string& body)
+{
+    std::vector<ScoreEntry> batch;
+    std::vector<bool> accepted;
+    const char* line = body.c_str();
+    while (*line && batch.size() < LEADERBOARD_BATCH_MAX)
+    {
+        const char* end = strchr(line, '\n');
+        if (!end) end = line + strlen(line);
+
+        std::string text(line, end);
+        ScoreEntry entry = {};
+        bool valid = VerifySubmission(text, entry);
+        batch.push_back(entry);
+        accepted.push_back(valid);
+        line = *end ? end + 1 : end;
+    }
+
+    ByteWriter writer;
+    for (size_t i = 0; i < batch.size(); i++)
+        if (accepted[i]) WriteLogEntry(writer, batch[i]);
+    if (!writer.bytes.empty())
+    {
+        if (fwrite(writer.bytes.data(), 1, writer.bytes.size(), g_Log) != writer.bytes.size() || fflush(g_Log) != 0)
+            return "";  // Nothing indexed, the client will send the batch again
+    }
+
+    std::string json = "{\"accepted\":";
+    std::string ranks;
+    int acceptedCount = 0;
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+        uint32_t rank = 0;
+        if (accepted[i])
+        {
+            g_Entries.push_back(batch[i]);
+            rank = IndexEntry(static_cast<uint32_t>(g_Entries.size() - 1));
+            acceptedCount++;
+        }
+        ranks += (i ? "," : "") + std::to_string(rank);
+    }
+    json += std::to_string(acceptedCount) + ",\"ranks\":[" + ranks + "]}";
+    return json;
+}
+
+std::string HandleTop(const std::string& target)
+{
+    uint32_t seed = static_cast<uint32_t>(HttpQueryValue(target, "seed", 0));
+    long n = HttpQueryValue(target, "n", 10);
+    if (n < 1) n = 1;
+    if (n > LEADERBOARD_TOP_MAX) n = LEADERBOARD_TOP_MAX;
+
+    auto found = g_Boards.find(seed);
+    uint32_t count = found != g_Boards.end() ? found->second.index.count : 0;
+
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "{\"seed\":%u,\"count\":%u,\"top\":[", seed, count);
+    std::string json = buffer;
+    if (found != g_Boards.end())
+    {
+        const Leaderboard& board = found->second;
+        long listed = 0;
+        for (auto it = board.byTime.begin(); it != board.byTime.end() && listed < n; ++it, ++listed)
+        {
+            const ScoreEntry& entry = g_Entries[it->second];
+            snprintf(buffer, sizeof(buffer), "%s{\"rank\":%u,\"timeMs\":%u,\"name\":\"%s\"}",
+                     listed ? "," : "", ScoreRank(board.index, entry.timeMs), entry.timeMs, entry.name);
+            json += buffer;
+        }
+    }
+    return json + "]}";
+}
+
+std::string HandleRank(const std::string& target)
+{
+    uint32_t seed = static_cast<uint32_t>(HttpQueryValue(target, "seed", 0));
+    uint32_t timeMs = ClampScoreTime(static_cast<uint32_t>(HttpQueryValue(target, "timeMs", 0)));
+
+    ScoreIndex empty;
+    auto found = g_Boards.find(seed);
+    const ScoreIndex& index = found != g_Boards.end() ? found->second.index : empty;
+
+    char buffer[160];
+    snprintf(buffer, sizeof(buffer), "{\"seed\":%u,\"count\":%u,\"rank\":%u,\"percentile\":%.1f}",
+             seed, index.count, ScoreRank(index, timeMs), ScorePercentile(index, timeMs));
+    return buffer;
+}
+
+void SendResponse(NetSocket client, int status, const char* reason, const std::string& body)
+{
+    // Open CORS, the web build posts from wherever it is hosted
+    char header[256];
+    int length = snprintf(header, sizeof(header),
+        "HTTP/1.0 %d %s\r\n"
+        "Content-Type: application/json\r\n"
+        "Access-Control-Allow-Origin: *\r\n"
+        "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n"
+        "Access-Control-Allow-Headers: Content-Type\r\n"
+        "Content-Length: %zu\r\n\r\n", status, reason, body.size());
+    NetSendAll(client, header, length);
+    NetSendAll(client, body.data(), body.size());
+}
+
+void HandleClient(NetSocket client)
+{
+    NetSetTimeout(client, NET_TIMEOUT_MS);
+
+    HttpMessage request;
+    if (!NetReadHttp(client, request))
+    {
+        SendResponse(client, 400, "Bad Request", "{\"error\":\"bad request\"}");
+        return;
+    }
+
+    char method[8] = {0}, target[256] = {0};
+    sscanf(request.startLine.c_str(), "%7s %255s", method, target);
+    std::string path = target;
+    path = path.substr(0, path.find('?'));
+
+    if (strcmp(method, "OPTIONS") == 0)
+    {
+        SendResponse(client, 204, "No Content", "");
+    }
+    else if (strcmp(method, "POST") == 0 && path == "/scores")
+    {
+        std::string json = HandleSubmit(request.body);
+        if (json.empty())
+            SendResponse(client, 503, "Service Unavailable", "{\"error\":\"log write failed\"}");
+        else
+            SendResponse(client, 200, "OK", json);
+    }
+    else if (strcmp(method, "GET") == 0 && path == "/top")
+    {
+        SendResponse(client, 200, "OK", HandleTop(target));
+    }
+    else if (strcmp(method, "GET") == 0 && path == "/rank")
+    {
+        SendResponse(client, 200, "OK", HandleRank(target));
+    }
+    else
+    {
+        SendResponse(client, 404, "Not Found", "{\"error\":\"not found\"}");
+    }
+}
+
+void PrintUsage()
+{
+    printf("Usage: leaderboard_server [options]\n");
+    printf("  --port N                port to listen on (default: 8080)\n");
+    printf("  --log FILE              append-only score log (default: leaderboard.log)\n");
+}
+
+bool ParseArgs(int argc, char* argv[], ServerConfig& config)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        if (strcmp(arg, "--help") == 0) return false;
+        if (i + 1 >= argc)
+        {
+            printf("Missing value for %s\n", arg);
+            return false;
+        }
+        const char* value = argv[++i];
+
+        if (strcmp(arg, "--port") == 0)     config.port = atoi(value);
+        else if (strcmp(arg, "--log") == 0) config.logPath = value;
+        else
+        {
+            printf("Unknown option %s\n", arg);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    setvbuf(stdout, nullptr, _IOLBF, 0);  // Logs show up live when redirected
+
+    ServerConfig config = {8080, "leaderboard.log"};
+    if (!ParseArgs(argc, argv, config))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    if (!LoadSquirrelMetricsFromPng(g_Metrics))
+    {
+        printf("Run from the repository root so assets/ can be found\n");
+        return 1;
+    }
+    g_VerifyState.reset(new GameState());  // Pools are large, keep them off the stack
+
+    auto start = std::chrono::steady_clock::now();
+    if (!NetInit() || !OpenLog(config.logPath)) return 1;
+    double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("Index built in %.3fs\n", loadSeconds);
+
+    NetSocket listener = NetListen(config.port);
+    if (listener == NET_INVALID_SOCKET)
+    {
+        printf("Could not listen on port %d\n", config.port);
+        return 1;
+    }
+    printf("Listening on port %d\n", config.port);
+
+    // Runs until killed, every batch is flushed to the log before it is answered
+    while (true)
+    {
+        NetSocket client = accept(listener, nullptr, nullptr);
+        if (client == NET_INVALID_SOCKET) continue;  // A client that gave up before we got to it
+        HandleClient(client);
+        NetClose(client);
+    }
+}
@@ -0,0 +1,362 @@
+// Level fuzzer: generates the levels for a range of seeds on every core, checks each
+// one for solvability and reports branch, gap, hardest jump and par time statistics.
+// Used to tune the branch spacing/extension constants without playing thousands of runs.
+//
+//   level_fuzzer --seeds 0:1000000 --out levels.csv
+//   level_fuzzer --seeds 0:1000000 --min-spacing 80 --max-spacing 280 --out sweep.bin
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../level.h"
+#include "../level_solver.h"
+
+#define FUZZER_CHUNK_SIZE 256
+#define GAP_HISTOGRAM_BUCKETS 16
+
+// Binary output record, little endian, one per seed
+#pragma pack(push, 1)
+struct FuzzRecord {
+    uint32_t seed;
+    uint8_t solvable;
+    uint8_t branchCount;
+    uint16_t minGap;
+    uint16_t maxGap;
+    uint16_t meanGap;
+    uint16_t hardestJumpGap;
+    uint16_t hardestJumpRatio;  // 0..65535 maps to 0..1
+    int32_t parFrames;
+};
+#pragma pack(pop)
+
+enum {
+    OUTPUT_NONE,
+    OUTPUT_CSV,
+    OUTPUT_BINARY
+};
+
+struct FuzzerConfig {
+    uint32_t firstSeed;
+    uint32_t lastSeed;  // Exclusive
+    int threads;
+    bool solve;
+    LevelParams params;
+    LevelSolverOptions solverOptions;
+    const char* outputPath;
+    int outputFormat;
+};
+
+struct FuzzerTotals {
+    uint64_t levels;
+    uint64_t solvable;
+    uint64_t branches;
+    uint64_t parFramesSum;
+    int parFramesMin;
+    int parFramesMax;
+    float hardestJumpRatio;
+    uint32_t hardestJumpSeed;
+    uint64_t gapHistogram[GAP_HISTOGRAM_BUCKETS];
+};
+
+struct FuzzerShared {
+    const FuzzerConfig* config;
+    SquirrelMetrics metrics;
+    std::atomic<uint64_t> nextSeed;
+    std::mutex outputMutex;
+    FILE* output;
+    std::mutex totalsMutex;
+    FuzzerTotals totals;
+};
+
+void ResetTotals(FuzzerTotals& totals)
+{
+    memset(&totals, 0, sizeof(totals));
+    totals.parFramesMin = 0x7fffffff;
+    totals.hardestJumpRatio = 2.0f;
+}
+
+void MergeTotals(FuzzerTotals& into, const FuzzerTotals& from)
+{
+    into.levels += from.levels;
+    into.solvable += from.solvable;
+    into.branches += from.branches;
+    into.parFramesSum += from.parFramesSum;
+    into.parFramesMin = std::min(into.parFramesMin, from.parFramesMin);
+    into.parFramesMax = std::max(into.parFramesMax, from.parFramesMax);
+    if (from.hardestJumpRatio < into.hardestJumpRatio)
+    {
+        into.hardestJumpRatio = from.hardestJumpRatio;
+        into.hardestJumpSeed = from.hardestJumpSeed;
+    }
+    for (int i = 0; i < GAP_HISTOGRAM_BUCKETS; i++)
+        into.gapHistogram[i] += from.gapHistogram[i];
+}
+
+int GapBucket(float gap, const LevelParams& params)
+{
+    float range = params.maxBranchSpacing - params.minBranchSpacing;
+    if (range <= 0) return 0;
+
+    int bucket = static_cast<int>((gap - params.minBranchSpacing) / range * GAP_HISTOGRAM_BUCKETS);
+    return std::max(0, std::min(GAP_HISTOGRAM_BUCKETS - 1, bucket));
+}
+
+uint16_t ClampU16(float value)
+{
+    return static_cast<uint16_t>(std::max(0.0f, std::min(65535.0f, value)));
+}
+
+void FuzzerWorker(FuzzerShared* shared)
+{
+    const FuzzerConfig& config = *shared->config;
+    Level level;
+    FuzzerTotals totals;
+    ResetTotals(totals);
+
+    std::vector<FuzzRecord> records;
+    records.reserve(FUZZER_CHUNK_SIZE);
+    std::vector<char> text;
+    text.reserve(FUZZER_CHUNK_SIZE * 64);
+
+    while (true)
+    {
+        uint64_t begin = shared->nextSeed.fetch_add(FUZZER_CHUNK_SIZE);
+        if (begin >= config.lastSeed) break;
+        uint64_t end = std::min<uint64_t>(begin + FUZZER_CHUNK_SIZE, config.lastSeed);
+
+        records.clear();
+        for (uint64_t seed = begin; seed < end; seed++)
+        {
+            GenerateLevel(static_cast<uint32_t>(seed), config.params, shared->metrics, level);
+
+            LevelStats stats = {};
+            stats.parFrames = -1;
+            if (config.solve)
+                stats = AnalyzeLevel(level, shared->metrics, config.params, config.solverOptions);
+            else
+                ComputeGapStats(level, stats);
+
+            totals.levels++;
+            totals.branches += stats.branchCount;
+            for (size_t i = 1; i < level.branches.size(); i++)
+                totals.gapHistogram[GapBucket(level.branches[i - 1].y - level.branches[i].y, config.params)]++;
+
+            if (stats.solvable)
+            {
+                totals.solvable++;
+                totals.parFramesSum += stats.parFrames;
+                totals.parFramesMin = std::min(totals.parFramesMin, stats.parFrames);
+                totals.parFramesMax = std::max(totals.parFramesMax, stats.parFrames);
+                if (stats.hardestJumpRatio < totals.hardestJumpRatio)
+                {
+                    totals.hardestJumpRatio = stats.hardestJumpRatio;
+                    totals.hardestJumpSeed = static_cast<uint32_t>(seed);
+                }
+            }
+
+            FuzzRecord record = {
+                static_cast<uint32_t>(seed),
+                static_cast<uint8_t>(stats.solvable ? 1 : 0),
+                static_cast<uint8_t>(std::min(stats.branchCount, 255)),
+                ClampU16(stats.minGap),
+                ClampU16(stats.maxGap),
+                ClampU16(stats.meanGap),
+                ClampU16(stats.hardestJumpGap),
+                ClampU16(stats.hardestJumpRatio * 65535.0f),
+                stats.parFrames
+            };
+            records.push_back(record);
+        }
+
+        if (config.outputFormat == OUTPUT_BINARY)
+        {
+            std::lock_guard<std::mutex> lock(shared->outputMutex);
+            fwrite(records.data(), sizeof(FuzzRecord), records.size(), shared->output);
+        }
+        else if (config.outputFormat == OUTPUT_CSV)
+        {
+            text.clear();
+            char line[128];
+            for (const FuzzRecord& r : records)
+            {
+                int length = snprintf(line, sizeof(line), "%u,%d,%d,%d,%d,%d,%d,%.4f,%d\n",
+                                      r.seed, r.solvable, r.branchCount, r.minGap, r.maxGap, r.meanGap,
+                                      r.hardestJumpGap, r.hardestJumpRatio / 65535.0f, r.parFrames);
+                text.insert(text.end(), line, line + length);
+            }
+            std::lock_guard<std::mutex> lock(shared->outputMutex);
+            fwrite(text.data(), 1, text.size(), shared->output);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(shared->totalsMutex);
+    MergeTotals(shared->totals, totals);
+}
+
+void PrintUsage()
+{
+    printf("Usage: level_fuzzer [options]\n");
+    printf("  --seeds FIRST:LAST      seed range, LAST exclusive (default 0:10000)\n");
+    printf("  --threads N             worker threads (default: all cores)\n");
+    printf("  --out FILE              write one record per seed; .csv for text, anything else binary\n");
+    printf("  --no-solve              generation statistics only, skip the launch search\n");
+    printf("  --charges N             charge samples per launch point (default %d)\n", DefaultLevelSolverOptions().chargeSamples);
+    printf("  --angles N              angle samples per launch point (default %d)\n", DefaultLevelSolverOptions().angleSamples);
+    printf("  --min-spacing PX        override MIN_BRANCH_SPACING (default %.1f)\n", MIN_BRANCH_SPACING);
+    printf("  --max-spacing PX        override MAX_BRANCH_SPACING (default %.1f)\n", MAX_BRANCH_SPACING);
+    printf("  --min-extension PX      override MIN_BRANCH_EXTENSION (default %.1f)\n", MIN_BRANCH_EXTENSION);
+    printf("  --max-extension PX      override MAX_BRANCH_EXTENSION (default %.1f)\n", MAX_BRANCH_EXTENSION);
+}
+
+bool ParseArgs(int argc, char* argv[], FuzzerConfig& config)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (strcmp(arg, "--no-solve") == 0) { config.solve = false; continue; }
+        if (strcmp(arg, "--help") == 0) return false;
+        if (!value)
+        {
+            printf("Missing value for %s\n", arg);
+            return false;
+        }
+        i++;
+
+        if (strcmp(arg, "--seeds") == 0)
+        {
+            unsigned first, last;
+            if (sscanf(value, "%u:%u", &first, &last) != 2 || last <= first)
+            {
+                printf("Bad seed range %s\n", value);
+                return false;
+            }
+            config.firstSeed = first;
+            config.lastSeed = last;
+        }
+        else if (strcmp(arg, "--threads") == 0)       config.threads = atoi(value);
+        else if (strcmp(arg, "--out") == 0)           config.outputPath = value;
+        else if (strcmp(arg, "--charges") == 0)       config.solverOptions.chargeSamples = atoi(value);
+        else if (strcmp(arg, "--angles") == 0)        config.solverOptions.angleSamples = atoi(value);
+        else if (strcmp(arg, "--min-spacing") == 0)   config.params.minBranchSpacing = static_cast<float>(atof(value));
+        else if (strcmp(arg, "--max-spacing") == 0)   config.params.maxBranchSpacing = static_cast<float>(atof(value));
+        else if (strcmp(arg, "--min-extension") == 0) config.params.minBranchExtension = static_cast<float>(atof(value));
+        else if (strcmp(arg, "--max-extension") == 0) config.params.maxBranchExtension = static_cast<float>(atof(value));
+        else
+        {
+            printf("Unknown option %s\n", arg);
+            return false;
+        }
+    }
+    if (const char* problem = LevelParamsProblem(config.params))
+    {
+        printf("Bad level params: %s\n", problem);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    FuzzerConfig config = {};
+    config.firstSeed = 0;
+    config.lastSeed = 10000;
+    config.threads = static_cast<int>(std::thread::hardware_concurrency());
+    config.solve = true;
+    config.params = DefaultLevelParams();
+    config.solverOptions = DefaultLevelSolverOptions();
+
+    if (!ParseArgs(argc, argv, config))
+    {
+        PrintUsage();
+        return 1;
+    }
+    if (config.threads < 1) config.threads = 1;
+
+    FuzzerShared shared;
+    shared.config = &config;
+    shared.nextSeed = config.firstSeed;
+    shared.output = nullptr;
+    ResetTotals(shared.totals);
+
+    if (!LoadSquirrelMetricsFromPng(shared.metrics))
+    {
+        printf("Run from the repository root so assets/ can be found\n");
+        return 1;
+    }
+
+    if (config.outputPath)
+    {
+        size_t length = strlen(config.outputPath);
+        bool csv = length > 4 && strcmp(config.outputPath + length - 4, ".csv") == 0;
+        config.outputFormat = csv ? OUTPUT_CSV : OUTPUT_BINARY;
+
+        shared.output = fopen(config.outputPath, csv ? "w" : "wb");
+        if (!shared.output)
+        {
+            printf("Failed to open %s\n", config.outputPath);
+            return 1;
+        }
+        if (csv)
+            fprintf(shared.output, "seed,solvable,branches,min_gap,max_gap,mean_gap,hardest_jump_gap,hardest_jump_ratio,par_frames\n");
+    }
+
+    printf("Fuzzing seeds %u..%u on %d threads (spacing %.1f-%.1f, extension %.1f-%.1f)%s\n",
+           config.firstSeed, config.lastSeed, config.threads,
+           config.params.minBranchSpacing, config.params.maxBranchSpacing,
+           config.params.minBranchExtension, config.params.maxBranchExtension,
+           config.solve ? "" : ", no solve");
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < config.threads; i++)
+        workers.emplace_back(FuzzerWorker, &shared);
+    for (std::thread& worker : workers)
+        worker.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (shared.output) fclose(shared.output);
+
+    const FuzzerTotals& totals = shared.totals;
+    printf("\n%llu levels in %.2fs (%.0f levels/min)\n",
+           (unsigned long long)totals.levels, seconds, totals.levels / std::max(seconds, 1e-9) * 60.0);
+    printf("Mean branches: %.1f\n", totals.levels ? (double)totals.branches / totals.levels : 0.0);
+
+    if (config.solve)
+    {
+        printf("Solvable: %llu (%.2f%%)\n", (unsigned long long)totals.solvable,
+               totals.levels ? 100.0 * totals.solvable / totals.levels : 0.0);
+        if (totals.solvable)
+        {
+            printf("Par time: mean %.2fs, min %.2fs, max %.2fs\n",
+                   (double)totals.parFramesSum / totals.solvable / TARGET_FPS,
+                   (double)totals.parFramesMin / TARGET_FPS,
+                   (double)totals.parFramesMax / TARGET_FPS);
+            printf("Hardest unavoidable jump: %.2f%% of sampled launches land it (seed %u)\n",
+                   totals.hardestJumpRatio * 100.0f, totals.hardestJumpSeed);
+        }
+    }
+
+    uint64_t gapCount = 0;
+    for (int i = 0; i < GAP_HISTOGRAM_BUCKETS; i++) gapCount += totals.gapHistogram[i];
+
+    printf("Gap distribution:\n");
+    float bucketWidth = (config.params.maxBranchSpacing - config.params.minBranchSpacing) / GAP_HISTOGRAM_BUCKETS;
+    for (int i = 0; i < GAP_HISTOGRAM_BUCKETS; i++)
+    {
+        double share = gapCount ? (double)totals.gapHistogram[i] / gapCount : 0.0;
+        printf("  %6.1f-%6.1f px %6.2f%% ", config.params.minBranchSpacing + bucketWidth * i,
+               config.params.minBranchSpacing + bucketWidth * (i + 1), share * 100.0);
+        for (int bar = 0; bar < static_cast<int>(share * 200); bar++) putchar('#');
+        putchar('\n');
+    }
+    return 0;
+}
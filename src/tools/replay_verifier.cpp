@@ -0,0 +1,195 @@
+// Replay verifier: re-runs replay files through the simulation without SDL, as fast
+// as the cores allow, and accepts a run only if the re-simulated egg reaches the nest
+// on the frame the replay says it did. The time reported is the authoritative one,
+// counted in simulation frames rather than taken from the client's clock.
+//
+//   replay_verifier replays/*.rpl
+//   replay_verifier --threads 4 --csv verified.csv submissions/*.rpl
+
+#define SIM_LOG(...) ((void)0)
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../replay_verify.h"
+
+struct VerifierConfig {
+    std::vector<const char*> paths;
+    int threads;
+    int repeat;  // Verify every file this many times, for throughput measurements
+    const char* csvPath;
+};
+
+struct VerifierShared {
+    const VerifierConfig* config;
+    SquirrelMetrics metrics;
+    std::atomic<size_t> nextJob;
+    std::vector<VerifyResult> results;  // One per path, written by whoever verified it
+};
+
+bool ReadWholeFile(const char* path, std::vector<uint8_t>& bytes)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    bytes.clear();
+    uint8_t buffer[4096];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        bytes.insert(bytes.end(), buffer, buffer + count);
+    fclose(file);
+    return true;
+}
+
+void VerifierWorker(VerifierShared* shared)
+{
+    const VerifierConfig& config = *shared->config;
+    size_t jobCount = config.paths.size() * config.repeat;
+    std::unique_ptr<GameState> state(new GameState());  // Pools are large, keep them off the stack
+    std::vector<uint8_t> bytes;
+    bytes.reserve(4096);
+
+    while (true)
+    {
+        size_t job = shared->nextJob.fetch_add(1);
+        if (job >= jobCount) break;
+        size_t index = job % config.paths.size();
+
+        VerifyResult verdict = {};
+        if (ReadWholeFile(config.paths[index], bytes))
+            verdict = VerifyReplay(bytes.data(), bytes.size(), shared->metrics, *state);
+        else
+            verdict.result = VERIFY_BAD_FILE;
+
+        shared->results[index] = verdict;
+    }
+}
+
+void PrintUsage()
+{
+    printf("Usage: replay_verifier [options] FILE...\n");
+    printf("  --threads N             worker threads (default: all cores)\n");
+    printf("  --csv FILE              write one line per replay\n");
+    printf("  --repeat N              verify every file N times, to measure throughput\n");
+}
+
+bool ParseArgs(int argc, char* argv[], VerifierConfig& config)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--", 2) != 0)
+        {
+            config.paths.push_back(arg);
+            continue;
+        }
+        if (strcmp(arg, "--help") == 0) return false;
+        if (i + 1 >= argc)
+        {
+            printf("Missing value for %s\n", arg);
+            return false;
+        }
+        const char* value = argv[++i];
+
+        if (strcmp(arg, "--threads") == 0)     config.threads = atoi(value);
+        else if (strcmp(arg, "--csv") == 0)    config.csvPath = value;
+        else if (strcmp(arg, "--repeat") == 0) config.repeat = atoi(value);
+        else
+        {
+            printf("Unknown option %s\n", arg);
+            return false;
+        }
+    }
+    return !config.paths.empty();
+}
+
+int main(int argc, char* argv[])
+{
+    VerifierConfig config = {};
+    config.threads = static_cast<int>(std::thread::hardware_concurrency());
+    config.repeat = 1;
+
+    if (!ParseArgs(argc, argv, config))
+    {
+        PrintUsage();
+        return 1;
+    }
+    if (config.threads < 1) config.threads = 1;
+    if (config.repeat < 1) config.repeat = 1;
+
+    VerifierShared shared;
+    shared.config = &config;
+    shared.nextJob = 0;
+    shared.results.resize(config.paths.size());
+
+    if (!LoadSquirrelMetricsFromPng(shared.metrics))
+    {
+        printf("Run from the repository root so assets/ can be found\n");
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < config.threads; i++)
+        workers.emplace_back(VerifierWorker, &shared);
+    for (std::thread& worker : workers)
+        worker.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    FILE* csv = nullptr;
+    if (config.csvPath)
+    {
+        csv = fopen(config.csvPath, "w");
+        if (!csv)
+        {
+            printf("Failed to open %s\n", config.csvPath);
+            return 1;
+        }
+        fprintf(csv, "path,result,seed,time_ms,frames,foreign_build\n");
+    }
+
+    int counts[VERIFY_RESULT_COUNT] = {0};
+    uint64_t framesSimulated = 0;
+    for (size_t i = 0; i < config.paths.size(); i++)
+    {
+        const VerifyResult& verdict = shared.results[i];
+        counts[verdict.result]++;
+        framesSimulated += verdict.frames;
+
+        if (verdict.result == VERIFY_OK)
+            printf("%s: ok, %.3fs on seed %u%s\n", config.paths[i], FramesToMs(verdict.runFrames) / 1000.0,
+                   verdict.seed, verdict.foreignBuild ? " (other build)" : "");
+        else if (verdict.result == VERIFY_DIVERGED && verdict.divergedAfter + 1 >= verdict.divergedAt)
+            printf("%s: diverged at frame %u%s\n", config.paths[i], verdict.divergedAt,
+                   verdict.foreignBuild ? " (recorded by another build)" : "");
+        else if (verdict.result == VERIFY_DIVERGED)
+            printf("%s: diverged between frame %u and %u%s\n", config.paths[i], verdict.divergedAfter,
+                   verdict.divergedAt, verdict.foreignBuild ? " (recorded by another build)" : "");
+        else
+            printf("%s: %s\n", config.paths[i], VerifyResultName(verdict.result));
+
+        if (csv)
+            fprintf(csv, "%s,%s,%u,%u,%u,%d\n", config.paths[i], VerifyResultName(verdict.result), verdict.seed,
+                    verdict.result == VERIFY_OK ? FramesToMs(verdict.runFrames) : 0, verdict.frames,
+                    verdict.foreignBuild ? 1 : 0);
+    }
+    if (csv) fclose(csv);
+
+    size_t verified = config.paths.size() * config.repeat;
+    printf("\n%zu replays in %.2fs on %d threads (%.0f replays/s, %.1fM frames/s)\n",
+           verified, seconds, config.threads, verified / std::max(seconds, 1e-9),
+           framesSimulated * config.repeat / std::max(seconds, 1e-9) / 1e6);
+    for (int i = 0; i < VERIFY_RESULT_COUNT; i++)
+        if (counts[i]) printf("  %-11s %d\n", VerifyResultName(i), counts[i]);
+
+    return counts[VERIFY_OK] == static_cast<int>(config.paths.size()) ? 0 : 2;
+}
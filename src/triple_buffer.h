@@ -0,0 +1,48 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+// Hands the latest value from one writer thread to one reader thread without locks.
+// Each side owns a slot and the third sits between them: publishing swaps the writer's
+// slot into the middle, acquiring swaps the middle out if it holds something newer.
+// Neither side ever waits, and the reader always sees a whole value, the latest one.
+
+#include <atomic>
+#include <cstdint>
+
+#define TRIPLE_BUFFER_FRESH 4u  // Middle slot was published since the reader last took it
+
+template <typename T>
+struct TripleBuffer {
+    T slots[3];
+    std::atomic<uint32_t> middle{1};  // Slot index, | TRIPLE_BUFFER_FRESH
+    uint32_t back = 0;   // Writer's slot
+    uint32_t front = 2;  // Reader's slot
+};
+
+// Slot to fill before PublishTripleBuffer, writer thread only
+template <typename T>
+inline T& TripleBufferBack(TripleBuffer<T>& buffer)
+{
+    return buffer.slots[buffer.back];
+}
+
+template <typename T>
+inline void PublishTripleBuffer(TripleBuffer<T>& buffer)
+{
+    uint32_t previous = buffer.middle.exchange(buffer.back | TRIPLE_BUFFER_FRESH, std::memory_order_acq_rel);
+    buffer.back = previous & ~TRIPLE_BUFFER_FRESH;
+}
+
+// Latest published value, reader thread only. Stays valid until the next acquire.
+template <typename T>
+inline const T& AcquireTripleBuffer(TripleBuffer<T>& buffer)
+{
+    if (buffer.middle.load(std::memory_order_relaxed) & TRIPLE_BUFFER_FRESH)
+    {
+        uint32_t previous = buffer.middle.exchange(buffer.front, std::memory_order_acq_rel);
+        buffer.front = previous & ~TRIPLE_BUFFER_FRESH;
+    }
+    return buffer.slots[buffer.front];
+}
+
+#endif // TRIPLE_BUFFER_H
@@ -0,0 +1,172 @@
+#ifndef TUNABLES_H
+#define TUNABLES_H
+
+// Physics and layout values that can be tuned while the game runs. Each one keeps its
+// old macro name (GRAVITY, SQUIRREL_SCALE, ...) so the code using them reads the same.
+//
+// Default build: the macros read g_Tunables, which LoadTunables fills from
+// assets/tunables.cfg ("NAME = value" lines, # comments) and PollTunables reloads
+// whenever the file changes.
+// -DBAKE_TUNABLES: the macros are constexpr defaults and loading does nothing, so
+// release, web and tool builds pay nothing for it.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+#include <sys/stat.h>
+
+#define TUNABLES_FILE "assets/tunables.cfg"
+
+enum {
+    TUNABLE_PHYSICS = 1 << 0,  // Takes effect on the next step
+    TUNABLE_LAYOUT  = 1 << 1   // Needs the level generated again
+};
+
+// X(NAME, field, default, kind)
+#define TUNABLES(X) \
+    X(GRAVITY,              gravity,            0.5f,   TUNABLE_PHYSICS) \
+    X(TERMINAL_VELOCITY,    terminalVelocity,   30.0f,  TUNABLE_PHYSICS) \
+    X(STRENGTH_CHARGE_RATE, strengthChargeRate, 0.03f,  TUNABLE_PHYSICS) \
+    X(ANGLE_GRAVITY,        angleGravity,       0.5f,   TUNABLE_PHYSICS) \
+    X(ANGLE_JUMP_POWER,     angleJumpPower,     6.0f,   TUNABLE_PHYSICS) \
+    X(LAUNCH_POWER_SCALE,   launchPowerScale,   20.0f,  TUNABLE_PHYSICS) \
+    X(MIN_BRANCH_SPACING,   minBranchSpacing,   60.0f,  TUNABLE_LAYOUT)  /* WINDOW_HEIGHT * 0.1 */ \
+    X(MAX_BRANCH_SPACING,   maxBranchSpacing,   300.0f, TUNABLE_LAYOUT)  /* WINDOW_HEIGHT * 0.5 */ \
+    X(MIN_BRANCH_EXTENSION, minBranchExtension, 219.0f, TUNABLE_LAYOUT)  \
+    X(MAX_BRANCH_EXTENSION, maxBranchExtension, 350.0f, TUNABLE_LAYOUT)  \
+    X(SQUIRREL_SCALE,       squirrelScale,      0.6f,   TUNABLE_LAYOUT)  /* 1.0 = original sprite size */
+
+#ifdef BAKE_TUNABLES
+
+struct TunableDefaults {
+#define TUNABLE_CONSTANT(name, field, value, kind) static constexpr float field = value;
+    TUNABLES(TUNABLE_CONSTANT)
+#undef TUNABLE_CONSTANT
+};
+
+#define TUNABLE(field) (TunableDefaults::field)
+
+inline int LoadTunables(const char*) { return 0; }
+inline int PollTunables(const char*) { return 0; }
+inline bool LayoutTunablesAreDefault() { return true; }
+
+#else
+
+struct Tunables {
+#define TUNABLE_FIELD(name, field, value, kind) float field = value;
+    TUNABLES(TUNABLE_FIELD)
+#undef TUNABLE_FIELD
+};
+
+inline Tunables g_Tunables;
+inline time_t g_TunablesModified = 0;
+
+#define TUNABLE(field) (g_Tunables.field)
+
+// Why the layout values cannot build a level, nullptr if they can (see LevelParamsProblem)
+inline const char* LayoutTunablesProblem(const Tunables& tunables)
+{
+    if (!(tunables.minBranchSpacing > 0.0f)) return "branch spacing must be above 0";
+    if (!(tunables.maxBranchSpacing >= tunables.minBranchSpacing)) return "MAX_BRANCH_SPACING is below the min";
+    if (!(tunables.minBranchExtension > 0.0f)) return "branch extension must be above 0";
+    if (!(tunables.maxBranchExtension >= tunables.minBranchExtension)) return "MAX_BRANCH_EXTENSION is below the min";
+    if (!(tunables.squirrelScale > 0.0f)) return "SQUIRREL_SCALE must be above 0";
+    return nullptr;
+}
+
+// Applies every known "NAME = value" line, returns the TUNABLE_* kinds that changed.
+// A file whose layout values cannot build a level is rejected as a whole.
+inline int ParseTunables(const char* text)
+{
+    const Tunables previous = g_Tunables;
+    int changed = 0;
+    char name[64];
+    float value;
+    for (const char* line = text; line; line = strchr(line, '\n'))
+    {
+        if (*line == '\n') line++;
+        if (*line == '#' || sscanf(line, " %63[A-Z_] = %f", name, &value) != 2) continue;
+
+        bool known = false;
+#define TUNABLE_APPLY(tunableName, field, defaultValue, kind)                    \
+        if (strcmp(name, #tunableName) == 0)                                     \
+        {                                                                        \
+            known = true;                                                        \
+            if (g_Tunables.field != value)                                       \
+            {                                                                    \
+                printf("Tunable %s: %g -> %g\n", name, g_Tunables.field, value); \
+                g_Tunables.field = value;                                        \
+                changed |= kind;                                                 \
+            }                                                                    \
+        }
+        TUNABLES(TUNABLE_APPLY)
+#undef TUNABLE_APPLY
+        if (!known) printf("Unknown tunable %s\n", name);
+    }
+    if (const char* problem = LayoutTunablesProblem(g_Tunables))
+    {
+        printf("Tunables rejected, keeping the previous values: %s\n", problem);
+        g_Tunables = previous;
+        return 0;
+    }
+    return changed;
+}
+
+// Replay headers store the physics tunables but not the layout ones, so replays are only
+// recorded and trusted on the default layout
+inline bool LayoutTunablesAreDefault()
+{
+    const Tunables defaults;
+    bool same = true;
+#define TUNABLE_COMPARE(name, field, value, kind) \
+    if ((kind) == TUNABLE_LAYOUT && g_Tunables.field != defaults.field) same = false;
+    TUNABLES(TUNABLE_COMPARE)
+#undef TUNABLE_COMPARE
+    return same;
+}
+
+// Returns the TUNABLE_* kinds that changed, 0 if there is no file
+inline int LoadTunables(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file) return 0;
+
+    std::string text;
+    char buffer[1024];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        text.append(buffer, count);
+    fclose(file);
+
+    struct stat info;
+    if (stat(path, &info) == 0) g_TunablesModified = info.st_mtime;
+    return ParseTunables(text.c_str());
+}
+
+// Reloads path if it changed since the last load, returns the TUNABLE_* kinds that changed.
+// One stat call, cheap enough to run a couple of times a second.
+inline int PollTunables(const char* path)
+{
+    struct stat info;
+    if (stat(path, &info) != 0 || info.st_mtime == g_TunablesModified) return 0;
+    return LoadTunables(path);
+}
+
+#endif
+
+#define GRAVITY              TUNABLE(gravity)
+#define TERMINAL_VELOCITY    TUNABLE(terminalVelocity)
+#define STRENGTH_CHARGE_RATE TUNABLE(strengthChargeRate)
+#define ANGLE_GRAVITY        TUNABLE(angleGravity)
+#define ANGLE_JUMP_POWER     TUNABLE(angleJumpPower)
+#define LAUNCH_POWER_SCALE   TUNABLE(launchPowerScale)
+#define MIN_BRANCH_SPACING   TUNABLE(minBranchSpacing)
+#define MAX_BRANCH_SPACING   TUNABLE(maxBranchSpacing)
+#define MIN_BRANCH_EXTENSION TUNABLE(minBranchExtension)
+#define MAX_BRANCH_EXTENSION TUNABLE(maxBranchExtension)
+#define SQUIRREL_SCALE       TUNABLE(squirrelScale)
+
+#endif // TUNABLES_H
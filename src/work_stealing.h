@@ -0,0 +1,115 @@
+#ifndef WORK_STEALING_H
+#define WORK_STEALING_H
+
+// Runs a job for every index in [0, count) on a set of threads that balance themselves.
+// Each worker starts with an equal slice of the indices, packed as next | end << 32 into
+// one atomic, and takes them from the front one at a time. A worker whose slice is empty
+// steals the back half of the largest slice left. Taking and stealing are a single
+// compare-exchange each, so there are no locks, and jobs of very different lengths (a
+// world that wins in a minute next to one that plays for an hour) still keep every core
+// busy until the end.
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+struct alignas(64) WorkSlice {  // One cache line each, owners and thieves hit them constantly
+    std::atomic<uint64_t> range;
+    uint32_t steals;  // Slices this worker took from others
+};
+
+inline uint64_t PackWorkRange(uint32_t next, uint32_t end)
+{
+    return next | static_cast<uint64_t>(end) << 32;
+}
+
+// Next index of the worker's own slice, false once it is empty
+inline bool TakeWork(WorkSlice& slice, uint32_t& index)
+{
+    uint64_t range = slice.range.load(std::memory_order_relaxed);
+    while (true)
+    {
+        uint32_t next = static_cast<uint32_t>(range), end = static_cast<uint32_t>(range >> 32);
+        if (next >= end) return false;
+        if (slice.range.compare_exchange_weak(range, PackWorkRange(next + 1, end), std::memory_order_acquire))
+        {
+            index = next;
+            return true;
+        }
+    }
+}
+
+// Moves the back half of the largest other slice into the worker's empty one, false when
+// there is nothing left anywhere
+inline bool StealWork(std::vector<WorkSlice>& slices, int worker)
+{
+    while (true)
+    {
+        int victim = -1;
+        uint64_t victimRange = 0;
+        uint32_t most = 0;
+        for (int i = 0; i < static_cast<int>(slices.size()); i++)
+        {
+            if (i == worker) continue;
+            uint64_t range = slices[i].range.load(std::memory_order_relaxed);
+            uint32_t left = static_cast<uint32_t>(range >> 32) - static_cast<uint32_t>(range);
+            if (static_cast<uint32_t>(range) < static_cast<uint32_t>(range >> 32) && left > most)
+            {
+                victim = i;
+                victimRange = range;
+                most = left;
+            }
+        }
+        if (victim < 0) return false;
+
+        uint32_t next = static_cast<uint32_t>(victimRange), end = static_cast<uint32_t>(victimRange >> 32);
+        uint32_t split = end - (end - next + 1) / 2;  // A single index is stolen whole
+        if (slices[victim].range.compare_exchange_strong(victimRange, PackWorkRange(next, split), std::memory_order_acquire))
+        {
+            slices[worker].range.store(PackWorkRange(split, end), std::memory_order_release);
+            slices[worker].steals++;
+            return true;
+        }
+        // Lost a race with the owner or another thief, look again
+    }
+}
+
+// Calls job(worker, index) once per index. Returns the number of steals, to tell how
+// uneven the jobs were.
+template <typename Job>
+inline uint32_t RunWorkStealing(int threads, uint32_t count, Job job)
+{
+    if (threads < 1) threads = 1;
+    std::vector<WorkSlice> slices(threads);
+    for (int i = 0; i < threads; i++)
+    {
+        uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(count) * i / threads);
+        uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(count) * (i + 1) / threads);
+        slices[i].range.store(PackWorkRange(begin, end), std::memory_order_relaxed);
+        slices[i].steals = 0;
+    }
+
+    auto work = [&slices, &job](int worker) {
+        uint32_t index;
+        do
+        {
+            while (TakeWork(slices[worker], index))
+                job(worker, index);
+        } while (StealWork(slices, worker));
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; i++)
+        workers.emplace_back(work, i);
+    work(0);
+    for (std::thread& worker : workers)
+        worker.join();
+
+    uint32_t steals = 0;
+    for (const WorkSlice& slice : slices)
+        steals += slice.steals;
+    return steals;
+}
+
+#endif // WORK_STEALING_H